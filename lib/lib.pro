@@ -7,6 +7,8 @@ INCLUDEPATH += src
 CONFIG      += staticlib
 
 SOURCES += \
+           src/autosave.cpp \
+           src/bvh.cpp \
            src/camera.cpp \
            src/color.cpp \
            src/config.cpp \
@@ -15,6 +17,7 @@ SOURCES += \
            src/distance.cpp \
            src/dynamic/faces.cpp \
            src/dynamic/mesh.cpp \
+           src/dynamic/mesh-delta.cpp \
            src/dynamic/mesh-intersection.cpp \
            src/dynamic/octree.cpp \
            src/history.cpp \
@@ -23,14 +26,17 @@ SOURCES += \
            src/kvstore.cpp \
            src/log.cpp \
            src/mesh.cpp \
+           src/mesh-instances.cpp \
            src/mesh-util.cpp \
            src/mirror.cpp \
            src/opengl.cpp \
            src/opengl-buffer-id.cpp \
+           src/parallel.cpp \
            src/primitive/aabox.cpp \
            src/primitive/cone.cpp \
            src/primitive/cone-sphere.cpp \
            src/primitive/cylinder.cpp \
+           src/primitive/frustum.cpp \
            src/primitive/plane.cpp \
            src/primitive/ray.cpp \
            src/primitive/sphere.cpp \
@@ -103,7 +109,9 @@ SOURCES += \
            src/xml-conversion.cpp \
 
 HEADERS += \
+           src/autosave.hpp \
            src/bitset.hpp \
+           src/bvh.hpp \
            src/cache.hpp \
            src/camera.hpp \
            src/color.hpp \
@@ -113,6 +121,7 @@ HEADERS += \
            src/distance.hpp \
            src/dynamic/faces.hpp \
            src/dynamic/mesh.hpp \
+           src/dynamic/mesh-delta.hpp \
            src/dynamic/mesh-intersection.hpp \
            src/dynamic/octree.hpp \
            src/hash.hpp \
@@ -124,14 +133,17 @@ HEADERS += \
            src/macro.hpp \
            src/maybe.hpp \
            src/mesh.hpp \
+           src/mesh-instances.hpp \
            src/mesh-util.hpp \
            src/mirror.hpp \
            src/opengl.hpp \
            src/opengl-buffer-id.hpp \
+           src/parallel.hpp \
            src/primitive/aabox.hpp \
            src/primitive/cone.hpp \
            src/primitive/cone-sphere.hpp \
            src/primitive/cylinder.hpp \
+           src/primitive/frustum.hpp \
            src/primitive/plane.hpp \
            src/primitive/ray.hpp \
            src/primitive/sphere.hpp \
@@ -0,0 +1,205 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2017 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#include <QByteArray>
+#include <QFile>
+#include <QLockFile>
+#include <QSaveFile>
+#include <atomic>
+#include <functional>
+#include <glm/glm.hpp>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include "autosave.hpp"
+#include "dynamic/mesh.hpp"
+#include "import-export.hpp"
+#include "mesh.hpp"
+#include "scene.hpp"
+#include "sketch/mesh.hpp"
+#include "sketch/path.hpp"
+#include "util.hpp"
+
+namespace
+{
+  struct Snapshot
+  {
+    std::vector<Mesh>                      meshes;
+    std::vector<std::vector<unsigned int>> freeFaceIndices;
+    std::vector<SketchTree>                sketchTrees;
+    std::vector<SketchPaths>               sketchPaths;
+  };
+
+  // drops free faces and all vertices that are not used by a face, cf. `DynamicMesh::prune`
+  Mesh compact (const Mesh& mesh, const std::vector<unsigned int>& freeFaceIndices)
+  {
+    const unsigned int numFaces = mesh.numIndices () / 3;
+
+    std::vector<bool>         isFreeFace (numFaces, false);
+    std::vector<unsigned int> newIndices (mesh.numVertices (), Util::invalidIndex ());
+    Mesh                      compacted;
+
+    for (unsigned int i : freeFaceIndices)
+    {
+      isFreeFace[i] = true;
+    }
+    compacted.reserveIndices (3 * (numFaces - freeFaceIndices.size ()));
+
+    for (unsigned int i = 0; i < numFaces; i++)
+    {
+      if (isFreeFace[i] == false)
+      {
+        for (unsigned int j = 0; j < 3; j++)
+        {
+          const unsigned int index = mesh.index ((3 * i) + j);
+
+          if (newIndices[index] == Util::invalidIndex ())
+          {
+            newIndices[index] = compacted.addVertex (mesh.vertex (index), mesh.normal (index));
+          }
+          compacted.addIndex (newIndices[index]);
+        }
+      }
+    }
+    return compacted;
+  }
+}
+
+struct Autosave::Impl
+{
+  const QString     fileName;
+  QLockFile         lockFile;
+  bool              enabled;
+  std::atomic<bool> saving;
+  std::thread       thread;
+  std::size_t       lastHash;
+
+  Impl (const std::string& f)
+    : fileName (QString::fromStdString (f))
+    , lockFile (this->fileName + ".lock")
+    , saving (false)
+    , lastHash (0)
+  {
+    // a lock is only stale if its process is not running anymore
+    this->lockFile.setStaleLockTime (0);
+    this->enabled = this->lockFile.tryLock (0);
+
+    if (this->enabled == false)
+    {
+      DILAY_WARN ("Autosave is disabled: '%s' is locked by another instance", f.c_str ());
+    }
+  }
+
+  ~Impl () { this->wait (); }
+
+  bool isEnabled () const { return this->enabled; }
+
+  bool isSaving () const { return this->saving; }
+
+  bool hasFile () const { return this->enabled && QFile::exists (this->fileName); }
+
+  void wait ()
+  {
+    if (this->thread.joinable ())
+    {
+      this->thread.join ();
+    }
+  }
+
+  void save (const Scene& scene)
+  {
+    if (this->enabled && this->isSaving () == false)
+    {
+      this->wait ();
+
+      Snapshot snapshot;
+      scene.forEachConstMesh ([&snapshot](const DynamicMesh& mesh) {
+        snapshot.meshes.push_back (mesh.mesh ());
+        snapshot.freeFaceIndices.push_back (mesh.freeFaceIndices ());
+      });
+      scene.forEachConstMesh ([&snapshot](const SketchMesh& mesh) {
+        snapshot.sketchTrees.push_back (mesh.tree ());
+        snapshot.sketchPaths.push_back (mesh.paths ());
+      });
+
+      this->saving = true;
+      this->thread = std::thread ([this, snapshot = std::move (snapshot)]() {
+        this->write (snapshot);
+        this->saving = false;
+      });
+    }
+  }
+
+  void write (const Snapshot& snapshot)
+  {
+    std::ostringstream stream;
+
+    ImportExport::toBinaryDlyHeader (stream);
+
+    for (std::size_t i = 0; i < snapshot.meshes.size (); i++)
+    {
+      ImportExport::toBinaryDlyChunk (stream,
+                                      compact (snapshot.meshes[i], snapshot.freeFaceIndices[i]));
+    }
+    for (std::size_t i = 0; i < snapshot.sketchTrees.size (); i++)
+    {
+      ImportExport::toBinaryDlyChunks (stream, snapshot.sketchTrees[i], snapshot.sketchPaths[i]);
+    }
+
+    const std::string data = stream.str ();
+    const std::size_t hash = std::hash<std::string> () (data);
+
+    if (hash != this->lastHash)
+    {
+      const QByteArray compressed =
+        qCompress (reinterpret_cast<const uchar*> (data.data ()), int(data.size ()), 1);
+      QSaveFile file (this->fileName);
+
+      if (file.open (QIODevice::WriteOnly) && file.write (compressed) == compressed.size () &&
+          file.commit ())
+      {
+        this->lastHash = hash;
+      }
+      else
+      {
+        DILAY_WARN ("Could not write autosave file '%s'", this->fileName.toStdString ().c_str ());
+      }
+    }
+  }
+
+  bool recover (const Config& config, Scene& scene)
+  {
+    assert (this->isSaving () == false);
+
+    QFile file (this->fileName);
+
+    if (this->enabled && file.open (QIODevice::ReadOnly))
+    {
+      const QByteArray data = qUncompress (file.readAll ());
+
+      return data.isEmpty () == false &&
+             ImportExport::fromBinaryDlyFile (data.constData (), std::size_t (data.size ()),
+                                              config, scene);
+    }
+    return false;
+  }
+
+  void remove ()
+  {
+    if (this->enabled)
+    {
+      this->wait ();
+      this->lastHash = 0;
+      QFile::remove (this->fileName);
+    }
+  }
+};
+
+DELEGATE1_BIG2 (Autosave, const std::string&)
+DELEGATE_CONST (bool, Autosave, isEnabled)
+DELEGATE_CONST (bool, Autosave, isSaving)
+DELEGATE_CONST (bool, Autosave, hasFile)
+DELEGATE1 (void, Autosave, save, const Scene&)
+DELEGATE2 (bool, Autosave, recover, const Config&, Scene&)
+DELEGATE (void, Autosave, remove)
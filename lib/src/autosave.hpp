@@ -0,0 +1,35 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2017 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#ifndef DILAY_AUTOSAVE
+#define DILAY_AUTOSAVE
+
+#include <string>
+#include "macro.hpp"
+
+class Config;
+class Scene;
+
+/* Periodically saves a scene to a compressed binary file.  Saving copies the meshes of the scene,
+ * which is cheap as copies share their geometry until either copy is modified (see
+ * `BufferedData` in mesh.cpp).  The copies are compacted, serialized, compressed and written on a
+ * background thread.  A lock file prevents several instances from using the same autosave file.
+ */
+class Autosave
+{
+public:
+  DECLARE_BIG2 (Autosave, const std::string&)
+
+  bool isEnabled () const;
+  bool isSaving () const;
+  bool hasFile () const;
+  void save (const Scene&);
+  bool recover (const Config&, Scene&);
+  void remove ();
+
+private:
+  IMPLEMENTATION
+};
+
+#endif
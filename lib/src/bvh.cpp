@@ -0,0 +1,268 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2017 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#include <algorithm>
+#include <glm/glm.hpp>
+#include <numeric>
+#include <queue>
+#include <vector>
+#include "bvh.hpp"
+#include "intersection.hpp"
+#include "primitive/aabox.hpp"
+#include "primitive/ray.hpp"
+#include "util.hpp"
+
+namespace
+{
+  // the hierarchy is rebuilt if refitting has increased its surface area by this factor
+  constexpr float rebuildFactor = 2.0f;
+
+  struct BvhBox
+  {
+    glm::vec3 minimum;
+    glm::vec3 maximum;
+
+    static BvhBox empty ()
+    {
+      return BvhBox{glm::vec3 (Util::maxFloat ()), glm::vec3 (Util::minFloat ())};
+    }
+
+    bool isEmpty () const { return glm::any (glm::greaterThan (this->minimum, this->maximum)); }
+
+    glm::vec3 center () const { return 0.5f * (this->minimum + this->maximum); }
+
+    float surfaceArea () const
+    {
+      if (this->isEmpty ())
+      {
+        return 0.0f;
+      }
+      const glm::vec3 d = this->maximum - this->minimum;
+      return 2.0f * ((d.x * d.y) + (d.y * d.z) + (d.z * d.x));
+    }
+
+    void extend (const BvhBox& other)
+    {
+      this->minimum = glm::min (this->minimum, other.minimum);
+      this->maximum = glm::max (this->maximum, other.maximum);
+    }
+
+    void extend (const glm::vec3& point)
+    {
+      this->minimum = glm::min (this->minimum, point);
+      this->maximum = glm::max (this->maximum, point);
+    }
+  };
+
+  struct BvhNode
+  {
+    BvhBox       box;
+    unsigned int parent;
+    unsigned int children[2];
+    unsigned int element;
+
+    bool isLeaf () const { return this->element != Util::invalidIndex (); }
+  };
+}
+
+struct Bvh::Impl
+{
+  typedef std::vector<unsigned int>::iterator IndexIterator;
+
+  std::vector<BvhBox>       elements;
+  std::vector<unsigned int> leaves;
+  std::vector<BvhNode>      nodes;
+  unsigned int              root;
+  float                     surfaceArea;
+  float                     builtSurfaceArea;
+  bool                      needsBuild;
+
+  Impl () { this->reset (); }
+
+  unsigned int numElements () const { return this->elements.size (); }
+
+  unsigned int addElement (const glm::vec3& min, const glm::vec3& max)
+  {
+    this->elements.push_back (BvhBox{min, max});
+    this->needsBuild = true;
+    return this->elements.size () - 1;
+  }
+
+  void updateElement (unsigned int index, const glm::vec3& min, const glm::vec3& max)
+  {
+    assert (index < this->elements.size ());
+
+    BvhBox& box = this->elements[index];
+
+    if (box.minimum != min || box.maximum != max)
+    {
+      box.minimum = min;
+      box.maximum = max;
+
+      if (this->needsBuild == false)
+      {
+        this->refit (this->leaves[index]);
+        this->needsBuild = this->surfaceArea > rebuildFactor * this->builtSurfaceArea;
+      }
+    }
+  }
+
+  void refit (unsigned int handle)
+  {
+    while (handle != Util::invalidIndex ())
+    {
+      BvhNode& node = this->nodes[handle];
+
+      this->surfaceArea -= node.box.surfaceArea ();
+
+      if (node.isLeaf ())
+      {
+        node.box = this->elements[node.element];
+      }
+      else
+      {
+        node.box = this->nodes[node.children[0]].box;
+        node.box.extend (this->nodes[node.children[1]].box);
+      }
+      this->surfaceArea += node.box.surfaceArea ();
+      handle = node.parent;
+    }
+  }
+
+  // splits elements at the median of their centers along the axis of the largest extent
+  unsigned int buildNode (IndexIterator begin, IndexIterator end, unsigned int parent)
+  {
+    assert (begin != end);
+
+    const unsigned int handle = this->nodes.size ();
+    this->nodes.push_back (BvhNode{BvhBox::empty (), parent,
+                                   {Util::invalidIndex (), Util::invalidIndex ()},
+                                   Util::invalidIndex ()});
+
+    if (end - begin == 1)
+    {
+      this->nodes[handle].box = this->elements[*begin];
+      this->nodes[handle].element = *begin;
+      this->leaves[*begin] = handle;
+    }
+    else
+    {
+      BvhBox centers = BvhBox::empty ();
+      for (IndexIterator it = begin; it != end; ++it)
+      {
+        centers.extend (this->elements[*it].center ());
+      }
+
+      const glm::vec3     extent = centers.maximum - centers.minimum;
+      const unsigned int  axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2)
+                                                    : (extent.y > extent.z ? 1 : 2);
+      const IndexIterator middle = begin + ((end - begin) / 2);
+
+      std::nth_element (begin, middle, end, [this, axis](unsigned int a, unsigned int b) {
+        return this->elements[a].center ()[axis] < this->elements[b].center ()[axis];
+      });
+
+      const unsigned int child1 = this->buildNode (begin, middle, handle);
+      const unsigned int child2 = this->buildNode (middle, end, handle);
+
+      BvhNode& node = this->nodes[handle];
+      node.children[0] = child1;
+      node.children[1] = child2;
+      node.box = this->nodes[child1].box;
+      node.box.extend (this->nodes[child2].box);
+    }
+    this->surfaceArea += this->nodes[handle].box.surfaceArea ();
+    return handle;
+  }
+
+  void build ()
+  {
+    this->nodes.clear ();
+    this->leaves.assign (this->elements.size (), Util::invalidIndex ());
+    this->root = Util::invalidIndex ();
+    this->surfaceArea = 0.0f;
+
+    if (this->elements.empty () == false)
+    {
+      std::vector<unsigned int> indices (this->elements.size ());
+      std::iota (indices.begin (), indices.end (), 0);
+
+      this->nodes.reserve ((2 * this->elements.size ()) - 1);
+      this->root = this->buildNode (indices.begin (), indices.end (), Util::invalidIndex ());
+    }
+    this->builtSurfaceArea = this->surfaceArea;
+    this->needsBuild = false;
+  }
+
+  void reset ()
+  {
+    this->elements.clear ();
+    this->leaves.clear ();
+    this->nodes.clear ();
+    this->root = Util::invalidIndex ();
+    this->surfaceArea = 0.0f;
+    this->builtSurfaceArea = 0.0f;
+    this->needsBuild = false;
+  }
+
+  bool closestIntersection (const PrimRay& ray, const Bvh::DistanceCallback& f)
+  {
+    typedef std::pair<float, unsigned int> Entry;
+
+    if (this->needsBuild)
+    {
+      this->build ();
+    }
+
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> queue;
+    bool                                                                hasIntersection = false;
+    float                                                               closest = 0.0f;
+
+    const auto enqueue = [this, &ray, &queue](unsigned int handle) {
+      const BvhBox& box = this->nodes[handle].box;
+      float         t;
+
+      if (box.isEmpty () == false &&
+          IntersectionUtil::intersects (ray, PrimAABox (box.minimum, box.maximum), &t))
+      {
+        queue.emplace (t, handle);
+      }
+    };
+
+    if (this->root != Util::invalidIndex ())
+    {
+      enqueue (this->root);
+    }
+
+    while (queue.empty () == false && (hasIntersection == false || queue.top ().first < closest))
+    {
+      const BvhNode& node = this->nodes[queue.top ().second];
+      queue.pop ();
+
+      if (node.isLeaf ())
+      {
+        float t;
+        if (f (node.element, t) && (hasIntersection == false || t < closest))
+        {
+          hasIntersection = true;
+          closest = t;
+        }
+      }
+      else
+      {
+        enqueue (node.children[0]);
+        enqueue (node.children[1]);
+      }
+    }
+    return hasIntersection;
+  }
+};
+
+DELEGATE_BIG6 (Bvh)
+DELEGATE_CONST (unsigned int, Bvh, numElements)
+DELEGATE2 (unsigned int, Bvh, addElement, const glm::vec3&, const glm::vec3&)
+DELEGATE3 (void, Bvh, updateElement, unsigned int, const glm::vec3&, const glm::vec3&)
+DELEGATE (void, Bvh, build)
+DELEGATE (void, Bvh, reset)
+DELEGATE2 (bool, Bvh, closestIntersection, const PrimRay&, const Bvh::DistanceCallback&)
@@ -0,0 +1,42 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2017 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#ifndef DILAY_BVH
+#define DILAY_BVH
+
+#include <functional>
+#include <glm/fwd.hpp>
+#include "macro.hpp"
+
+class PrimRay;
+
+/* A bounding volume hierarchy over axis-aligned boxes, which are referenced by the index that is
+ * returned by `addElement`.  Updating an element refits its ancestors, i.e. moving elements does
+ * not change the topology of the hierarchy.  If refitting has degraded the hierarchy too much,
+ * it is rebuilt by the next query.  Empty boxes (i.e. `minimum > maximum`) are never intersected.
+ */
+class Bvh
+{
+public:
+  DECLARE_BIG6 (Bvh)
+
+  typedef std::function<bool(unsigned int, float&)> DistanceCallback;
+
+  unsigned int numElements () const;
+  unsigned int addElement (const glm::vec3&, const glm::vec3&);
+  void         updateElement (unsigned int, const glm::vec3&, const glm::vec3&);
+  void         build ();
+  void         reset ();
+
+  /* Visits elements in the order in which the ray enters their boxes and stops as soon as no
+   * remaining box can hold an element that is closer than the closest one found so far (cf.
+   * `DynamicOctree::closestIntersection`).
+   */
+  bool closestIntersection (const PrimRay&, const DistanceCallback&);
+
+private:
+  IMPLEMENTATION
+};
+
+#endif
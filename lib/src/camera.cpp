@@ -9,6 +9,7 @@
 #include "config.hpp"
 #include "dimension.hpp"
 #include "opengl.hpp"
+#include "primitive/frustum.hpp"
 #include "primitive/ray.hpp"
 #include "renderer.hpp"
 #include "util.hpp"
@@ -156,6 +157,11 @@ struct Camera::Impl
     return onNearPlane * (this->nearClipping + z) / this->nearClipping;
   }
 
+  PrimFrustum frustum (const glm::mat4x4& model) const
+  {
+    return PrimFrustum (this->projection * this->view * model);
+  }
+
   PrimRay ray (const glm::ivec2& p) const
   {
     const glm::vec3 w = this->toWorld (p);
@@ -228,6 +234,7 @@ DELEGATE1 (void, Camera, horizontalRotation, float)
 DELEGATE3_CONST (glm::vec2, Camera, fromWorld, const glm::vec3&, const glm::mat4x4&, bool)
 DELEGATE2_CONST (glm::vec3, Camera, toWorld, const glm::ivec2&, float)
 DELEGATE2_CONST (float, Camera, toWorld, float, float)
+DELEGATE1_CONST (PrimFrustum, Camera, frustum, const glm::mat4x4&)
 DELEGATE1_CONST (PrimRay, Camera, ray, const glm::ivec2&)
 DELEGATE_CONST (Dimension, Camera, primaryDimension)
 DELEGATE1 (void, Camera, runFromConfig, const Config&)
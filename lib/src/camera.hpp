@@ -10,6 +10,7 @@
 #include "macro.hpp"
 
 enum class Dimension;
+class PrimFrustum;
 class PrimRay;
 class Renderer;
 
@@ -32,16 +33,17 @@ public:
   void updateResolution (const glm::uvec2&);
   void setModelViewProjection (const glm::mat4x4&, const glm::mat3x3&, bool);
 
-  void      set (const glm::vec3&, const glm::vec3&);
-  void      setGaze (const glm::vec3&);
-  void      stepAlongGaze (float);
-  void      verticalRotation (float);
-  void      horizontalRotation (float);
-  glm::vec2 fromWorld (const glm::vec3&, const glm::mat4x4&, bool) const;
-  glm::vec3 toWorld (const glm::ivec2&, float = 0.0f) const;
-  float     toWorld (float, float = 0.0f) const;
-  PrimRay   ray (const glm::ivec2&) const;
-  Dimension primaryDimension () const;
+  void        set (const glm::vec3&, const glm::vec3&);
+  void        setGaze (const glm::vec3&);
+  void        stepAlongGaze (float);
+  void        verticalRotation (float);
+  void        horizontalRotation (float);
+  glm::vec2   fromWorld (const glm::vec3&, const glm::mat4x4&, bool) const;
+  glm::vec3   toWorld (const glm::ivec2&, float = 0.0f) const;
+  float       toWorld (float, float = 0.0f) const;
+  PrimFrustum frustum (const glm::mat4x4&) const;
+  PrimRay     ray (const glm::ivec2&) const;
+  Dimension   primaryDimension () const;
 
 private:
   IMPLEMENTATION
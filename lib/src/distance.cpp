@@ -10,6 +10,17 @@
 #include "primitive/sphere.hpp"
 #include "util.hpp"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define DILAY_DISTANCE_SSE
+#include <emmintrin.h>
+#endif
+
+#if defined(DILAY_DISTANCE_SSE) && (defined(__GNUC__) || defined(__clang__))
+#define DILAY_DISTANCE_AVX2
+#define DILAY_TARGET_AVX2 __attribute__ ((target ("avx2")))
+#include <immintrin.h>
+#endif
+
 namespace
 {
   float distanceToCylinder (const glm::vec3& center1, float radius, float length,
@@ -36,6 +47,258 @@ namespace
       return insideR ? glm::max (-x, glm::max (yr, xl)) : yr;
     }
   }
+
+  // constants of `Distance::distance (const PrimConeSphere&, const glm::vec3&)`
+  struct ConeSphereConstants
+  {
+    enum class Shape
+    {
+      SameRadii,
+      Cone,
+      Sphere
+    };
+
+    Shape     shape;
+    glm::vec3 center;
+    glm::vec3 direction;
+    float     r1;
+    float     r2;
+    float     l;
+    float     s;
+    float     h1;
+    float     lh2;
+    float     r1c;
+    float     r2c;
+    float     sinAlpha;
+    float     cosAlpha;
+
+    ConeSphereConstants (const PrimConeSphere& coneSphere)
+      : shape (coneSphere.sameRadii () ? Shape::SameRadii
+                                       : (coneSphere.hasCone () ? Shape::Cone : Shape::Sphere))
+      , center (coneSphere.sphere1 ().center ())
+      , direction (coneSphere.direction ())
+      , r1 (coneSphere.sphere1 ().radius ())
+      , r2 (coneSphere.sphere2 ().radius ())
+      , l (coneSphere.length ())
+      , s (this->shape == Shape::Cone ? coneSphere.coneSideLength () : 0.0f)
+      , h1 (this->r1 * coneSphere.delta () / this->l)
+      , lh2 (this->l + (this->r2 * coneSphere.delta () / this->l))
+      , r1c (this->r1 * this->s / this->l)
+      , r2c (this->r2 * this->s / this->l)
+      , sinAlpha (coneSphere.sinAlpha ())
+      , cosAlpha (coneSphere.cosAlpha ())
+    {
+    }
+  };
+
+#ifdef DILAY_DISTANCE_SSE
+  __m128 selectSSE (__m128 mask, __m128 a, __m128 b)
+  {
+    return _mm_or_ps (_mm_and_ps (mask, a), _mm_andnot_ps (mask, b));
+  }
+
+  unsigned int distancesSSE (const PrimSphere& sphere, unsigned int n, const float* px,
+                             const float* py, const float* pz, float* result)
+  {
+    const __m128 cx = _mm_set1_ps (sphere.center ().x);
+    const __m128 cy = _mm_set1_ps (sphere.center ().y);
+    const __m128 cz = _mm_set1_ps (sphere.center ().z);
+    const __m128 r = _mm_set1_ps (sphere.radius ());
+
+    unsigned int i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+      const __m128 tx = _mm_sub_ps (_mm_loadu_ps (px + i), cx);
+      const __m128 ty = _mm_sub_ps (_mm_loadu_ps (py + i), cy);
+      const __m128 tz = _mm_sub_ps (_mm_loadu_ps (pz + i), cz);
+      const __m128 lSqr =
+        _mm_add_ps (_mm_add_ps (_mm_mul_ps (tx, tx), _mm_mul_ps (ty, ty)), _mm_mul_ps (tz, tz));
+
+      _mm_storeu_ps (result + i, _mm_sub_ps (_mm_sqrt_ps (lSqr), r));
+    }
+    return i;
+  }
+
+  unsigned int distancesSSE (const ConeSphereConstants& c, unsigned int n, const float* px,
+                             const float* py, const float* pz, float* result)
+  {
+    typedef ConeSphereConstants::Shape Shape;
+
+    const __m128 zero = _mm_setzero_ps ();
+    const __m128 sign = _mm_set1_ps (-0.0f);
+    const __m128 eps = _mm_set1_ps (Util::epsilon ());
+    const __m128 cx = _mm_set1_ps (c.center.x);
+    const __m128 cy = _mm_set1_ps (c.center.y);
+    const __m128 cz = _mm_set1_ps (c.center.z);
+    const __m128 dx = _mm_set1_ps (c.direction.x);
+    const __m128 dy = _mm_set1_ps (c.direction.y);
+    const __m128 dz = _mm_set1_ps (c.direction.z);
+    const __m128 r1 = _mm_set1_ps (c.r1);
+    const __m128 r2 = _mm_set1_ps (c.shape == Shape::SameRadii ? c.r1 : c.r2);
+    const __m128 l = _mm_set1_ps (c.l);
+    const __m128 s = _mm_set1_ps (c.s);
+    const __m128 h1 = _mm_set1_ps (c.h1);
+    const __m128 lh2 = _mm_set1_ps (c.lh2);
+    const __m128 r1c = _mm_set1_ps (c.r1c);
+    const __m128 r2c = _mm_set1_ps (c.r2c);
+    const __m128 sinAlpha = _mm_set1_ps (c.sinAlpha);
+    const __m128 cosAlpha = _mm_set1_ps (c.cosAlpha);
+
+    unsigned int i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+      const __m128 tx = _mm_sub_ps (_mm_loadu_ps (px + i), cx);
+      const __m128 ty = _mm_sub_ps (_mm_loadu_ps (py + i), cy);
+      const __m128 tz = _mm_sub_ps (_mm_loadu_ps (pz + i), cz);
+      const __m128 x =
+        _mm_add_ps (_mm_add_ps (_mm_mul_ps (tx, dx), _mm_mul_ps (ty, dy)), _mm_mul_ps (tz, dz));
+      const __m128 lSqr =
+        _mm_add_ps (_mm_add_ps (_mm_mul_ps (tx, tx), _mm_mul_ps (ty, ty)), _mm_mul_ps (tz, tz));
+      const __m128 ySqr = _mm_sub_ps (lSqr, _mm_mul_ps (x, x));
+      const __m128 y =
+        _mm_andnot_ps (_mm_cmplt_ps (_mm_andnot_ps (sign, ySqr), eps), _mm_sqrt_ps (ySqr));
+      const __m128 xl = _mm_sub_ps (x, l);
+      const __m128 ySqr2 = _mm_mul_ps (y, y);
+      const __m128 d1 = _mm_sub_ps (_mm_sqrt_ps (_mm_add_ps (_mm_mul_ps (x, x), ySqr2)), r1);
+      const __m128 d2 = _mm_sub_ps (_mm_sqrt_ps (_mm_add_ps (_mm_mul_ps (xl, xl), ySqr2)), r2);
+
+      __m128 d = d1;
+      switch (c.shape)
+      {
+        case Shape::SameRadii:
+          d = selectSSE (_mm_cmple_ps (x, zero), d1,
+                         selectSSE (_mm_cmpge_ps (x, l), d2, _mm_sub_ps (y, r1)));
+          break;
+        case Shape::Cone:
+        {
+          const __m128 xh = _mm_sub_ps (x, h1);
+          const __m128 yr = _mm_sub_ps (y, r1c);
+          const __m128 xn = _mm_sub_ps (_mm_mul_ps (xh, cosAlpha), _mm_mul_ps (yr, sinAlpha));
+          const __m128 yn = _mm_add_ps (_mm_mul_ps (xh, sinAlpha), _mm_mul_ps (yr, cosAlpha));
+          const __m128 onCone =
+            selectSSE (_mm_cmple_ps (xn, zero), d1, selectSSE (_mm_cmpge_ps (xn, s), d2, yn));
+          const __m128 onSphere2 = _mm_and_ps (_mm_cmpge_ps (x, lh2), _mm_cmple_ps (y, r2c));
+
+          d = selectSSE (_mm_cmple_ps (x, zero), d1, selectSSE (onSphere2, d2, onCone));
+          break;
+        }
+        case Shape::Sphere:
+          break;
+      }
+      _mm_storeu_ps (result + i, d);
+    }
+    return i;
+  }
+#endif
+
+#ifdef DILAY_DISTANCE_AVX2
+  DILAY_TARGET_AVX2 __m256 selectAVX2 (__m256 mask, __m256 a, __m256 b)
+  {
+    return _mm256_blendv_ps (b, a, mask);
+  }
+
+  DILAY_TARGET_AVX2 unsigned int distancesAVX2 (const PrimSphere& sphere, unsigned int n,
+                                                const float* px, const float* py,
+                                                const float* pz, float* result)
+  {
+    const __m256 cx = _mm256_set1_ps (sphere.center ().x);
+    const __m256 cy = _mm256_set1_ps (sphere.center ().y);
+    const __m256 cz = _mm256_set1_ps (sphere.center ().z);
+    const __m256 r = _mm256_set1_ps (sphere.radius ());
+
+    unsigned int i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+      const __m256 tx = _mm256_sub_ps (_mm256_loadu_ps (px + i), cx);
+      const __m256 ty = _mm256_sub_ps (_mm256_loadu_ps (py + i), cy);
+      const __m256 tz = _mm256_sub_ps (_mm256_loadu_ps (pz + i), cz);
+      const __m256 lSqr = _mm256_add_ps (
+        _mm256_add_ps (_mm256_mul_ps (tx, tx), _mm256_mul_ps (ty, ty)), _mm256_mul_ps (tz, tz));
+
+      _mm256_storeu_ps (result + i, _mm256_sub_ps (_mm256_sqrt_ps (lSqr), r));
+    }
+    return i;
+  }
+
+  DILAY_TARGET_AVX2 unsigned int distancesAVX2 (const ConeSphereConstants& c, unsigned int n,
+                                                const float* px, const float* py,
+                                                const float* pz, float* result)
+  {
+    typedef ConeSphereConstants::Shape Shape;
+
+    const __m256 zero = _mm256_setzero_ps ();
+    const __m256 sign = _mm256_set1_ps (-0.0f);
+    const __m256 eps = _mm256_set1_ps (Util::epsilon ());
+    const __m256 cx = _mm256_set1_ps (c.center.x);
+    const __m256 cy = _mm256_set1_ps (c.center.y);
+    const __m256 cz = _mm256_set1_ps (c.center.z);
+    const __m256 dx = _mm256_set1_ps (c.direction.x);
+    const __m256 dy = _mm256_set1_ps (c.direction.y);
+    const __m256 dz = _mm256_set1_ps (c.direction.z);
+    const __m256 r1 = _mm256_set1_ps (c.r1);
+    const __m256 r2 = _mm256_set1_ps (c.shape == Shape::SameRadii ? c.r1 : c.r2);
+    const __m256 l = _mm256_set1_ps (c.l);
+    const __m256 s = _mm256_set1_ps (c.s);
+    const __m256 h1 = _mm256_set1_ps (c.h1);
+    const __m256 lh2 = _mm256_set1_ps (c.lh2);
+    const __m256 r1c = _mm256_set1_ps (c.r1c);
+    const __m256 r2c = _mm256_set1_ps (c.r2c);
+    const __m256 sinAlpha = _mm256_set1_ps (c.sinAlpha);
+    const __m256 cosAlpha = _mm256_set1_ps (c.cosAlpha);
+
+    unsigned int i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+      const __m256 tx = _mm256_sub_ps (_mm256_loadu_ps (px + i), cx);
+      const __m256 ty = _mm256_sub_ps (_mm256_loadu_ps (py + i), cy);
+      const __m256 tz = _mm256_sub_ps (_mm256_loadu_ps (pz + i), cz);
+      const __m256 x = _mm256_add_ps (
+        _mm256_add_ps (_mm256_mul_ps (tx, dx), _mm256_mul_ps (ty, dy)), _mm256_mul_ps (tz, dz));
+      const __m256 lSqr = _mm256_add_ps (
+        _mm256_add_ps (_mm256_mul_ps (tx, tx), _mm256_mul_ps (ty, ty)), _mm256_mul_ps (tz, tz));
+      const __m256 ySqr = _mm256_sub_ps (lSqr, _mm256_mul_ps (x, x));
+      const __m256 y = _mm256_andnot_ps (
+        _mm256_cmp_ps (_mm256_andnot_ps (sign, ySqr), eps, _CMP_LT_OQ), _mm256_sqrt_ps (ySqr));
+      const __m256 xl = _mm256_sub_ps (x, l);
+      const __m256 ySqr2 = _mm256_mul_ps (y, y);
+      const __m256 d1 =
+        _mm256_sub_ps (_mm256_sqrt_ps (_mm256_add_ps (_mm256_mul_ps (x, x), ySqr2)), r1);
+      const __m256 d2 =
+        _mm256_sub_ps (_mm256_sqrt_ps (_mm256_add_ps (_mm256_mul_ps (xl, xl), ySqr2)), r2);
+
+      __m256 d = d1;
+      switch (c.shape)
+      {
+        case Shape::SameRadii:
+          d = selectAVX2 (_mm256_cmp_ps (x, zero, _CMP_LE_OQ), d1,
+                          selectAVX2 (_mm256_cmp_ps (x, l, _CMP_GE_OQ), d2, _mm256_sub_ps (y, r1)));
+          break;
+        case Shape::Cone:
+        {
+          const __m256 xh = _mm256_sub_ps (x, h1);
+          const __m256 yr = _mm256_sub_ps (y, r1c);
+          const __m256 xn =
+            _mm256_sub_ps (_mm256_mul_ps (xh, cosAlpha), _mm256_mul_ps (yr, sinAlpha));
+          const __m256 yn =
+            _mm256_add_ps (_mm256_mul_ps (xh, sinAlpha), _mm256_mul_ps (yr, cosAlpha));
+          const __m256 onCone =
+            selectAVX2 (_mm256_cmp_ps (xn, zero, _CMP_LE_OQ), d1,
+                        selectAVX2 (_mm256_cmp_ps (xn, s, _CMP_GE_OQ), d2, yn));
+          const __m256 onSphere2 = _mm256_and_ps (_mm256_cmp_ps (x, lh2, _CMP_GE_OQ),
+                                                  _mm256_cmp_ps (y, r2c, _CMP_LE_OQ));
+
+          d = selectAVX2 (_mm256_cmp_ps (x, zero, _CMP_LE_OQ), d1,
+                          selectAVX2 (onSphere2, d2, onCone));
+          break;
+        }
+        case Shape::Sphere:
+          break;
+      }
+      _mm256_storeu_ps (result + i, d);
+    }
+    return i;
+  }
+#endif
 }
 
 float Distance::distance (const PrimSphere& sphere, const glm::vec3& point)
@@ -174,3 +437,88 @@ float Distance::distance (const PrimConeSphere& coneSphere, const glm::vec3& poi
     return glm::sqrt ((x * x) + (y * y)) - r1;
   }
 }
+
+bool Distance::isSupported (Kernel kernel)
+{
+  switch (kernel)
+  {
+    case Kernel::Scalar:
+      return true;
+    case Kernel::SSE:
+#ifdef DILAY_DISTANCE_SSE
+      return true;
+#else
+      return false;
+#endif
+    case Kernel::AVX2:
+#ifdef DILAY_DISTANCE_AVX2
+      return __builtin_cpu_supports ("avx2");
+#else
+      return false;
+#endif
+  }
+  DILAY_IMPOSSIBLE
+}
+
+Distance::Kernel Distance::bestKernel ()
+{
+  static const Kernel kernel = Distance::isSupported (Kernel::AVX2)
+                                 ? Kernel::AVX2
+                                 : (Distance::isSupported (Kernel::SSE) ? Kernel::SSE
+                                                                        : Kernel::Scalar);
+  return kernel;
+}
+
+void Distance::distances (const PrimSphere& sphere, unsigned int n, const float* x,
+                          const float* y, const float* z, float* result, Kernel kernel)
+{
+  assert (Distance::isSupported (kernel));
+
+  unsigned int i = 0;
+  switch (kernel)
+  {
+    case Kernel::Scalar:
+      break;
+    case Kernel::SSE:
+#ifdef DILAY_DISTANCE_SSE
+      i = distancesSSE (sphere, n, x, y, z, result);
+#endif
+      break;
+    case Kernel::AVX2:
+#ifdef DILAY_DISTANCE_AVX2
+      i = distancesAVX2 (sphere, n, x, y, z, result);
+#endif
+      break;
+  }
+  for (; i < n; i++)
+  {
+    result[i] = Distance::distance (sphere, glm::vec3 (x[i], y[i], z[i]));
+  }
+}
+
+void Distance::distances (const PrimConeSphere& coneSphere, unsigned int n, const float* x,
+                          const float* y, const float* z, float* result, Kernel kernel)
+{
+  assert (Distance::isSupported (kernel));
+
+  unsigned int i = 0;
+  switch (kernel)
+  {
+    case Kernel::Scalar:
+      break;
+    case Kernel::SSE:
+#ifdef DILAY_DISTANCE_SSE
+      i = distancesSSE (ConeSphereConstants (coneSphere), n, x, y, z, result);
+#endif
+      break;
+    case Kernel::AVX2:
+#ifdef DILAY_DISTANCE_AVX2
+      i = distancesAVX2 (ConeSphereConstants (coneSphere), n, x, y, z, result);
+#endif
+      break;
+  }
+  for (; i < n; i++)
+  {
+    result[i] = Distance::distance (coneSphere, glm::vec3 (x[i], y[i], z[i]));
+  }
+}
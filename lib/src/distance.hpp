@@ -18,6 +18,25 @@ namespace Distance
   float distance (const PrimCylinder&, const glm::vec3&);
   float distance (const PrimCone&, const glm::vec3&);
   float distance (const PrimConeSphere&, const glm::vec3&);
+
+  /* Batched kernels evaluate a primitive at `n` points whose coordinates are given as separate
+   * arrays.  SIMD kernels process 4 (SSE) or 8 (AVX2) points at once and fall back to the scalar
+   * functions for remaining points.
+   */
+  enum class Kernel
+  {
+    Scalar,
+    SSE,
+    AVX2
+  };
+
+  bool   isSupported (Kernel);
+  Kernel bestKernel ();
+
+  void distances (const PrimSphere&, unsigned int, const float*, const float*, const float*,
+                  float*, Kernel = bestKernel ());
+  void distances (const PrimConeSphere&, unsigned int, const float*, const float*, const float*,
+                  float*, Kernel = bestKernel ());
 }
 
 #endif
@@ -2,39 +2,72 @@
  * Copyright © 2015-2017 Alexander Bau
  * Use and redistribute under the terms of the GNU General Public License
  */
+#include <algorithm>
 #include "dynamic/faces.hpp"
 
-void DynamicFaces::insert (unsigned int i) { this->_uncommitted.insert (i); }
+namespace
+{
+  constexpr unsigned char committedFlag = 1 << 0;
+  constexpr unsigned char uncommittedFlag = 1 << 1;
+}
+
+void DynamicFaces::insert (unsigned int i)
+{
+  if (i >= this->_flags.size ())
+  {
+    this->_flags.resize (std::max (i + 1, 2 * (unsigned int) this->_flags.size ()), 0);
+  }
+  if ((this->_flags[i] & uncommittedFlag) == 0)
+  {
+    this->_flags[i] |= uncommittedFlag;
+    this->_uncommitted.push_back (i);
+  }
+}
 
 void DynamicFaces::insert (const DynamicFaces::Container& v)
 {
-  this->_uncommitted.insert (v.begin (), v.end ());
+  for (unsigned int i : v)
+  {
+    this->insert (i);
+  }
 }
 
 void DynamicFaces::reset ()
 {
   this->resetCommitted ();
+
+  for (unsigned int i : this->_uncommitted)
+  {
+    this->_flags[i] = 0;
+  }
   this->_uncommitted.clear ();
 }
 
-void DynamicFaces::resetCommitted () { this->_indices.clear (); }
-
-void DynamicFaces::commit ()
+void DynamicFaces::resetCommitted ()
 {
-  if (this->_indices.empty ())
+  for (unsigned int i : this->_indices)
   {
-    this->_indices.swap (this->_uncommitted);
+    this->_flags[i] &= ~committedFlag;
   }
-  else
+  this->_indices.clear ();
+}
+
+void DynamicFaces::commit ()
+{
+  for (unsigned int i : this->_uncommitted)
   {
-    this->_indices.insert (this->_uncommitted.begin (), this->_uncommitted.end ());
-    this->_uncommitted.clear ();
+    if ((this->_flags[i] & committedFlag) == 0)
+    {
+      this->_indices.push_back (i);
+    }
+    this->_flags[i] = committedFlag;
   }
+  this->_uncommitted.clear ();
 }
 
 bool DynamicFaces::contains (unsigned int i) const
 {
-  return this->_indices.find (i) != this->_indices.end ();
+  return i < this->_flags.size () && (this->_flags[i] & committedFlag);
 }
 
 bool DynamicFaces::isEmpty () const
@@ -46,26 +79,18 @@ bool DynamicFaces::hasUncomitted () const { return this->_uncommitted.empty () =
 
 void DynamicFaces::filter (const std::function<bool(unsigned int)>& f)
 {
-  for (auto it = this->_indices.begin (); it != this->_indices.end ();)
-  {
-    if (f (*it) == false)
-    {
-      it = this->_indices.erase (it);
-    }
-    else
-    {
-      ++it;
-    }
-  }
-  for (auto it = this->_uncommitted.begin (); it != this->_uncommitted.end ();)
-  {
-    if (f (*it) == false)
-    {
-      it = this->_uncommitted.erase (it);
-    }
-    else
-    {
-      ++it;
-    }
-  }
+  const auto filterContainer = [this, &f](Container& container, unsigned char flag) {
+    container.erase (std::remove_if (container.begin (), container.end (),
+                                     [this, &f, flag](unsigned int i) {
+                                       if (f (i) == false)
+                                       {
+                                         this->_flags[i] &= ~flag;
+                                         return true;
+                                       }
+                                       return false;
+                                     }),
+                     container.end ());
+  };
+  filterContainer (this->_indices, committedFlag);
+  filterContainer (this->_uncommitted, uncommittedFlag);
 }
@@ -6,12 +6,15 @@
 #define DILAY_DYNAMIC_FACES
 
 #include <functional>
-#include <unordered_set>
+#include <vector>
 
+/* Dense set of face indices.  Elements are kept in insertion order, membership is stored as flags
+ * indexed by face, so neither insertion nor lookup requires hashing.
+ */
 class DynamicFaces
 {
 public:
-  typedef std::unordered_set<unsigned int> Container;
+  typedef std::vector<unsigned int> Container;
 
   const Container& indices () const { return this->_indices; }
   const Container& uncommitted () const { return this->_uncommitted; }
@@ -33,8 +36,9 @@ public:
   void filter (const std::function<bool(unsigned int)>&);
 
 private:
-  Container _indices;
-  Container _uncommitted;
+  Container                  _indices;
+  Container                  _uncommitted;
+  std::vector<unsigned char> _flags;
 };
 
 #endif
@@ -0,0 +1,151 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2017 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#include "dynamic/mesh-delta.hpp"
+#include "dynamic/mesh.hpp"
+
+DynamicMeshDelta::DynamicMeshDelta ()
+  : _mesh (nullptr)
+  , _numVertices (0)
+  , _numFaces (0)
+  , _freeVertexIndices ({0, {}})
+  , _freeFaceIndices ({0, {}})
+{
+}
+
+DynamicMeshDelta::~DynamicMeshDelta () { this->stopRecording (); }
+
+bool DynamicMeshDelta::isEmpty () const
+{
+  return this->_vertices.empty () && this->_faces.empty () &&
+         this->_freeVertexIndices.reversedTail.empty () &&
+         this->_freeFaceIndices.reversedTail.empty () && this->hasOriginal () == false;
+}
+
+DynamicMesh& DynamicMeshDelta::mesh () const
+{
+  assert (this->isRecording ());
+  return *this->_mesh;
+}
+
+DynamicMesh& DynamicMeshDelta::original ()
+{
+  assert (this->hasOriginal ());
+  return *this->_original;
+}
+
+void DynamicMeshDelta::startRecording (DynamicMesh& mesh)
+{
+  assert (this->isRecording () == false);
+  mesh.recordDelta (this);
+  assert (this->isRecording ());
+}
+
+void DynamicMeshDelta::stopRecording ()
+{
+  if (this->isRecording ())
+  {
+    this->_mesh->recordDelta (nullptr);
+    assert (this->isRecording () == false);
+  }
+}
+
+void DynamicMeshDelta::begin (DynamicMesh* mesh, unsigned int numVertices, unsigned int numFaces,
+                              unsigned int numFreeVertices, unsigned int numFreeFaces)
+{
+  this->_mesh = mesh;
+  this->_numVertices = numVertices;
+  this->_numFaces = numFaces;
+  this->_vertices.clear ();
+  this->_faces.clear ();
+  this->_recordedVertices.clear ();
+  this->_recordedFaces.clear ();
+  this->_freeVertexIndices = {numFreeVertices, {}};
+  this->_freeFaceIndices = {numFreeFaces, {}};
+  this->_original.reset ();
+}
+
+void DynamicMeshDelta::end ()
+{
+  this->_mesh = nullptr;
+  this->_recordedVertices.clear ();
+  this->_recordedFaces.clear ();
+}
+
+void DynamicMeshDelta::sizes (unsigned int numVertices, unsigned int numFaces)
+{
+  this->_numVertices = numVertices;
+  this->_numFaces = numFaces;
+}
+
+bool DynamicMeshDelta::needsVertex (unsigned int i)
+{
+  return this->hasOriginal () == false && this->_recordedVertices.insert (i).second;
+}
+
+bool DynamicMeshDelta::needsFace (unsigned int i)
+{
+  return this->hasOriginal () == false && this->_recordedFaces.insert (i).second;
+}
+
+void DynamicMeshDelta::addVertex (Vertex&& v) { this->_vertices.push_back (std::move (v)); }
+
+void DynamicMeshDelta::addFace (Face&& f) { this->_faces.push_back (std::move (f)); }
+
+void DynamicMeshDelta::popFreeVertexIndex (const std::vector<unsigned int>& indices)
+{
+  DynamicMeshDelta::popFreeIndex (this->_freeVertexIndices, indices);
+}
+
+void DynamicMeshDelta::popFreeFaceIndex (const std::vector<unsigned int>& indices)
+{
+  DynamicMeshDelta::popFreeIndex (this->_freeFaceIndices, indices);
+}
+
+void DynamicMeshDelta::swapFreeVertexIndices (std::vector<unsigned int>& indices)
+{
+  DynamicMeshDelta::swapFreeIndices (this->_freeVertexIndices, indices);
+}
+
+void DynamicMeshDelta::swapFreeFaceIndices (std::vector<unsigned int>& indices)
+{
+  DynamicMeshDelta::swapFreeIndices (this->_freeFaceIndices, indices);
+}
+
+void DynamicMeshDelta::original (DynamicMesh&& mesh)
+{
+  this->_original = Maybe<DynamicMesh>::make (std::move (mesh));
+  this->_vertices.clear ();
+  this->_faces.clear ();
+  this->_recordedVertices.clear ();
+  this->_recordedFaces.clear ();
+  this->_freeVertexIndices.reversedTail.clear ();
+  this->_freeFaceIndices.reversedTail.clear ();
+}
+
+/* Free indices are stored as a stack.  Indices below `size` are never popped while recording, so
+ * it is sufficient to store all popped indices above this mark.
+ */
+void DynamicMeshDelta::popFreeIndex (FreeIndices& free, const std::vector<unsigned int>& indices)
+{
+  assert (indices.empty () == false);
+  assert (free.size <= indices.size ());
+
+  if (free.size == indices.size ())
+  {
+    free.size--;
+    free.reversedTail.push_back (indices.back ());
+  }
+}
+
+void DynamicMeshDelta::swapFreeIndices (FreeIndices& free, std::vector<unsigned int>& indices)
+{
+  assert (free.size <= indices.size ());
+
+  std::vector<unsigned int> reversedTail (indices.rbegin (), indices.rend () - free.size);
+
+  indices.resize (free.size);
+  indices.insert (indices.end (), free.reversedTail.rbegin (), free.reversedTail.rend ());
+  free.reversedTail = std::move (reversedTail);
+}
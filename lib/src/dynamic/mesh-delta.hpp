@@ -0,0 +1,100 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2017 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#ifndef DILAY_DYNAMIC_MESH_DELTA
+#define DILAY_DYNAMIC_MESH_DELTA
+
+#include <glm/glm.hpp>
+#include <unordered_set>
+#include <vector>
+#include "macro.hpp"
+#include "maybe.hpp"
+
+class DynamicMesh;
+
+/* A delta stores the state of all vertices and faces of a dynamic mesh that have been
+ * modified while recording.  Applying a delta restores the recorded state and turns the delta
+ * into its inverse, i.e. applying it a second time redoes the recorded modifications.
+ * If a modification can not be recorded incrementally (e.g. pruning), the delta keeps a copy of
+ * the original mesh instead.
+ */
+class DynamicMeshDelta
+{
+public:
+  struct Vertex
+  {
+    unsigned int index;
+    bool         isFree;
+    glm::vec3    position;
+    glm::vec3    normal;
+    unsigned int firstCorner;
+    unsigned int lastCorner;
+    unsigned int valence;
+  };
+
+  struct Face
+  {
+    unsigned int index;
+    bool         isFree;
+    unsigned int vertices[3];
+    unsigned int nextCorners[3];
+    unsigned int oppositeCorners[3];
+  };
+
+  DECLARE_BIG2 (DynamicMeshDelta)
+
+  bool isRecording () const { return this->_mesh != nullptr; }
+  bool hasOriginal () const { return bool(this->_original); }
+  bool isEmpty () const;
+
+  DynamicMesh& mesh () const;
+  DynamicMesh& original ();
+
+  unsigned int               numVertices () const { return this->_numVertices; }
+  unsigned int               numFaces () const { return this->_numFaces; }
+  std::vector<Vertex>&       vertices () { return this->_vertices; }
+  const std::vector<Vertex>& vertices () const { return this->_vertices; }
+  std::vector<Face>&         faces () { return this->_faces; }
+  const std::vector<Face>&   faces () const { return this->_faces; }
+
+  void startRecording (DynamicMesh&);
+  void stopRecording ();
+
+  // interface for recording meshes
+  void begin (DynamicMesh*, unsigned int, unsigned int, unsigned int, unsigned int);
+  void end ();
+  void sizes (unsigned int, unsigned int);
+  bool needsVertex (unsigned int);
+  bool needsFace (unsigned int);
+  void addVertex (Vertex&&);
+  void addFace (Face&&);
+  void popFreeVertexIndex (const std::vector<unsigned int>&);
+  void popFreeFaceIndex (const std::vector<unsigned int>&);
+  void swapFreeVertexIndices (std::vector<unsigned int>&);
+  void swapFreeFaceIndices (std::vector<unsigned int>&);
+  void original (DynamicMesh&&);
+
+private:
+  struct FreeIndices
+  {
+    unsigned int              size;
+    std::vector<unsigned int> reversedTail;
+  };
+
+  static void popFreeIndex (FreeIndices&, const std::vector<unsigned int>&);
+  static void swapFreeIndices (FreeIndices&, std::vector<unsigned int>&);
+
+  DynamicMesh*                     _mesh;
+  unsigned int                     _numVertices;
+  unsigned int                     _numFaces;
+  std::vector<Vertex>              _vertices;
+  std::vector<Face>                _faces;
+  std::unordered_set<unsigned int> _recordedVertices;
+  std::unordered_set<unsigned int> _recordedFaces;
+  FreeIndices                      _freeVertexIndices;
+  FreeIndices                      _freeFaceIndices;
+  Maybe<DynamicMesh>               _original;
+};
+
+#endif
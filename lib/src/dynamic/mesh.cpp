@@ -2,18 +2,24 @@
  * Copyright © 2015-2017 Alexander Bau
  * Use and redistribute under the terms of the GNU General Public License
  */
+#include <algorithm>
 #include <cstring>
 #include <glm/glm.hpp>
 #include <glm/gtx/norm.hpp>
 #include <vector>
 #include "../mesh.hpp"
+#include "camera.hpp"
 #include "config.hpp"
 #include "dynamic/faces.hpp"
+#include "dynamic/mesh-delta.hpp"
 #include "dynamic/mesh-intersection.hpp"
 #include "dynamic/mesh.hpp"
 #include "dynamic/octree.hpp"
 #include "intersection.hpp"
 #include "mesh-util.hpp"
+#include "parallel.hpp"
+#include "primitive/aabox.hpp"
+#include "primitive/frustum.hpp"
 #include "primitive/plane.hpp"
 #include "primitive/ray.hpp"
 #include "primitive/triangle.hpp"
@@ -22,40 +28,59 @@
 
 namespace
 {
+  constexpr unsigned int parallelGrainSize = 512;
+  constexpr unsigned int facesPerChunk = 4096;
+
   struct VertexData
   {
-    bool                      isFree;
-    std::vector<unsigned int> adjacentFaces;
+    bool         isFree;
+    unsigned int firstCorner;
+    unsigned int lastCorner;
+    unsigned int valence;
 
     VertexData () { this->reset (); }
     void reset ()
     {
       this->isFree = true;
-      this->adjacentFaces.clear ();
+      this->firstCorner = Util::invalidIndex ();
+      this->lastCorner = Util::invalidIndex ();
+      this->valence = 0;
     }
+  };
 
-    void addAdjacentFace (unsigned int face) { this->adjacentFaces.push_back (face); }
+  unsigned int nextInFace (unsigned int c) { return (c % 3) == 2 ? c - 2 : c + 1; }
 
-    void deleteAdjacentFace (unsigned int face)
-    {
-      for (auto it = this->adjacentFaces.begin (); it != this->adjacentFaces.end (); ++it)
-      {
-        if (*it == face)
-        {
-          this->adjacentFaces.erase (it);
-          return;
-        }
-      }
-      DILAY_IMPOSSIBLE
-    }
-  };
+  unsigned int prevInFace (unsigned int c) { return (c % 3) == 0 ? c + 2 : c - 1; }
 
   struct FaceData
   {
     bool isFree;
+    bool isMisaligned;
 
     FaceData () { this->reset (); }
-    void reset () { this->isFree = true; }
+    void reset ()
+    {
+      this->isFree = true;
+      this->isMisaligned = false;
+    }
+  };
+
+  // Bounding box of a contiguous range of faces that is culled as a whole when rendering
+  struct ChunkData
+  {
+    bool      isOutdated;
+    glm::vec3 minimum;
+    glm::vec3 maximum;
+
+    ChunkData () { this->reset (); }
+    void reset ()
+    {
+      this->isOutdated = false;
+      this->minimum = glm::vec3 (Util::maxFloat ());
+      this->maximum = glm::vec3 (Util::minFloat ());
+    }
+
+    bool isEmpty () const { return glm::any (glm::greaterThan (this->minimum, this->maximum)); }
   };
 }
 
@@ -69,10 +94,22 @@ struct DynamicMesh::Impl
   std::vector<FaceData>      faceData;
   std::vector<unsigned char> faceVisited;
   std::vector<unsigned int>  freeFaceIndices;
+  std::vector<unsigned int>  misalignedFaces;
+  std::vector<ChunkData>     chunkData;
+  std::vector<unsigned int>  outdatedChunks;
+  std::vector<unsigned int>  nextCorners;
+  std::vector<unsigned int>  oppositeCorners;
+  std::vector<unsigned int>  modifiedCorners;
   DynamicOctree              octree;
+  DynamicMeshDelta*          delta;
+  bool                       isBufferDataDeferred;
+  glm::vec3                  minimum;
+  glm::vec3                  maximum;
 
   Impl (DynamicMesh* s, const Mesh& m)
     : self (s)
+    , delta (nullptr)
+    , isBufferDataDeferred (false)
   {
     this->fromMesh (m);
   }
@@ -112,7 +149,15 @@ struct DynamicMesh::Impl
   unsigned int valence (unsigned int i) const
   {
     assert (this->isFreeVertex (i) == false);
-    return this->vertexData[i].adjacentFaces.size ();
+    return this->vertexData[i].valence;
+  }
+
+  unsigned int cornerVertex (unsigned int c) const { return this->mesh.index (c); }
+
+  unsigned int oppositeCorner (unsigned int c) const
+  {
+    assert (this->isFreeFace (c / 3) == false);
+    return this->oppositeCorners[c];
   }
 
   void vertexIndices (unsigned int i, unsigned int& i1, unsigned int& i2, unsigned int& i3) const
@@ -158,40 +203,23 @@ struct DynamicMesh::Impl
     rightFace = Util::invalidIndex ();
     rightVertex = Util::invalidIndex ();
 
-    for (unsigned int a : this->vertexData[e1].adjacentFaces)
+    for (unsigned int c = this->vertexData[e1].firstCorner; c != Util::invalidIndex ();
+         c = this->nextCorners[c])
     {
-      unsigned int i1, i2, i3;
-      this->vertexIndices (a, i1, i2, i3);
-
-      if (e1 == i1 && e2 == i2)
-      {
-        leftFace = a;
-        leftVertex = i3;
-      }
-      else if (e1 == i2 && e2 == i1)
-      {
-        rightFace = a;
-        rightVertex = i3;
-      }
-      else if (e1 == i2 && e2 == i3)
-      {
-        leftFace = a;
-        leftVertex = i1;
-      }
-      else if (e1 == i3 && e2 == i2)
-      {
-        rightFace = a;
-        rightVertex = i1;
-      }
-      else if (e1 == i3 && e2 == i1)
+      if (this->cornerVertex (nextInFace (c)) == e2)
       {
-        leftFace = a;
-        leftVertex = i2;
-      }
-      else if (e1 == i1 && e2 == i3)
-      {
-        rightFace = a;
-        rightVertex = i2;
+        const unsigned int left = prevInFace (c);
+        const unsigned int right = this->oppositeCorners[left];
+
+        leftFace = c / 3;
+        leftVertex = this->cornerVertex (left);
+
+        if (right != Util::invalidIndex ())
+        {
+          rightFace = right / 3;
+          rightVertex = this->cornerVertex (right);
+        }
+        break;
       }
     }
     assert (leftFace != Util::invalidIndex ());
@@ -200,10 +228,11 @@ struct DynamicMesh::Impl
     assert (rightVertex != Util::invalidIndex ());
   }
 
-  const std::vector<unsigned int>& adjacentFaces (unsigned int i) const
+  DynamicMesh::AdjacentFaces adjacentFaces (unsigned int i) const
   {
     assert (this->isFreeVertex (i) == false);
-    return this->vertexData[i].adjacentFaces;
+    return DynamicMesh::AdjacentFaces (this->nextCorners, this->vertexData[i].firstCorner,
+                                       this->vertexData[i].valence);
   }
 
   void forEachVertex (const std::function<void(unsigned int)>& f)
@@ -269,7 +298,7 @@ struct DynamicMesh::Impl
       this->visitVertices (i, [this, &f](unsigned int j) {
         f (j);
 
-        for (unsigned int a : this->vertexData[j].adjacentFaces)
+        for (unsigned int a : this->adjacentFaces (j))
         {
           if (this->faceVisited[a] == 0)
           {
@@ -285,27 +314,11 @@ struct DynamicMesh::Impl
   {
     assert (this->isFreeVertex (i) == false);
 
-    for (unsigned int a : this->vertexData[i].adjacentFaces)
+    for (unsigned int c = this->vertexData[i].firstCorner; c != Util::invalidIndex ();
+         c = this->nextCorners[c])
     {
-      unsigned int a1, a2, a3;
-      this->vertexIndices (a, a1, a2, a3);
-
-      if (i == a1)
-      {
-        f (a2);
-      }
-      else if (i == a2)
-      {
-        f (a3);
-      }
-      else if (i == a3)
-      {
-        f (a1);
-      }
-      else
-      {
-        DILAY_IMPOSSIBLE
-      }
+      assert (this->cornerVertex (c) == i);
+      f (this->cornerVertex (nextInFace (c)));
     }
   }
 
@@ -346,7 +359,7 @@ struct DynamicMesh::Impl
         this->faceVisited[i] = 1;
       }
       this->visitVertices (i, [this, &f](unsigned int j) {
-        for (unsigned int a : this->vertexData[j].adjacentFaces)
+        for (unsigned int a : this->adjacentFaces (j))
         {
           if (this->faceVisited[a] == 0)
           {
@@ -397,13 +410,13 @@ struct DynamicMesh::Impl
   glm::vec3 averagePosition (unsigned int i) const
   {
     assert (this->isFreeVertex (i) == false);
-    assert (this->vertexData[i].adjacentFaces.size () > 0);
+    assert (this->vertexData[i].valence > 0);
 
     glm::vec3 position = glm::vec3 (0.0f);
 
     this->forEachVertexAdjacentToVertex (
       i, [this, &position](unsigned int v) { position += this->mesh.vertex (v); });
-    return position / float(this->vertexData[i].adjacentFaces.size ());
+    return position / float(this->vertexData[i].valence);
   }
 
   glm::vec3 averageNormal (const DynamicFaces& faces) const
@@ -426,11 +439,11 @@ struct DynamicMesh::Impl
   glm::vec3 averageNormal (unsigned int i) const
   {
     assert (this->isFreeVertex (i) == false);
-    assert (this->vertexData[i].adjacentFaces.size () > 0);
+    assert (this->vertexData[i].valence > 0);
 
     glm::vec3 normal = glm::vec3 (0.0f);
 
-    for (unsigned int f : this->vertexData[i].adjacentFaces)
+    for (unsigned int f : this->adjacentFaces (i))
     {
       unsigned int i1, i2, i3;
       this->vertexIndices (f, i1, i2, i3);
@@ -490,14 +503,19 @@ struct DynamicMesh::Impl
 
     if (this->freeVertexIndices.empty ())
     {
+      this->recordVertex (this->vertexData.size ());
       this->vertexData.emplace_back ();
       this->vertexData.back ().isFree = false;
       this->vertexVisited.push_back (0);
+      this->extendMinMax (vertex);
       return this->mesh.addVertex (vertex, normal);
     }
     else
     {
       const unsigned int index = this->freeVertexIndices.back ();
+      this->recordVertex (index);
+      this->recordFreeVertexIndexPop ();
+      this->extendMinMax (vertex);
       this->mesh.vertex (index, vertex);
       this->mesh.normal (index, normal);
       this->vertexData[index].reset ();
@@ -518,11 +536,18 @@ struct DynamicMesh::Impl
 
     unsigned int index = Util::invalidIndex ();
 
+    this->recordVertex (i1);
+    this->recordVertex (i2);
+    this->recordVertex (i3);
+
     if (this->freeFaceIndices.empty ())
     {
       index = this->numFaces ();
+      this->recordFace (index);
       this->faceData.emplace_back ();
       this->faceVisited.push_back (0);
+      this->nextCorners.resize (3 * this->faceData.size (), Util::invalidIndex ());
+      this->oppositeCorners.resize (3 * this->faceData.size (), Util::invalidIndex ());
 
       this->mesh.addIndex (i1);
       this->mesh.addIndex (i2);
@@ -531,6 +556,8 @@ struct DynamicMesh::Impl
     else
     {
       index = this->freeFaceIndices.back ();
+      this->recordFace (index);
+      this->recordFreeFaceIndexPop ();
       this->faceData[index].reset ();
       this->faceVisited[index] = 0;
       this->freeFaceIndices.pop_back ();
@@ -541,20 +568,113 @@ struct DynamicMesh::Impl
     }
     this->faceData[index].isFree = false;
 
-    this->vertexData[i1].addAdjacentFace (index);
-    this->vertexData[i2].addAdjacentFace (index);
-    this->vertexData[i3].addAdjacentFace (index);
+    this->addCorner (i1, (3 * index) + 0);
+    this->addCorner (i2, (3 * index) + 1);
+    this->addCorner (i3, (3 * index) + 2);
+
+    this->connectOppositeCorner ((3 * index) + 0);
+    this->connectOppositeCorner ((3 * index) + 1);
+    this->connectOppositeCorner ((3 * index) + 2);
 
     this->addFaceToOctree (index);
 
     return index;
   }
 
+  void addCorner (unsigned int v, unsigned int c)
+  {
+    VertexData& data = this->vertexData[v];
+
+    if (data.lastCorner == Util::invalidIndex ())
+    {
+      data.firstCorner = c;
+    }
+    else
+    {
+      this->recordFace (data.lastCorner / 3);
+      this->nextCorners[data.lastCorner] = c;
+    }
+    this->nextCorners[c] = Util::invalidIndex ();
+    data.lastCorner = c;
+    data.valence++;
+  }
+
+  void deleteCorner (unsigned int v, unsigned int c)
+  {
+    VertexData&  data = this->vertexData[v];
+    unsigned int prev = Util::invalidIndex ();
+
+    for (unsigned int it = data.firstCorner; it != Util::invalidIndex ();
+         it = this->nextCorners[it])
+    {
+      if (it == c)
+      {
+        if (prev == Util::invalidIndex ())
+        {
+          data.firstCorner = this->nextCorners[c];
+        }
+        else
+        {
+          this->recordFace (prev / 3);
+          this->nextCorners[prev] = this->nextCorners[c];
+        }
+        if (data.lastCorner == c)
+        {
+          data.lastCorner = prev;
+        }
+        this->nextCorners[c] = Util::invalidIndex ();
+        data.valence--;
+        return;
+      }
+      prev = it;
+    }
+    DILAY_IMPOSSIBLE
+  }
+
+  // Connects corner `c` with the unconnected corner on the other side of its opposite edge
+  void connectOppositeCorner (unsigned int c)
+  {
+    const unsigned int from = this->cornerVertex (nextInFace (c));
+    const unsigned int to = this->cornerVertex (prevInFace (c));
+
+    this->oppositeCorners[c] = Util::invalidIndex ();
+
+    for (unsigned int it = this->vertexData[to].firstCorner; it != Util::invalidIndex ();
+         it = this->nextCorners[it])
+    {
+      const unsigned int o = prevInFace (it);
+
+      if (it / 3 != c / 3 && this->cornerVertex (nextInFace (it)) == from &&
+          this->oppositeCorners[o] == Util::invalidIndex ())
+      {
+        this->recordFace (o / 3);
+        this->oppositeCorners[c] = o;
+        this->oppositeCorners[o] = c;
+        return;
+      }
+    }
+  }
+
+  void disconnectOppositeCorner (unsigned int c)
+  {
+    const unsigned int o = this->oppositeCorners[c];
+
+    if (o != Util::invalidIndex ())
+    {
+      assert (this->oppositeCorners[o] == c);
+
+      this->recordFace (o / 3);
+      this->oppositeCorners[o] = Util::invalidIndex ();
+      this->oppositeCorners[c] = Util::invalidIndex ();
+    }
+  }
+
   void addFaceToOctree (unsigned int i)
   {
     const PrimTriangle tri = this->face (i);
 
     this->octree.addElement (i, tri.center (), tri.maxDimExtent ());
+    this->outdateChunk (i);
   }
 
   void deleteVertex (unsigned int i)
@@ -562,10 +682,11 @@ struct DynamicMesh::Impl
     assert (i < this->vertexData.size ());
     assert (i < this->vertexVisited.size ());
 
-    std::vector<unsigned int> adjacentFaces = this->vertexData[i].adjacentFaces;
-    for (unsigned int f : adjacentFaces)
+    this->recordVertex (i);
+
+    while (this->vertexData[i].firstCorner != Util::invalidIndex ())
     {
-      this->deleteFace (f);
+      this->deleteFace (this->vertexData[i].firstCorner / 3);
     }
     this->vertexData[i].reset ();
     this->vertexVisited[i] = 0;
@@ -577,14 +698,61 @@ struct DynamicMesh::Impl
     assert (i < this->faceData.size ());
     assert (i < this->faceVisited.size ());
 
-    this->vertexData[this->mesh.index ((3 * i) + 0)].deleteAdjacentFace (i);
-    this->vertexData[this->mesh.index ((3 * i) + 1)].deleteAdjacentFace (i);
-    this->vertexData[this->mesh.index ((3 * i) + 2)].deleteAdjacentFace (i);
+    this->recordFace (i);
+    this->recordVertex (this->mesh.index ((3 * i) + 0));
+    this->recordVertex (this->mesh.index ((3 * i) + 1));
+    this->recordVertex (this->mesh.index ((3 * i) + 2));
+
+    this->disconnectOppositeCorner ((3 * i) + 0);
+    this->disconnectOppositeCorner ((3 * i) + 1);
+    this->disconnectOppositeCorner ((3 * i) + 2);
+
+    this->deleteCorner (this->mesh.index ((3 * i) + 0), (3 * i) + 0);
+    this->deleteCorner (this->mesh.index ((3 * i) + 1), (3 * i) + 1);
+    this->deleteCorner (this->mesh.index ((3 * i) + 2), (3 * i) + 2);
 
     this->faceData[i].reset ();
     this->faceVisited[i] = 0;
     this->freeFaceIndices.push_back (i);
     this->octree.deleteElement (i);
+    this->outdateChunk (i);
+  }
+
+  void vertex (unsigned int i, const glm::vec3& v)
+  {
+    this->recordVertex (i);
+    this->extendMinMax (v);
+    this->mesh.vertex (i, v);
+  }
+
+  /* The bounding box of all vertices is extended by each modification but only shrunk by
+   * operations that visit all vertices anyway (e.g. pruning), i.e. it is conservative but cheap
+   * to maintain while sculpting.
+   */
+  void minMax (glm::vec3& min, glm::vec3& max) const
+  {
+    min = this->minimum;
+    max = this->maximum;
+  }
+
+  void extendMinMax (const glm::vec3& v)
+  {
+    this->minimum = glm::min (this->minimum, v);
+    this->maximum = glm::max (this->maximum, v);
+  }
+
+  void updateMinMax ()
+  {
+    this->minimum = glm::vec3 (Util::maxFloat ());
+    this->maximum = glm::vec3 (Util::minFloat ());
+
+    for (unsigned int i = 0; i < this->vertexData.size (); i++)
+    {
+      if (this->isFreeVertex (i) == false)
+      {
+        this->extendMinMax (this->mesh.vertex (i));
+      }
+    }
   }
 
   void vertexNormal (unsigned int i, const glm::vec3& n)
@@ -592,6 +760,7 @@ struct DynamicMesh::Impl
     assert (this->isFreeVertex (i) == false);
     assert (this->mesh.numVertices () == this->vertexData.size ());
 
+    this->recordVertex (i);
     this->mesh.normal (i, n);
   }
 
@@ -599,6 +768,8 @@ struct DynamicMesh::Impl
   {
     const glm::vec3 avg = this->averageNormal (i);
 
+    this->recordVertex (i);
+
     if (Util::isNaN (avg))
     {
       this->mesh.normal (i, glm::vec3 (0.0f));
@@ -609,13 +780,41 @@ struct DynamicMesh::Impl
     }
   }
 
+  void setVertexNormals (const std::vector<unsigned int>& indices)
+  {
+    std::vector<glm::vec3> normals (indices.size ());
+
+    Parallel::forRange (indices.size (), parallelGrainSize,
+                        [this, &indices, &normals](unsigned int begin, unsigned int end) {
+                          for (unsigned int i = begin; i < end; i++)
+                          {
+                            normals[i] = this->averageNormal (indices[i]);
+                          }
+                        });
+
+    for (unsigned int i = 0; i < indices.size (); i++)
+    {
+      this->vertexNormal (indices[i], Util::isNaN (normals[i]) ? glm::vec3 (0.0f) : normals[i]);
+    }
+  }
+
+  void setVertexNormals (const DynamicFaces& faces)
+  {
+    std::vector<unsigned int> indices;
+    this->forEachVertex (faces, [&indices](unsigned int i) { indices.push_back (i); });
+    this->setVertexNormals (indices);
+  }
+
   void setAllNormals ()
   {
-    this->forEachVertex ([this](unsigned int i) { this->setVertexNormal (i); });
+    std::vector<unsigned int> indices;
+    this->forEachVertex ([&indices](unsigned int i) { indices.push_back (i); });
+    this->setVertexNormals (indices);
   }
 
   void reset ()
   {
+    this->keepOriginal ();
     this->mesh.reset ();
     this->vertexData.clear ();
     this->vertexVisited.clear ();
@@ -623,7 +822,13 @@ struct DynamicMesh::Impl
     this->faceData.clear ();
     this->faceVisited.clear ();
     this->freeFaceIndices.clear ();
+    this->misalignedFaces.clear ();
+    this->chunkData.clear ();
+    this->outdatedChunks.clear ();
+    this->nextCorners.clear ();
+    this->oppositeCorners.clear ();
     this->octree.reset ();
+    this->updateMinMax ();
   }
 
   void fromMesh (const Mesh& mesh)
@@ -648,26 +853,58 @@ struct DynamicMesh::Impl
     this->mesh.bufferData ();
   }
 
-  void realignFace (unsigned int i)
+  void misalignFace (unsigned int i)
   {
     assert (this->isFreeFace (i) == false);
 
-    const PrimTriangle tri = this->face (i);
+    if (this->faceData[i].isMisaligned == false)
+    {
+      this->faceData[i].isMisaligned = true;
+      this->misalignedFaces.push_back (i);
+    }
+  }
+
+  /* Operations that modify many faces mark them as misaligned and realign all of them once they
+   * are done, i.e. a face that is shared by several modified vertices is realigned only once.
+   * No face is misaligned between two operations, thus queries never modify the octree.
+   */
+  void realignMisalignedFaces ()
+  {
+    for (unsigned int i : this->misalignedFaces)
+    {
+      if (i < this->faceData.size () && this->faceData[i].isMisaligned)
+      {
+        assert (this->isFreeFace (i) == false);
+
+        const PrimTriangle tri = this->face (i);
+
+        this->faceData[i].isMisaligned = false;
+        this->octree.realignElement (i, tri.center (), tri.maxDimExtent ());
+        this->outdateChunk (i);
+      }
+    }
+    this->misalignedFaces.clear ();
+  }
 
-    this->octree.realignElement (i, tri.center (), tri.maxDimExtent ());
+  void realignFace (unsigned int i)
+  {
+    this->misalignFace (i);
+    this->realignMisalignedFaces ();
   }
 
   void realignFaces (const DynamicFaces& faces)
   {
     for (unsigned int i : faces)
     {
-      this->realignFace (i);
+      this->misalignFace (i);
     }
+    this->realignMisalignedFaces ();
   }
 
   void realignAllFaces ()
   {
-    this->forEachFace ([this](unsigned int i) { this->realignFace (i); });
+    this->forEachFace ([this](unsigned int i) { this->misalignFace (i); });
+    this->realignMisalignedFaces ();
   }
 
   void sanitize ()
@@ -680,6 +917,8 @@ struct DynamicMesh::Impl
   {
     if (this->isPruned () == false)
     {
+      this->keepOriginal ();
+
       std::vector<unsigned int> defaultVertexIndexMap;
       std::vector<unsigned int> defaultFaceIndexMap;
 
@@ -700,14 +939,22 @@ struct DynamicMesh::Impl
       const unsigned int newNumVertices = this->vertexData.size ();
       const unsigned int newNumFaces = this->faceData.size ();
 
-      for (VertexData& d : this->vertexData)
-      {
-        for (unsigned int& f : d.adjacentFaces)
+      const auto newCorner = [pFaceIndexMap](unsigned int c) -> unsigned int {
+        if (c == Util::invalidIndex ())
         {
-          assert (pFaceIndexMap->at (f) != Util::invalidIndex ());
-
-          f = pFaceIndexMap->at (f);
+          return c;
         }
+        else
+        {
+          assert (pFaceIndexMap->at (c / 3) != Util::invalidIndex ());
+          return (3 * pFaceIndexMap->at (c / 3)) + (c % 3);
+        }
+      };
+
+      for (VertexData& d : this->vertexData)
+      {
+        d.firstCorner = newCorner (d.firstCorner);
+        d.lastCorner = newCorner (d.lastCorner);
       }
 
       for (unsigned int i = 0; i < pVertexIndexMap->size (); i++)
@@ -746,6 +993,12 @@ struct DynamicMesh::Impl
           this->mesh.index ((3 * newF) + 0, pVertexIndexMap->at (oldI1));
           this->mesh.index ((3 * newF) + 1, pVertexIndexMap->at (oldI2));
           this->mesh.index ((3 * newF) + 2, pVertexIndexMap->at (oldI3));
+
+          for (unsigned int c = 0; c < 3; c++)
+          {
+            this->nextCorners[(3 * newF) + c] = newCorner (this->nextCorners[(3 * i) + c]);
+            this->oppositeCorners[(3 * newF) + c] = newCorner (this->oppositeCorners[(3 * i) + c]);
+          }
         }
         else
         {
@@ -756,10 +1009,14 @@ struct DynamicMesh::Impl
       }
       this->freeFaceIndices.clear ();
       this->mesh.shrinkIndices (3 * newNumFaces);
+      this->nextCorners.resize (3 * newNumFaces);
+      this->oppositeCorners.resize (3 * newNumFaces);
       this->faceVisited.resize (newNumFaces);
       assert (this->numFaces () == newNumFaces);
 
       this->octree.updateIndices (*pFaceIndexMap);
+      this->updateMinMax ();
+      this->outdateAllChunks ();
     }
   }
 
@@ -774,7 +1031,7 @@ struct DynamicMesh::Impl
       {
         if (this->vertexData[i].isFree == false)
         {
-          if (this->vertexData[i].adjacentFaces.empty ())
+          if (this->vertexData[i].valence == 0)
           {
             DILAY_WARN ("vertex %u is not free but has no adjacent faces", i);
             return false;
@@ -862,12 +1119,128 @@ struct DynamicMesh::Impl
         this->mesh.index ((3 * i) + 2, this->mesh.index ((3 * nonFree) + 2));
       }
     }
-    this->mesh.bufferData ();
+
+    // wireframe vertices are only rewritten at the corners of modified vertices
+    this->modifiedCorners.clear ();
+
+    for (unsigned int i : this->mesh.modifiedVertices ())
+    {
+      if (i < this->vertexData.size () && this->isFreeVertex (i) == false)
+      {
+        const DynamicMesh::AdjacentFaces faces = this->adjacentFaces (i);
+
+        for (auto it = faces.begin (); it != faces.end (); ++it)
+        {
+          this->modifiedCorners.push_back (it.corner ());
+        }
+      }
+    }
+    this->mesh.bufferData (this->modifiedCorners);
+    this->isBufferDataDeferred = false;
+  }
+
+  void deferBufferData () { this->isBufferDataDeferred = true; }
+
+  void outdateChunk (unsigned int face)
+  {
+    const unsigned int c = face / facesPerChunk;
+
+    if (c >= this->chunkData.size ())
+    {
+      this->chunkData.resize (c + 1);
+    }
+    if (this->chunkData[c].isOutdated == false)
+    {
+      this->chunkData[c].isOutdated = true;
+      this->outdatedChunks.push_back (c);
+    }
+  }
+
+  void outdateAllChunks ()
+  {
+    this->chunkData.clear ();
+    this->outdatedChunks.clear ();
+
+    for (unsigned int i = 0; i < this->faceData.size (); i += facesPerChunk)
+    {
+      this->outdateChunk (i);
+    }
+  }
+
+  /* Chunk bounds are only recomputed when rendering, so a chunk that is modified by several
+   * sculpting steps in a row is visited once.  Bounds are in model space.
+   */
+  void updateChunks ()
+  {
+    const unsigned int numChunks = (this->faceData.size () + facesPerChunk - 1) / facesPerChunk;
+
+    this->chunkData.resize (numChunks);
+
+    for (unsigned int c : this->outdatedChunks)
+    {
+      if (c < numChunks)
+      {
+        ChunkData&         chunk = this->chunkData[c];
+        const unsigned int end = std::min<unsigned int> (this->faceData.size (),
+                                                         (c + 1) * facesPerChunk);
+        chunk.reset ();
+
+        for (unsigned int i = c * facesPerChunk; i < end; i++)
+        {
+          if (this->isFreeFace (i) == false)
+          {
+            for (unsigned int j = 0; j < 3; j++)
+            {
+              const glm::vec3& v = this->mesh.vertex (this->mesh.index ((3 * i) + j));
+
+              chunk.minimum = glm::min (chunk.minimum, v);
+              chunk.maximum = glm::max (chunk.maximum, v);
+            }
+          }
+        }
+      }
+    }
+    this->outdatedChunks.clear ();
+  }
+
+  // Index ranges of all chunks that intersect the view frustum, adjacent ranges are merged
+  std::vector<glm::uvec2> visibleRanges (const Camera& camera) const
+  {
+    const PrimFrustum       frustum = camera.frustum (this->mesh.modelMatrix ());
+    std::vector<glm::uvec2> ranges;
+
+    for (unsigned int c = 0; c < this->chunkData.size (); c++)
+    {
+      const ChunkData& chunk = this->chunkData[c];
+
+      if (chunk.isEmpty () == false &&
+          IntersectionUtil::intersects (frustum, PrimAABox (chunk.minimum, chunk.maximum)))
+      {
+        const unsigned int first = 3 * c * facesPerChunk;
+        const unsigned int count =
+          3 * std::min<unsigned int> (facesPerChunk, this->faceData.size () - (c * facesPerChunk));
+
+        if (ranges.empty () == false && ranges.back ().x + ranges.back ().y == first)
+        {
+          ranges.back ().y += count;
+        }
+        else
+        {
+          ranges.emplace_back (first, count);
+        }
+      }
+    }
+    return ranges;
   }
 
-  void render (Camera& camera) const
+  void render (Camera& camera)
   {
-    this->mesh.render (camera);
+    if (this->isBufferDataDeferred)
+    {
+      this->bufferData ();
+    }
+    this->updateChunks ();
+    this->mesh.renderRanges (camera, this->visibleRanges (camera));
 #ifdef DILAY_RENDER_OCTREE
     this->octree.render (camera);
 #endif
@@ -875,28 +1248,32 @@ struct DynamicMesh::Impl
 
   bool intersects (const PrimRay& ray, Intersection& intersection) const
   {
-    this->octree.intersects (ray, [this, &ray, &intersection](unsigned int i) {
+    assert (this->misalignedFaces.empty ());
+    this->octree.closestIntersection (ray, [this, &ray, &intersection](unsigned int i, float& t) {
       const PrimTriangle tri = this->face (i);
-      float              t;
 
       if (IntersectionUtil::intersects (ray, tri, false, &t))
       {
         intersection.update (t, ray.pointAt (t), tri.normal ());
+        return true;
       }
+      return false;
     });
     return intersection.isIntersection ();
   }
 
   bool intersects (const PrimRay& ray, DynamicMeshIntersection& intersection)
   {
-    this->octree.intersects (ray, [this, &ray, &intersection](unsigned int i) {
+    assert (this->misalignedFaces.empty ());
+    this->octree.closestIntersection (ray, [this, &ray, &intersection](unsigned int i, float& t) {
       const PrimTriangle tri = this->face (i);
-      float              t;
 
       if (IntersectionUtil::intersects (ray, tri, false, &t))
       {
         intersection.update (t, ray.pointAt (t), tri.normal (), i, *this->self);
+        return true;
       }
+      return false;
     });
     return intersection.isIntersection ();
   }
@@ -904,6 +1281,7 @@ struct DynamicMesh::Impl
   template <typename T, typename... Ts>
   bool intersectsT (const T& t, DynamicFaces& faces, const Ts&... args) const
   {
+    assert (this->misalignedFaces.empty ());
     this->octree.intersects (t, [this, &t, &faces, &args...](unsigned int i) {
       if (IntersectionUtil::intersects (t, this->face (i), args...))
       {
@@ -917,6 +1295,7 @@ struct DynamicMesh::Impl
   template <typename T, typename... Ts>
   bool containsOrIntersectsT (const T& t, DynamicFaces& faces, const Ts&... args) const
   {
+    assert (this->misalignedFaces.empty ());
     this->octree.intersects (t, [this, &t, &faces, &args...](bool contains, unsigned int i) {
       if (contains || IntersectionUtil::intersects (t, this->face (i), args...))
       {
@@ -949,13 +1328,262 @@ struct DynamicMesh::Impl
 
   void normalize ()
   {
+    this->keepOriginal ();
     this->mesh.normalize ();
+    this->updateMinMax ();
     this->octree.reset ();
     this->setupOctreeRoot (this->mesh);
 
     this->forEachFace ([this](unsigned int i) { this->addFaceToOctree (i); });
   }
 
+  DynamicMeshDelta::Vertex vertexRecord (unsigned int i) const
+  {
+    DynamicMeshDelta::Vertex record;
+    record.index = i;
+
+    if (i < this->vertexData.size ())
+    {
+      record.isFree = this->vertexData[i].isFree;
+      record.position = this->mesh.vertex (i);
+      record.normal = this->mesh.normal (i);
+      record.firstCorner = this->vertexData[i].firstCorner;
+      record.lastCorner = this->vertexData[i].lastCorner;
+      record.valence = this->vertexData[i].valence;
+    }
+    else
+    {
+      record.isFree = true;
+      record.position = glm::vec3 (0.0f);
+      record.normal = glm::vec3 (0.0f);
+      record.firstCorner = Util::invalidIndex ();
+      record.lastCorner = Util::invalidIndex ();
+      record.valence = 0;
+    }
+    return record;
+  }
+
+  DynamicMeshDelta::Face faceRecord (unsigned int i) const
+  {
+    DynamicMeshDelta::Face record;
+    record.index = i;
+    record.isFree = i < this->faceData.size () ? this->faceData[i].isFree : true;
+
+    for (unsigned int c = 0; c < 3; c++)
+    {
+      if (i < this->faceData.size ())
+      {
+        record.vertices[c] = this->mesh.index ((3 * i) + c);
+        record.nextCorners[c] = this->nextCorners[(3 * i) + c];
+        record.oppositeCorners[c] = this->oppositeCorners[(3 * i) + c];
+      }
+      else
+      {
+        record.vertices[c] = 0;
+        record.nextCorners[c] = Util::invalidIndex ();
+        record.oppositeCorners[c] = Util::invalidIndex ();
+      }
+    }
+    return record;
+  }
+
+  void recordVertex (unsigned int i)
+  {
+    if (this->delta && this->delta->needsVertex (i))
+    {
+      this->delta->addVertex (this->vertexRecord (i));
+    }
+  }
+
+  void recordFace (unsigned int i)
+  {
+    if (this->delta && this->delta->needsFace (i))
+    {
+      this->delta->addFace (this->faceRecord (i));
+    }
+  }
+
+  void recordFreeVertexIndexPop ()
+  {
+    if (this->delta && this->delta->hasOriginal () == false)
+    {
+      this->delta->popFreeVertexIndex (this->freeVertexIndices);
+    }
+  }
+
+  void recordFreeFaceIndexPop ()
+  {
+    if (this->delta && this->delta->hasOriginal () == false)
+    {
+      this->delta->popFreeFaceIndex (this->freeFaceIndices);
+    }
+  }
+
+  void keepOriginal ()
+  {
+    if (this->delta && this->delta->hasOriginal () == false)
+    {
+      DynamicMesh original (*this->self);
+      original.applyDelta (*this->delta);
+      this->delta->original (std::move (original));
+    }
+  }
+
+  void recordDelta (DynamicMeshDelta* d)
+  {
+    if (this->delta)
+    {
+      this->delta->end ();
+    }
+    this->delta = d;
+
+    if (this->delta)
+    {
+      this->delta->begin (this->self, this->vertexData.size (), this->faceData.size (),
+                          this->freeVertexIndices.size (), this->freeFaceIndices.size ());
+    }
+  }
+
+  void resizeVertices (unsigned int n)
+  {
+    if (n < this->vertexData.size ())
+    {
+      this->vertexData.resize (n);
+      this->vertexVisited.resize (n);
+      this->mesh.shrinkVertices (n);
+    }
+    else
+    {
+      while (this->vertexData.size () < n)
+      {
+        this->vertexData.emplace_back ();
+        this->vertexVisited.push_back (0);
+        this->mesh.addVertex (glm::vec3 (0.0f), glm::vec3 (0.0f));
+      }
+    }
+  }
+
+  void resizeFaces (unsigned int n)
+  {
+    if (n < this->faceData.size ())
+    {
+      this->faceData.resize (n);
+      this->faceVisited.resize (n);
+      this->mesh.shrinkIndices (3 * n);
+    }
+    else
+    {
+      while (this->faceData.size () < n)
+      {
+        this->faceData.emplace_back ();
+        this->faceVisited.push_back (0);
+        this->mesh.addIndex (0);
+        this->mesh.addIndex (0);
+        this->mesh.addIndex (0);
+      }
+    }
+    this->nextCorners.resize (3 * n, Util::invalidIndex ());
+    this->oppositeCorners.resize (3 * n, Util::invalidIndex ());
+  }
+
+  void applyDelta (DynamicMeshDelta& d)
+  {
+    assert (this->delta != &d);
+    assert (d.hasOriginal () == false);
+
+    if (d.isEmpty () && d.numVertices () == this->vertexData.size () &&
+        d.numFaces () == this->faceData.size ())
+    {
+      return;
+    }
+
+    std::vector<DynamicMeshDelta::Vertex> vertices;
+    std::vector<DynamicMeshDelta::Face>   faces;
+
+    vertices.reserve (d.vertices ().size ());
+    faces.reserve (d.faces ().size ());
+
+    for (const DynamicMeshDelta::Face& f : d.faces ())
+    {
+      faces.push_back (this->faceRecord (f.index));
+
+      if (f.index < this->faceData.size () && this->faceData[f.index].isFree == false)
+      {
+        this->octree.deleteElement (f.index);
+      }
+    }
+    for (const DynamicMeshDelta::Vertex& v : d.vertices ())
+    {
+      vertices.push_back (this->vertexRecord (v.index));
+    }
+
+    const unsigned int numVertices = this->vertexData.size ();
+    const unsigned int numFaces = this->faceData.size ();
+
+    this->resizeVertices (d.numVertices ());
+    this->resizeFaces (d.numFaces ());
+
+    for (const DynamicMeshDelta::Vertex& v : d.vertices ())
+    {
+      if (v.index < this->vertexData.size ())
+      {
+        this->vertexData[v.index].isFree = v.isFree;
+        this->vertexData[v.index].firstCorner = v.firstCorner;
+        this->vertexData[v.index].lastCorner = v.lastCorner;
+        this->vertexData[v.index].valence = v.valence;
+        this->mesh.vertex (v.index, v.position);
+        this->mesh.normal (v.index, v.normal);
+
+        if (v.isFree == false)
+        {
+          this->extendMinMax (v.position);
+        }
+      }
+    }
+    for (const DynamicMeshDelta::Face& f : d.faces ())
+    {
+      if (f.index < this->faceData.size ())
+      {
+        this->faceData[f.index].isFree = f.isFree;
+
+        for (unsigned int c = 0; c < 3; c++)
+        {
+          this->mesh.index ((3 * f.index) + c, f.vertices[c]);
+          this->nextCorners[(3 * f.index) + c] = f.nextCorners[c];
+          this->oppositeCorners[(3 * f.index) + c] = f.oppositeCorners[c];
+        }
+      }
+    }
+    d.swapFreeVertexIndices (this->freeVertexIndices);
+    d.swapFreeFaceIndices (this->freeFaceIndices);
+
+    for (const DynamicMeshDelta::Face& f : d.faces ())
+    {
+      if (f.index < this->faceData.size () && this->faceData[f.index].isFree == false)
+      {
+        if (this->octree.hasRoot () == false)
+        {
+          this->setupOctreeRoot ();
+        }
+        this->addFaceToOctree (f.index);
+      }
+    }
+    for (const DynamicMeshDelta::Vertex& v : d.vertices ())
+    {
+      if (v.index < this->vertexData.size () && this->vertexData[v.index].isFree == false)
+      {
+        for (unsigned int f : this->adjacentFaces (v.index))
+        {
+          this->misalignFace (f);
+        }
+      }
+    }
+    this->realignMisalignedFaces ();
+    d.vertices () = std::move (vertices);
+    d.faces () = std::move (faces);
+    d.sizes (numVertices, numFaces);
+  }
+
   void printStatistics () const { this->octree.printStatistics (); }
 
   void runFromConfig (const Config& config)
@@ -965,7 +1593,28 @@ struct DynamicMesh::Impl
   }
 };
 
-DELEGATE1_BIG4_COPY_SELF (DynamicMesh, const Mesh&)
+DELEGATE1_CONSTRUCTOR_SELF (DynamicMesh, const Mesh&)
+
+DynamicMesh::DynamicMesh (const DynamicMesh& other)
+  : impl (new Impl (*other.impl))
+{
+  SET_SELF
+  this->impl->delta = nullptr;
+}
+
+DynamicMesh::DynamicMesh (DynamicMesh&& other)
+  : impl (new Impl (std::move (*other.impl)))
+{
+  assert (other.impl->delta == nullptr);
+  SET_SELF
+}
+
+DynamicMesh::~DynamicMesh ()
+{
+  this->impl->keepOriginal ();
+  this->impl->recordDelta (nullptr);
+}
+
 DELEGATE_CONST (unsigned int, DynamicMesh, numVertices)
 DELEGATE_CONST (unsigned int, DynamicMesh, numFaces)
 DELEGATE_CONST (bool, DynamicMesh, isEmpty)
@@ -978,8 +1627,10 @@ DELEGATE4_CONST (void, DynamicMesh, vertexIndices, unsigned int, unsigned int&,
 DELEGATE1_CONST (PrimTriangle, DynamicMesh, face, unsigned int)
 DELEGATE1_CONST (const glm::vec3&, DynamicMesh, vertexNormal, unsigned int)
 DELEGATE1_CONST (glm::vec3, DynamicMesh, faceNormal, unsigned int)
-DELEGATE1_CONST (const std::vector<unsigned int>&, DynamicMesh, adjacentFaces, unsigned int)
+DELEGATE1_CONST (DynamicMesh::AdjacentFaces, DynamicMesh, adjacentFaces, unsigned int)
+DELEGATE1_CONST (unsigned int, DynamicMesh, oppositeCorner, unsigned int)
 GETTER_CONST (const Mesh&, DynamicMesh, mesh)
+GETTER_CONST (const std::vector<unsigned int>&, DynamicMesh, freeFaceIndices)
 DELEGATE1 (void, DynamicMesh, forEachVertex, const std::function<void(unsigned int)>&)
 DELEGATE2 (void, DynamicMesh, forEachVertex, const DynamicFaces&,
            const std::function<void(unsigned int)>&)
@@ -1004,9 +1655,10 @@ DELEGATE2 (unsigned int, DynamicMesh, addVertex, const glm::vec3&, const glm::ve
 DELEGATE3 (unsigned int, DynamicMesh, addFace, unsigned int, unsigned int, unsigned int)
 DELEGATE1 (void, DynamicMesh, deleteVertex, unsigned int)
 DELEGATE1 (void, DynamicMesh, deleteFace, unsigned int)
-DELEGATE2_MEMBER (void, DynamicMesh, vertex, mesh, unsigned int, const glm::vec3&)
+DELEGATE2 (void, DynamicMesh, vertex, unsigned int, const glm::vec3&)
 DELEGATE2 (void, DynamicMesh, vertexNormal, unsigned int, const glm::vec3&)
 DELEGATE1 (void, DynamicMesh, setVertexNormal, unsigned int)
+DELEGATE1 (void, DynamicMesh, setVertexNormals, const DynamicFaces&)
 DELEGATE (void, DynamicMesh, setAllNormals)
 DELEGATE (void, DynamicMesh, reset)
 DELEGATE1 (void, DynamicMesh, fromMesh, const Mesh&)
@@ -1017,8 +1669,11 @@ DELEGATE (void, DynamicMesh, sanitize)
 DELEGATE2 (void, DynamicMesh, prune, std::vector<unsigned int>*, std::vector<unsigned int>*)
 DELEGATE (bool, DynamicMesh, pruneAndCheckConsistency)
 DELEGATE1 (bool, DynamicMesh, mirror, const PrimPlane&)
+DELEGATE1 (void, DynamicMesh, recordDelta, DynamicMeshDelta*)
+DELEGATE1 (void, DynamicMesh, applyDelta, DynamicMeshDelta&)
 DELEGATE (void, DynamicMesh, bufferData)
-DELEGATE1_CONST (void, DynamicMesh, render, Camera&)
+DELEGATE (void, DynamicMesh, deferBufferData)
+DELEGATE1 (void, DynamicMesh, render, Camera&)
 DELEGATE_MEMBER_CONST (const RenderMode&, DynamicMesh, renderMode, mesh)
 DELEGATE_MEMBER (RenderMode&, DynamicMesh, renderMode, mesh)
 
@@ -1048,6 +1703,7 @@ DELEGATE1_MEMBER (void, DynamicMesh, rotateX, mesh, float)
 DELEGATE1_MEMBER (void, DynamicMesh, rotateY, mesh, float)
 DELEGATE1_MEMBER (void, DynamicMesh, rotateZ, mesh, float)
 DELEGATE_MEMBER_CONST (glm::vec3, DynamicMesh, center, mesh)
+DELEGATE2_CONST (void, DynamicMesh, minMax, glm::vec3&, glm::vec3&)
 DELEGATE_MEMBER_CONST (const Color&, DynamicMesh, color, mesh)
 DELEGATE1_MEMBER (void, DynamicMesh, color, mesh, const Color&)
 DELEGATE_MEMBER_CONST (const Color&, DynamicMesh, wireframeColor, mesh)
@@ -1062,3 +1718,8 @@ void DynamicMesh::findAdjacent (unsigned int e1, unsigned int e2, unsigned int&
 {
   return this->impl->findAdjacent (e1, e2, leftFace, leftVertex, rightFace, rightVertex);
 }
+
+DynamicMesh::AdjacentFaces::Iterator DynamicMesh::AdjacentFaces::end () const
+{
+  return Iterator (*this->nextCorners, Util::invalidIndex ());
+}
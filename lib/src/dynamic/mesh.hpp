@@ -14,6 +14,7 @@
 class Camera;
 class Color;
 class DynamicFaces;
+class DynamicMeshDelta;
 class DynamicMeshIntersection;
 class Intersection;
 class Mesh;
@@ -29,6 +30,56 @@ class DynamicMesh : public Configurable
 public:
   DECLARE_BIG4_EXPLICIT_COPY (DynamicMesh, const Mesh&);
 
+  /* Connectivity is stored in a corner table: corner `c` refers to the `c % 3`-th vertex of
+   * face `c / 3`.  The corners of a vertex are linked, i.e. iterating the adjacent faces of a
+   * vertex does not need any additional storage.
+   */
+  class AdjacentFaces
+  {
+  public:
+    class Iterator
+    {
+    public:
+      Iterator (const std::vector<unsigned int>& n, unsigned int c)
+        : nextCorners (&n)
+        , _corner (c)
+      {
+      }
+
+      unsigned int operator* () const { return this->_corner / 3; }
+      bool operator!= (const Iterator& o) const { return this->_corner != o._corner; }
+
+      Iterator& operator++ ()
+      {
+        this->_corner = (*this->nextCorners)[this->_corner];
+        return *this;
+      }
+
+      unsigned int corner () const { return this->_corner; }
+
+    private:
+      const std::vector<unsigned int>* nextCorners;
+      unsigned int                     _corner;
+    };
+
+    AdjacentFaces (const std::vector<unsigned int>& n, unsigned int f, unsigned int s)
+      : nextCorners (&n)
+      , firstCorner (f)
+      , _size (s)
+    {
+    }
+
+    Iterator     begin () const { return Iterator (*this->nextCorners, this->firstCorner); }
+    Iterator     end () const;
+    unsigned int size () const { return this->_size; }
+    bool         empty () const { return this->_size == 0; }
+
+  private:
+    const std::vector<unsigned int>* nextCorners;
+    unsigned int                     firstCorner;
+    unsigned int                     _size;
+  };
+
   unsigned int     numVertices () const;
   unsigned int     numFaces () const;
   bool             isEmpty () const;
@@ -43,7 +94,8 @@ public:
   void findAdjacent (unsigned int, unsigned int, unsigned int&, unsigned int&, unsigned int&,
                      unsigned int&) const;
 
-  const std::vector<unsigned int>& adjacentFaces (unsigned int) const;
+  AdjacentFaces adjacentFaces (unsigned int) const;
+  unsigned int  oppositeCorner (unsigned int) const;
 
   void forEachVertex (const std::function<void(unsigned int)>&);
   void forEachVertex (const DynamicFaces&, const std::function<void(unsigned int)>&);
@@ -61,16 +113,18 @@ public:
   float     averageEdgeLengthSqr (const DynamicFaces&) const;
   float     averageEdgeLengthSqr (unsigned int) const;
 
-  const Mesh&  mesh () const;
-  void         setupOctreeRoot ();
-  unsigned int addVertex (const glm::vec3&, const glm::vec3&);
-  unsigned int addFace (unsigned int, unsigned int, unsigned int);
-  void         deleteVertex (unsigned int);
-  void         deleteFace (unsigned int);
+  const Mesh&                      mesh () const;
+  const std::vector<unsigned int>& freeFaceIndices () const;
+  void                             setupOctreeRoot ();
+  unsigned int                     addVertex (const glm::vec3&, const glm::vec3&);
+  unsigned int                     addFace (unsigned int, unsigned int, unsigned int);
+  void                             deleteVertex (unsigned int);
+  void                             deleteFace (unsigned int);
 
   void vertex (unsigned int, const glm::vec3&);
   void vertexNormal (unsigned int, const glm::vec3&);
   void setVertexNormal (unsigned int);
+  void setVertexNormals (const DynamicFaces&);
   void setAllNormals ();
 
   void reset ();
@@ -82,9 +136,14 @@ public:
   void prune (std::vector<unsigned int>* = nullptr, std::vector<unsigned int>* = nullptr);
   bool pruneAndCheckConsistency ();
   bool mirror (const PrimPlane&);
+  void recordDelta (DynamicMeshDelta*);
+  void applyDelta (DynamicMeshDelta&);
   void bufferData ();
 
-  void render (Camera&) const;
+  // Buffers data right before the mesh is rendered next, i.e. at most once per frame
+  void deferBufferData ();
+
+  void render (Camera&);
 
   const RenderMode& renderMode () const;
   RenderMode&       renderMode ();
@@ -115,6 +174,7 @@ public:
   void               rotateY (float);
   void               rotateZ (float);
   glm::vec3          center () const;
+  void               minMax (glm::vec3&, glm::vec3&) const;
   const Color&       color () const;
   void               color (const Color&);
   const Color&       wireframeColor () const;
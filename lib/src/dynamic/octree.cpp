@@ -6,13 +6,13 @@
 #include <functional>
 #include <glm/glm.hpp>
 #include <iostream>
+#include <queue>
 #include <unordered_map>
-#include <unordered_set>
 #include "dynamic/octree.hpp"
 #include "intersection.hpp"
-#include "maybe.hpp"
 #include "primitive/aabox.hpp"
 #include "primitive/plane.hpp"
+#include "primitive/ray.hpp"
 #include "primitive/sphere.hpp"
 #include "util.hpp"
 
@@ -24,9 +24,6 @@
 
 namespace
 {
-  struct IndexOctreeNode;
-  typedef Maybe<IndexOctreeNode> Child;
-
   struct IndexOctreeStatistics
   {
     typedef std::unordered_map<int, unsigned int> DepthMap;
@@ -40,14 +37,18 @@ namespace
     DepthMap     numNodesPerDepth;
   };
 
+  /* Nodes are stored in a pool and refer to their children by handles, i.e. indices into the
+   * pool.  The elements of a node form a doubly linked list that is stored in per-element arrays
+   * of the octree.
+   */
   struct IndexOctreeNode
   {
-    const glm::vec3                  center;
-    const float                      width;
-    const int                        depth;
-    const PrimAABox                  looseAABox;
-    std::array<Child, 8>             children;
-    std::unordered_set<unsigned int> indices;
+    glm::vec3                   center;
+    float                       width;
+    int                         depth;
+    std::array<unsigned int, 8> children;
+    unsigned int                firstElement;
+    unsigned int                numElements;
 
     static constexpr float relativeMinElementExtent = 0.1f;
 
@@ -55,11 +56,18 @@ namespace
       : center (c)
       , width (w)
       , depth (d)
-      , looseAABox (c, 2.0f * w, 2.0f * w, 2.0f * w)
+      , firstElement (Util::invalidIndex ())
+      , numElements (0)
     {
       static_assert (IndexOctreeNode::relativeMinElementExtent < 0.5f,
                      "relativeMinElementExtent must be smaller than 0.5f");
       assert (w > 0.0f);
+      this->children.fill (Util::invalidIndex ());
+    }
+
+    PrimAABox looseAABox () const
+    {
+      return PrimAABox (this->center, 2.0f * this->width, 2.0f * this->width, 2.0f * this->width);
     }
 
     bool approxContains (const glm::vec3& position, float maxDimExtent) const
@@ -98,275 +106,143 @@ namespace
       return index;
     }
 
-    bool hasChildren () const { return bool(this->children.at (0)); }
-
-    void makeChildren ()
-    {
-      assert (this->hasChildren () == false);
-
-      const float q = this->width * 0.25f;
-      const float childWidth = this->width * 0.5f;
-      const int   childDepth = this->depth + 1;
-
-      auto add = [this, childWidth, childDepth](unsigned int i, const glm::vec3& offset) {
-        this->children.at (i) = Child::make (this->center + offset, childWidth, childDepth);
-      };
-      add (0, glm::vec3 (-q, -q, -q));  // order is crucial
-      add (1, glm::vec3 (-q, -q, q));
-      add (2, glm::vec3 (-q, q, -q));
-      add (3, glm::vec3 (-q, q, q));
-      add (4, glm::vec3 (q, -q, -q));
-      add (5, glm::vec3 (q, -q, q));
-      add (6, glm::vec3 (q, q, -q));
-      add (7, glm::vec3 (q, q, q));
-    }
+    bool hasChildren () const { return this->children[0] != Util::invalidIndex (); }
 
     bool insertIntoChild (float maxDimExtent) const
     {
       return maxDimExtent <= this->width * IndexOctreeNode::relativeMinElementExtent;
     }
 
-    IndexOctreeNode& insertIntoChild (unsigned int index, const glm::vec3& position,
-                                      float maxDimExtent)
-    {
-      if (this->hasChildren () == false)
-      {
-        this->makeChildren ();
-        return this->insertIntoChild (index, position, maxDimExtent);
-      }
-      else
-      {
-        const unsigned int cIndex = this->childIndex (position);
-        return this->children.at (cIndex)->addElement (index, position, maxDimExtent);
-      }
-    }
-
-    IndexOctreeNode& addElement (unsigned int index, const glm::vec3& position, float maxDimExtent)
-    {
-      assert (this->approxContains (position, maxDimExtent));
+    bool isEmpty () const { return this->numElements == 0 && this->hasChildren () == false; }
+  };
+}
 
-      if (this->insertIntoChild (maxDimExtent))
-      {
-        return this->insertIntoChild (index, position, maxDimExtent);
-      }
-      else
-      {
-        this->indices.insert (index);
-        return *this;
-      }
-    }
+struct DynamicOctree::Impl
+{
+  std::vector<IndexOctreeNode> nodes;
+  std::vector<unsigned int>    freeNodes;
+  unsigned int                 root;
+  std::vector<unsigned int>    elementNodes;
+  std::vector<unsigned int>    nextElements;
+  std::vector<unsigned int>    previousElements;
+
+  Impl ()
+    : root (Util::invalidIndex ())
+  {
+  }
 
-    bool isEmpty () const { return this->indices.empty () && this->hasChildren () == false; }
+  bool hasRoot () const { return this->root != Util::invalidIndex (); }
 
-    void deleteElement (unsigned int index)
+  unsigned int makeNode (const glm::vec3& center, float width, int depth)
+  {
+    if (this->freeNodes.empty ())
     {
-      unsigned int n = this->indices.erase (index);
-      assert (n > 0);
-      unused (n);
+      this->nodes.emplace_back (center, width, depth);
+      return this->nodes.size () - 1;
     }
-
-    bool deleteEmptyChildren ()
+    else
     {
-      bool allChildrenEmpty = true;
-
-      if (this->hasChildren ())
-      {
-        for (Child& c : this->children)
-        {
-          if (c->deleteEmptyChildren () == false)
-          {
-            allChildrenEmpty = false;
-          }
-        }
-        if (allChildrenEmpty)
-        {
-          for (Child& c : this->children)
-          {
-            c.reset ();
-          }
-          assert (this->hasChildren () == false);
-        }
-      }
-      return this->isEmpty ();
+      const unsigned int handle = this->freeNodes.back ();
+      this->freeNodes.pop_back ();
+      this->nodes[handle] = IndexOctreeNode (center, width, depth);
+      return handle;
     }
+  }
 
-#ifdef DILAY_RENDER_OCTREE
-    void render (Camera& camera, Mesh& nodeMesh) const
-    {
-      nodeMesh.position (this->center);
-      nodeMesh.scaling (glm::vec3 (this->width * 0.5f));
-      nodeMesh.renderLines (camera);
+  void deleteNode (unsigned int handle)
+  {
+    assert (this->nodes[handle].isEmpty ());
+    this->freeNodes.push_back (handle);
+  }
 
-      if (this->hasChildren ())
-      {
-        for (const Child& c : this->children)
-        {
-          c->render (camera, nodeMesh);
-        }
-      }
-    }
-#endif
+  void makeChildren (unsigned int handle)
+  {
+    assert (this->nodes[handle].hasChildren () == false);
 
-    template <typename T>
-    void containsOrIntersectsT (const T&                                           t,
-                                const DynamicOctree::ContainsIntersectionCallback& f) const
-    {
-      const bool contains = t.contains (this->looseAABox);
+    const glm::vec3 center = this->nodes[handle].center;
+    const float     q = this->nodes[handle].width * 0.25f;
+    const float     childWidth = this->nodes[handle].width * 0.5f;
+    const int       childDepth = this->nodes[handle].depth + 1;
 
-      if (contains || IntersectionUtil::intersects (t, this->looseAABox))
-      {
-        for (unsigned int index : this->indices)
-        {
-          f (contains, index);
-        }
-        if (this->hasChildren ())
-        {
-          for (const Child& c : this->children)
-          {
-            c->containsOrIntersectsT<T> (t, f);
-          }
-        }
-      }
-    }
-
-    template <typename T>
-    void intersectsT (const T& t, const DynamicOctree::IntersectionCallback& f) const
+    // order is crucial (see IndexOctreeNode::childIndex)
+    for (unsigned int i = 0; i < 8; i++)
     {
-      if (IntersectionUtil::intersects (t, this->looseAABox))
-      {
-        for (unsigned int index : this->indices)
-        {
-          f (index);
-        }
-        if (this->hasChildren ())
-        {
-          for (const Child& c : this->children)
-          {
-            c->intersectsT<T> (t, f);
-          }
-        }
-      }
+      const glm::vec3 offset ((i & 4) ? q : -q, (i & 2) ? q : -q, (i & 1) ? q : -q);
+      const unsigned int child = this->makeNode (center + offset, childWidth, childDepth);
+      this->nodes[handle].children[i] = child;
     }
+  }
 
-    unsigned int numElements () const { return this->indices.size (); }
+  void setupRoot (const glm::vec3& position, float width)
+  {
+    assert (this->hasRoot () == false);
+    this->root = this->makeNode (position, width, 0);
+  }
 
-    void updateIndices (const std::vector<unsigned int>& indexMap)
+  void linkElement (unsigned int index, unsigned int handle)
+  {
+    if (index >= this->elementNodes.size ())
     {
-      std::unordered_set<unsigned int> newIndices;
-
-      for (unsigned int i : this->indices)
-      {
-        assert (indexMap[i] != Util::invalidIndex ());
-
-        newIndices.insert (indexMap[i]);
-      }
-      this->indices = std::move (newIndices);
-
-      if (this->hasChildren ())
-      {
-        for (Child& c : this->children)
-        {
-          c->updateIndices (indexMap);
-        }
-      }
+      this->elementNodes.resize (index + 1, Util::invalidIndex ());
+      this->nextElements.resize (index + 1, Util::invalidIndex ());
+      this->previousElements.resize (index + 1, Util::invalidIndex ());
     }
+    assert (this->elementNodes[index] == Util::invalidIndex ());
 
-    void updateStatistics (IndexOctreeStatistics& stats) const
-    {
-      stats.numNodes += 1;
-      stats.numElements += this->numElements ();
-      stats.minDepth = glm::min (stats.minDepth, this->depth);
-      stats.maxDepth = glm::max (stats.maxDepth, this->depth);
-      stats.maxElementsPerNode = glm::max (stats.maxElementsPerNode, this->numElements ());
+    IndexOctreeNode& node = this->nodes[handle];
 
-      auto e = stats.numElementsPerDepth.find (this->depth);
-      if (e == stats.numElementsPerDepth.end ())
-      {
-        stats.numElementsPerDepth.emplace (this->depth, this->numElements ());
-      }
-      else
-      {
-        e->second = e->second + this->numElements ();
-      }
-      e = stats.numNodesPerDepth.find (this->depth);
-      if (e == stats.numNodesPerDepth.end ())
-      {
-        stats.numNodesPerDepth.emplace (this->depth, 1);
-      }
-      else
-      {
-        e->second = e->second + 1;
-      }
-      if (this->hasChildren ())
-      {
-        for (const Child& c : this->children)
-        {
-          c->updateStatistics (stats);
-        }
-      }
+    if (node.firstElement != Util::invalidIndex ())
+    {
+      this->previousElements[node.firstElement] = index;
     }
-  };
-}
-
-struct DynamicOctree::Impl
-{
-  Child                         root;
-  std::vector<IndexOctreeNode*> elementNodeMap;
-
-  Impl () {}
-
-  Impl (const Impl& other)
-    : root (other.root)
-  {
-    this->makeElementNodeMap ();
+    this->elementNodes[index] = handle;
+    this->nextElements[index] = node.firstElement;
+    this->previousElements[index] = Util::invalidIndex ();
+    node.firstElement = index;
+    node.numElements++;
   }
 
-  bool hasRoot () const { return bool(this->root); }
-
-  void setupRoot (const glm::vec3& position, float width)
+  void unlinkElement (unsigned int index)
   {
-    assert (this->hasRoot () == false);
-    this->root = IndexOctreeNode (position, width, 0);
-  }
+    IndexOctreeNode&   node = this->nodes[this->elementNodes[index]];
+    const unsigned int next = this->nextElements[index];
+    const unsigned int previous = this->previousElements[index];
 
-  void makeElementNodeMap ()
-  {
-    std::function<void(IndexOctreeNode&)> traverse = [this, &traverse](IndexOctreeNode& node) {
-      for (unsigned i : node.indices)
-      {
-        this->addToElementNodeMap (i, node);
-      }
-      if (node.hasChildren ())
-      {
-        for (Child& c : node.children)
-        {
-          traverse (*c);
-        }
-      }
-    };
-    if (this->root)
+    assert (node.numElements > 0);
+
+    if (previous == Util::invalidIndex ())
+    {
+      assert (node.firstElement == index);
+      node.firstElement = next;
+    }
+    else
+    {
+      this->nextElements[previous] = next;
+    }
+    if (next != Util::invalidIndex ())
     {
-      traverse (*this->root);
+      this->previousElements[next] = previous;
     }
+    node.numElements--;
+    this->elementNodes[index] = Util::invalidIndex ();
   }
 
-  void addToElementNodeMap (unsigned int index, IndexOctreeNode& node)
+  template <typename F> void forEachElement (const IndexOctreeNode& node, const F& f) const
   {
-    if (index >= this->elementNodeMap.size ())
+    for (unsigned int i = node.firstElement; i != Util::invalidIndex ();
+         i = this->nextElements[i])
     {
-      this->elementNodeMap.resize (index + 1, nullptr);
+      f (i);
     }
-    assert (this->elementNodeMap[index] == nullptr);
-    this->elementNodeMap[index] = &node;
   }
 
   void makeParent (const glm::vec3& position)
   {
     assert (this->hasRoot ());
 
-    const glm::vec3 rootCenter = this->root->center;
-    const float     rootWidth = this->root->width;
-    const float     halfRootWidth = this->root->width * 0.5f;
+    const glm::vec3 rootCenter = this->nodes[this->root].center;
+    const float     rootWidth = this->nodes[this->root].width;
+    const float     halfRootWidth = rootWidth * 0.5f;
     glm::vec3       parentCenter;
     int             index = 0;
 
@@ -392,21 +268,34 @@ struct DynamicOctree::Impl
       index += 1;
     }
 
-    IndexOctreeNode* newRoot =
-      new IndexOctreeNode (parentCenter, rootWidth * 2.0f, this->root->depth - 1);
-    newRoot->makeChildren ();
-    newRoot->children[index] = std::move (this->root);
-    this->root.reset (newRoot);
+    const unsigned int newRoot =
+      this->makeNode (parentCenter, rootWidth * 2.0f, this->nodes[this->root].depth - 1);
+    this->makeChildren (newRoot);
+    this->deleteNode (this->nodes[newRoot].children[index]);
+    this->nodes[newRoot].children[index] = this->root;
+    this->root = newRoot;
   }
 
   void addElement (unsigned int index, const glm::vec3& position, float maxDimExtent)
   {
     assert (this->hasRoot ());
 
-    if (this->root->approxContains (position, maxDimExtent))
+    if (this->nodes[this->root].approxContains (position, maxDimExtent))
     {
-      IndexOctreeNode& node = this->root->addElement (index, position, maxDimExtent);
-      this->addToElementNodeMap (index, node);
+      unsigned int handle = this->root;
+
+      while (this->nodes[handle].insertIntoChild (maxDimExtent))
+      {
+        if (this->nodes[handle].hasChildren () == false)
+        {
+          this->makeChildren (handle);
+        }
+        const IndexOctreeNode& node = this->nodes[handle];
+        handle = node.children[node.childIndex (position)];
+
+        assert (this->nodes[handle].approxContains (position, maxDimExtent));
+      }
+      this->linkElement (index, handle);
     }
     else
     {
@@ -418,13 +307,13 @@ struct DynamicOctree::Impl
   void realignElement (unsigned int index, const glm::vec3& position, float maxDimExtent)
   {
     assert (this->hasRoot ());
-    assert (index < this->elementNodeMap.size ());
-    assert (this->elementNodeMap[index]);
+    assert (index < this->elementNodes.size ());
+    assert (this->elementNodes[index] != Util::invalidIndex ());
 
-    IndexOctreeNode* node = this->elementNodeMap[index];
+    const IndexOctreeNode& node = this->nodes[this->elementNodes[index]];
 
-    if (node->approxContains (position, maxDimExtent) == false ||
-        node->insertIntoChild (maxDimExtent))
+    if (node.approxContains (position, maxDimExtent) == false ||
+        node.insertIntoChild (maxDimExtent))
     {
       this->deleteElement (index);
       this->addElement (index, position, maxDimExtent);
@@ -433,17 +322,16 @@ struct DynamicOctree::Impl
 
   void deleteElement (unsigned int index)
   {
-    assert (index < this->elementNodeMap.size ());
-    assert (this->elementNodeMap[index]);
+    assert (index < this->elementNodes.size ());
+    assert (this->elementNodes[index] != Util::invalidIndex ());
 
-    this->elementNodeMap[index]->deleteElement (index);
-    this->elementNodeMap[index] = nullptr;
+    this->unlinkElement (index);
 
     if (this->hasRoot ())
     {
-      if (this->root->isEmpty ())
+      if (this->nodes[this->root].isEmpty ())
       {
-        this->root.reset ();
+        this->reset ();
       }
       else
       {
@@ -452,49 +340,89 @@ struct DynamicOctree::Impl
     }
   }
 
+  bool deleteEmptyChildren (unsigned int handle)
+  {
+    if (this->nodes[handle].hasChildren ())
+    {
+      bool allChildrenEmpty = true;
+
+      for (unsigned int c : this->nodes[handle].children)
+      {
+        if (this->deleteEmptyChildren (c) == false)
+        {
+          allChildrenEmpty = false;
+        }
+      }
+      if (allChildrenEmpty)
+      {
+        for (unsigned int c : this->nodes[handle].children)
+        {
+          this->deleteNode (c);
+        }
+        this->nodes[handle].children.fill (Util::invalidIndex ());
+      }
+    }
+    return this->nodes[handle].isEmpty ();
+  }
+
   void deleteEmptyChildren ()
   {
     if (this->hasRoot ())
     {
-      if (this->root->deleteEmptyChildren ())
+      if (this->deleteEmptyChildren (this->root))
       {
-        this->root.reset ();
+        this->reset ();
       }
     }
   }
 
   void updateIndices (const std::vector<unsigned int>& newIndices)
   {
-    for (unsigned int i = 0; i < newIndices.size (); i++)
+    const auto newIndex = [&newIndices](unsigned int i) {
+      return i == Util::invalidIndex () ? i : newIndices[i];
+    };
+
+    std::vector<unsigned int> elementNodes (newIndices.size (), Util::invalidIndex ());
+    std::vector<unsigned int> nextElements (newIndices.size (), Util::invalidIndex ());
+    std::vector<unsigned int> previousElements (newIndices.size (), Util::invalidIndex ());
+
+    for (unsigned int i = 0; i < this->elementNodes.size (); i++)
     {
-      const unsigned int newI = newIndices[i];
-      if (newI != Util::invalidIndex () && newI != i)
+      if (this->elementNodes[i] != Util::invalidIndex ())
       {
-        assert (i < this->elementNodeMap.size ());
-        assert (newI < this->elementNodeMap.size ());
-        assert (this->elementNodeMap[i]);
-        assert (this->elementNodeMap[newI] == nullptr);
+        const unsigned int newI = newIndices[i];
 
-        this->elementNodeMap[newI] = this->elementNodeMap[i];
-        this->elementNodeMap[i] = nullptr;
+        assert (newI != Util::invalidIndex ());
+        assert (elementNodes[newI] == Util::invalidIndex ());
+
+        elementNodes[newI] = this->elementNodes[i];
+        nextElements[newI] = newIndex (this->nextElements[i]);
+        previousElements[newI] = newIndex (this->previousElements[i]);
       }
     }
-    this->elementNodeMap.resize (newIndices.size ());
-
-    if (this->hasRoot ())
+    for (IndexOctreeNode& node : this->nodes)
     {
-      this->root->updateIndices (newIndices);
+      node.firstElement = newIndex (node.firstElement);
     }
+    this->elementNodes = std::move (elementNodes);
+    this->nextElements = std::move (nextElements);
+    this->previousElements = std::move (previousElements);
   }
 
   void shrinkRoot ()
   {
-    if (this->hasRoot () && this->root->indices.empty () && this->root->hasChildren ())
+    if (this->hasRoot () == false)
+    {
+      return;
+    }
+    const IndexOctreeNode& root = this->nodes[this->root];
+
+    if (root.numElements == 0 && root.hasChildren ())
     {
       int singleNonEmptyChildIndex = -1;
       for (int i = 0; i < 8; i++)
       {
-        if (this->root->children.at (i)->isEmpty () == false)
+        if (this->nodes[root.children[i]].isEmpty () == false)
         {
           if (singleNonEmptyChildIndex == -1)
           {
@@ -508,7 +436,19 @@ struct DynamicOctree::Impl
       }
       if (singleNonEmptyChildIndex != -1)
       {
-        this->root = std::move (this->root->children.at (singleNonEmptyChildIndex));
+        const unsigned int oldRoot = this->root;
+
+        this->root = root.children[singleNonEmptyChildIndex];
+
+        for (int i = 0; i < 8; i++)
+        {
+          if (i != singleNonEmptyChildIndex)
+          {
+            this->deleteNode (this->nodes[oldRoot].children[i]);
+          }
+        }
+        this->nodes[oldRoot].children.fill (Util::invalidIndex ());
+        this->deleteNode (oldRoot);
         this->shrinkRoot ();
       }
     }
@@ -516,11 +456,32 @@ struct DynamicOctree::Impl
 
   void reset ()
   {
-    this->root.reset ();
-    this->elementNodeMap.clear ();
+    this->nodes.clear ();
+    this->freeNodes.clear ();
+    this->root = Util::invalidIndex ();
+    this->elementNodes.clear ();
+    this->nextElements.clear ();
+    this->previousElements.clear ();
   }
 
 #ifdef DILAY_RENDER_OCTREE
+  void render (unsigned int handle, Camera& camera, Mesh& nodeMesh) const
+  {
+    const IndexOctreeNode& node = this->nodes[handle];
+
+    nodeMesh.position (node.center);
+    nodeMesh.scaling (glm::vec3 (node.width * 0.5f));
+    nodeMesh.renderLines (camera);
+
+    if (node.hasChildren ())
+    {
+      for (unsigned int c : node.children)
+      {
+        this->render (c, camera, nodeMesh);
+      }
+    }
+  }
+
   void render (Camera& camera) const
   {
     Mesh nodeMesh;
@@ -576,18 +537,60 @@ struct DynamicOctree::Impl
 
     if (this->hasRoot ())
     {
-      this->root->render (camera, nodeMesh);
+      this->render (this->root, camera, nodeMesh);
     }
   }
 #else
   void render (Camera&) const { DILAY_IMPOSSIBLE }
 #endif
 
+  template <typename T>
+  void containsOrIntersectsT (unsigned int handle, const T& t,
+                              const DynamicOctree::ContainsIntersectionCallback& f) const
+  {
+    const IndexOctreeNode& node = this->nodes[handle];
+    const PrimAABox        looseAABox = node.looseAABox ();
+    const bool             contains = t.contains (looseAABox);
+
+    if (contains || IntersectionUtil::intersects (t, looseAABox))
+    {
+      this->forEachElement (node, [contains, &f](unsigned int index) { f (contains, index); });
+
+      if (node.hasChildren ())
+      {
+        for (unsigned int c : node.children)
+        {
+          this->containsOrIntersectsT<T> (c, t, f);
+        }
+      }
+    }
+  }
+
+  template <typename T>
+  void intersectsT (unsigned int handle, const T& t,
+                    const DynamicOctree::IntersectionCallback& f) const
+  {
+    const IndexOctreeNode& node = this->nodes[handle];
+
+    if (IntersectionUtil::intersects (t, node.looseAABox ()))
+    {
+      this->forEachElement (node, f);
+
+      if (node.hasChildren ())
+      {
+        for (unsigned int c : node.children)
+        {
+          this->intersectsT<T> (c, t, f);
+        }
+      }
+    }
+  }
+
   void intersects (const PrimRay& ray, const DynamicOctree::IntersectionCallback& f) const
   {
     if (this->hasRoot ())
     {
-      return this->root->intersectsT<PrimRay> (ray, f);
+      return this->intersectsT<PrimRay> (this->root, ray, f);
     }
   }
 
@@ -595,7 +598,7 @@ struct DynamicOctree::Impl
   {
     if (this->hasRoot ())
     {
-      return this->root->intersectsT<PrimPlane> (plane, f);
+      return this->intersectsT<PrimPlane> (this->root, plane, f);
     }
   }
 
@@ -604,7 +607,7 @@ struct DynamicOctree::Impl
   {
     if (this->hasRoot ())
     {
-      return this->root->containsOrIntersectsT<PrimSphere> (sphere, f);
+      return this->containsOrIntersectsT<PrimSphere> (this->root, sphere, f);
     }
   }
 
@@ -612,7 +615,91 @@ struct DynamicOctree::Impl
   {
     if (this->hasRoot ())
     {
-      return this->root->containsOrIntersectsT<PrimAABox> (box, f);
+      return this->containsOrIntersectsT<PrimAABox> (this->root, box, f);
+    }
+  }
+
+  bool closestIntersection (const PrimRay& ray, const DynamicOctree::DistanceCallback& f) const
+  {
+    typedef std::pair<float, unsigned int> Entry;
+
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> queue;
+    bool                                                                hasIntersection = false;
+    float                                                               closest = 0.0f;
+
+    const auto enqueue = [this, &ray, &queue](unsigned int handle) {
+      const IndexOctreeNode& node = this->nodes[handle];
+      float                  t;
+
+      if (node.isEmpty () == false && IntersectionUtil::intersects (ray, node.looseAABox (), &t))
+      {
+        queue.emplace (t, handle);
+      }
+    };
+
+    if (this->hasRoot ())
+    {
+      enqueue (this->root);
+    }
+
+    while (queue.empty () == false && (hasIntersection == false || queue.top ().first < closest))
+    {
+      const IndexOctreeNode& node = this->nodes[queue.top ().second];
+      queue.pop ();
+
+      this->forEachElement (node, [&f, &hasIntersection, &closest](unsigned int index) {
+        float t;
+        if (f (index, t) && (hasIntersection == false || t < closest))
+        {
+          hasIntersection = true;
+          closest = t;
+        }
+      });
+      if (node.hasChildren ())
+      {
+        for (unsigned int c : node.children)
+        {
+          enqueue (c);
+        }
+      }
+    }
+    return hasIntersection;
+  }
+
+  void updateStatistics (unsigned int handle, IndexOctreeStatistics& stats) const
+  {
+    const IndexOctreeNode& node = this->nodes[handle];
+
+    stats.numNodes += 1;
+    stats.numElements += node.numElements;
+    stats.minDepth = glm::min (stats.minDepth, node.depth);
+    stats.maxDepth = glm::max (stats.maxDepth, node.depth);
+    stats.maxElementsPerNode = glm::max (stats.maxElementsPerNode, node.numElements);
+
+    auto e = stats.numElementsPerDepth.find (node.depth);
+    if (e == stats.numElementsPerDepth.end ())
+    {
+      stats.numElementsPerDepth.emplace (node.depth, node.numElements);
+    }
+    else
+    {
+      e->second = e->second + node.numElements;
+    }
+    e = stats.numNodesPerDepth.find (node.depth);
+    if (e == stats.numNodesPerDepth.end ())
+    {
+      stats.numNodesPerDepth.emplace (node.depth, 1);
+    }
+    else
+    {
+      e->second = e->second + 1;
+    }
+    if (node.hasChildren ())
+    {
+      for (unsigned int c : node.children)
+      {
+        this->updateStatistics (c, stats);
+      }
     }
   }
 
@@ -627,7 +714,7 @@ struct DynamicOctree::Impl
                                 IndexOctreeStatistics::DepthMap ()};
     if (this->hasRoot ())
     {
-      this->root->updateStatistics (stats);
+      this->updateStatistics (this->root, stats);
     }
     std::cout << "octree:"
               << "\n\tnum nodes:\t\t\t" << stats.numNodes << "\n\tnum elements:\t\t\t"
@@ -658,4 +745,6 @@ DELEGATE2_CONST (void, DynamicOctree, intersects, const PrimSphere&,
                  const DynamicOctree::ContainsIntersectionCallback&)
 DELEGATE2_CONST (void, DynamicOctree, intersects, const PrimAABox&,
                  const DynamicOctree::ContainsIntersectionCallback&)
+DELEGATE2_CONST (bool, DynamicOctree, closestIntersection, const PrimRay&,
+                 const DynamicOctree::DistanceCallback&)
 DELEGATE_CONST (void, DynamicOctree, printStatistics)
@@ -23,6 +23,7 @@ public:
 
   typedef std::function<void(unsigned int)>       IntersectionCallback;
   typedef std::function<void(bool, unsigned int)> ContainsIntersectionCallback;
+  typedef std::function<bool(unsigned int, float&)> DistanceCallback;
 
   bool hasRoot () const;
   void setupRoot (const glm::vec3&, float);
@@ -38,6 +39,12 @@ public:
   void intersects (const PrimPlane&, const IntersectionCallback&) const;
   void intersects (const PrimSphere&, const ContainsIntersectionCallback&) const;
   void intersects (const PrimAABox&, const ContainsIntersectionCallback&) const;
+
+  /* Visits nodes in the order in which the ray enters them and stops as soon as no remaining node
+   * can hold an element that is closer than the closest one found so far.  The callback returns
+   * whether an element is intersected and, if so, sets its distance along the ray.
+   */
+  bool closestIntersection (const PrimRay&, const DistanceCallback&) const;
   void printStatistics () const;
 
 private:
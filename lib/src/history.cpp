@@ -5,6 +5,7 @@
 #include <list>
 #include <vector>
 #include "config.hpp"
+#include "dynamic/mesh-delta.hpp"
 #include "dynamic/mesh.hpp"
 #include "history.hpp"
 #include "maybe.hpp"
@@ -31,12 +32,15 @@ namespace
 
   struct SceneSnapshot
   {
-    const SnapshotConfig   config;
-    std::list<DynamicMesh> dynamicMeshes;
-    std::list<SketchMesh>  sketchMeshes;
+    const SnapshotConfig        config;
+    std::list<DynamicMesh>      dynamicMeshes;
+    std::list<SketchMesh>       sketchMeshes;
+    std::list<DynamicMeshDelta> dynamicMeshDeltas;
+    bool                        isDelta;
 
     SceneSnapshot (const SnapshotConfig& c)
       : config (c)
+      , isDelta (false)
     {
     }
   };
@@ -60,6 +64,60 @@ namespace
     return snapshot;
   }
 
+  // Stops recording and falls back to a full snapshot if some mesh could not be recorded
+  void stopRecordingDeltas (SceneSnapshot& snapshot)
+  {
+    if (snapshot.isDelta)
+    {
+      bool keepDeltas = true;
+      for (const DynamicMeshDelta& delta : snapshot.dynamicMeshDeltas)
+      {
+        keepDeltas = keepDeltas && delta.hasOriginal () == false;
+      }
+
+      if (keepDeltas == false)
+      {
+        for (DynamicMeshDelta& delta : snapshot.dynamicMeshDeltas)
+        {
+          if (delta.hasOriginal ())
+          {
+            snapshot.dynamicMeshes.emplace_back (std::move (delta.original ()));
+          }
+          else
+          {
+            snapshot.dynamicMeshes.emplace_back (delta.mesh ());
+            snapshot.dynamicMeshes.back ().applyDelta (delta);
+          }
+        }
+        snapshot.dynamicMeshDeltas.clear ();
+        snapshot.isDelta = false;
+      }
+      else
+      {
+        for (DynamicMeshDelta& delta : snapshot.dynamicMeshDeltas)
+        {
+          delta.stopRecording ();
+        }
+      }
+    }
+  }
+
+  void applyDeltas (SceneSnapshot& snapshot, State& state)
+  {
+    assert (snapshot.isDelta);
+    assert (snapshot.dynamicMeshDeltas.size () == state.scene ().numDynamicMeshes ());
+
+    auto delta = snapshot.dynamicMeshDeltas.begin ();
+    state.scene ().forEachMesh ([&delta](DynamicMesh& mesh) {
+      if (delta->isEmpty () == false)
+      {
+        mesh.applyDelta (*delta);
+        mesh.bufferData ();
+      }
+      ++delta;
+    });
+  }
+
   void resetToSnapshot (const SceneSnapshot& snapshot, State& state)
   {
     Scene& scene = state.scene ();
@@ -105,17 +163,45 @@ struct History::Impl
     this->snapshot (scene, SnapshotConfig (false, true));
   }
 
+  void snapshotDynamicMeshDeltas (Scene& scene)
+  {
+    this->prepareSnapshot ();
+    this->past.emplace_front (SnapshotConfig (true, false));
+
+    SceneSnapshot& snapshot = this->past.front ();
+    snapshot.isDelta = true;
+
+    scene.forEachMesh ([&snapshot](DynamicMesh& mesh) {
+      snapshot.dynamicMeshDeltas.emplace_back ();
+      snapshot.dynamicMeshDeltas.back ().startRecording (mesh);
+    });
+  }
+
   void snapshot (const Scene& scene, const SnapshotConfig& config)
+  {
+    this->prepareSnapshot ();
+    this->past.push_front (sceneSnapshot (scene, config));
+  }
+
+  void prepareSnapshot ()
   {
     assert (undoDepth > 0);
 
+    this->stopRecording ();
     this->future.clear ();
 
     while (this->past.size () >= this->undoDepth)
     {
       this->past.pop_back ();
     }
-    this->past.push_front (sceneSnapshot (scene, config));
+  }
+
+  void stopRecording ()
+  {
+    if (this->past.empty () == false)
+    {
+      stopRecordingDeltas (this->past.front ());
+    }
   }
 
   void dropPastSnapshot ()
@@ -136,7 +222,14 @@ struct History::Impl
 
   void undo (State& state)
   {
-    if (this->past.empty () == false)
+    this->stopRecording ();
+
+    if (this->past.empty () == false && this->past.front ().isDelta)
+    {
+      applyDeltas (this->past.front (), state);
+      this->future.splice (this->future.begin (), this->past, this->past.begin ());
+    }
+    else if (this->past.empty () == false)
     {
       const SnapshotConfig& config = this->past.front ().config;
 
@@ -148,7 +241,14 @@ struct History::Impl
 
   void redo (State& state)
   {
-    if (this->future.empty () == false)
+    this->stopRecording ();
+
+    if (this->future.empty () == false && this->future.front ().isDelta)
+    {
+      applyDeltas (this->future.front (), state);
+      this->past.splice (this->past.begin (), this->future, this->future.begin ());
+    }
+    else if (this->future.empty () == false)
     {
       const SnapshotConfig& config = this->future.front ().config;
 
@@ -160,7 +260,8 @@ struct History::Impl
 
   bool hasRecentDynamicMesh () const
   {
-    return this->past.empty () == false && this->past.front ().config.snapshotDynamicMeshes;
+    return this->past.empty () == false && this->past.front ().config.snapshotDynamicMeshes &&
+           this->past.front ().isDelta == false;
   }
 
   void forEachRecentDynamicMesh (const std::function<void(const DynamicMesh&)>& f) const
@@ -189,6 +290,8 @@ DELEGATE1_BIG3 (History, const Config&)
 DELEGATE1 (void, History, snapshotAll, const Scene&)
 DELEGATE1 (void, History, snapshotDynamicMeshes, const Scene&)
 DELEGATE1 (void, History, snapshotSketchMeshes, const Scene&)
+DELEGATE1 (void, History, snapshotDynamicMeshDeltas, Scene&)
+DELEGATE (void, History, stopRecording)
 DELEGATE (void, History, dropPastSnapshot)
 DELEGATE (void, History, dropFutureSnapshot)
 DELEGATE1 (void, History, undo, State&)
@@ -21,6 +21,8 @@ public:
   void snapshotAll (const Scene&);
   void snapshotDynamicMeshes (const Scene&);
   void snapshotSketchMeshes (const Scene&);
+  void snapshotDynamicMeshDeltas (Scene&);
+  void stopRecording ();
   void dropPastSnapshot ();
   void dropFutureSnapshot ();
   void undo (State&);
@@ -2,8 +2,16 @@
  * Copyright © 2015-2017 Alexander Bau
  * Use and redistribute under the terms of the GNU General Public License
  */
+#include <QByteArray>
+#include <QFile>
 #include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
 #include <fstream>
+#include <istream>
+#include <limits>
+#include <locale>
 #include <sstream>
 #include "dynamic/mesh.hpp"
 #include "import-export.hpp"
@@ -23,12 +31,6 @@ namespace
     return os;
   }
 
-  std::istream& operator>> (std::istream& is, glm::vec3& v)
-  {
-    is >> v.x >> v.y >> v.z;
-    return is;
-  }
-
   void toDlyFile (std::ostream& stream, const Mesh& mesh)
   {
     stream << "o\n";
@@ -89,6 +91,514 @@ namespace
       }
     }
   }
+
+  /* Tokenizer of the text formats.  It works in place on the whole content of a file and does not
+   * allocate.  Numbers are parsed independently of the current locale.
+   */
+  struct TextParser
+  {
+    const char*  pos;
+    const char*  end;
+    const char*  keyword;
+    std::size_t  keywordLength;
+    unsigned int lineNumber;
+
+    TextParser (const char* data, std::size_t size)
+      : pos (data)
+      , end (data + size)
+      , keyword (nullptr)
+      , keywordLength (0)
+      , lineNumber (0)
+    {
+    }
+
+    static bool isSpace (char c)
+    {
+      return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+    }
+
+    static bool isDigit (char c) { return c >= '0' && c <= '9'; }
+
+    bool isDelimiter () const
+    {
+      return this->pos == this->end || *this->pos == '\n' || TextParser::isSpace (*this->pos);
+    }
+
+    void skipSpace ()
+    {
+      while (this->pos != this->end && TextParser::isSpace (*this->pos))
+      {
+        this->pos++;
+      }
+    }
+
+    bool isAtLineEnd ()
+    {
+      this->skipSpace ();
+      return this->pos == this->end || *this->pos == '\n';
+    }
+
+    // moves to the beginning of the next line, which may be the first one
+    bool nextLine ()
+    {
+      if (this->lineNumber > 0)
+      {
+        const void* newLine = std::memchr (this->pos, '\n', this->end - this->pos);
+        this->pos = newLine ? static_cast<const char*> (newLine) + 1 : this->end;
+      }
+      if (this->pos == this->end)
+      {
+        return false;
+      }
+      else
+      {
+        this->lineNumber++;
+        return true;
+      }
+    }
+
+    bool parseKeyword ()
+    {
+      this->skipSpace ();
+      this->keyword = this->pos;
+
+      while (this->isDelimiter () == false)
+      {
+        this->pos++;
+      }
+      this->keywordLength = this->pos - this->keyword;
+      return this->keywordLength > 0;
+    }
+
+    template <std::size_t N> bool isKeyword (const char (&k)[N]) const
+    {
+      return this->keywordLength == N - 1 && std::memcmp (this->keyword, k, N - 1) == 0;
+    }
+
+    bool parse (unsigned int& value)
+    {
+      this->skipSpace ();
+
+      std::uint64_t v = 0;
+      const char*   begin = this->pos;
+
+      while (this->pos != this->end && TextParser::isDigit (*this->pos))
+      {
+        v = (10 * v) + (*this->pos - '0');
+        this->pos++;
+
+        if (v > std::numeric_limits<unsigned int>::max ())
+        {
+          return false;
+        }
+      }
+      value = (unsigned int) v;
+      return this->pos != begin;
+    }
+
+    // parses the first index of a `v/vt/vn` triple
+    bool parseIndex (unsigned int& value)
+    {
+      if (this->parse (value) && value > 0)
+      {
+        while (this->isDelimiter () == false)
+        {
+          this->pos++;
+        }
+        return true;
+      }
+      else
+      {
+        return false;
+      }
+    }
+
+    bool parse (float& value)
+    {
+      this->skipSpace ();
+
+      const char*   p = this->pos;
+      bool          isNegative = false;
+      std::uint64_t mantissa = 0;
+      int           exponent = 0;
+      bool          hasDigits = false;
+      bool          isTruncated = false;
+
+      if (p != this->end && (*p == '-' || *p == '+'))
+      {
+        isNegative = *p == '-';
+        p++;
+      }
+
+      // digits beyond the precision of the mantissa only affect the exponent
+      auto addDigit = [&mantissa, &exponent, &hasDigits, &isTruncated](char c, bool isFraction) {
+        hasDigits = true;
+
+        if (mantissa < 100000000000000000ull)
+        {
+          mantissa = (10 * mantissa) + (c - '0');
+          exponent -= isFraction ? 1 : 0;
+        }
+        else
+        {
+          exponent += isFraction ? 0 : 1;
+          isTruncated = isTruncated || c != '0';
+        }
+      };
+
+      for (; p != this->end && TextParser::isDigit (*p); p++)
+      {
+        addDigit (*p, false);
+      }
+      if (p != this->end && *p == '.')
+      {
+        for (p++; p != this->end && TextParser::isDigit (*p); p++)
+        {
+          addDigit (*p, true);
+        }
+      }
+      if (hasDigits == false)
+      {
+        return false;
+      }
+      if (p != this->end && (*p == 'e' || *p == 'E'))
+      {
+        bool isNegativeExponent = false;
+        int  e = 0;
+
+        p++;
+        if (p != this->end && (*p == '-' || *p == '+'))
+        {
+          isNegativeExponent = *p == '-';
+          p++;
+        }
+        if (p == this->end || TextParser::isDigit (*p) == false)
+        {
+          return false;
+        }
+        for (; p != this->end && TextParser::isDigit (*p); p++)
+        {
+          e = glm::min ((10 * e) + (*p - '0'), 100000);
+        }
+        exponent += isNegativeExponent ? -e : e;
+      }
+
+      /* Mantissas up to 2^53 and powers of ten up to 10^22 are exact doubles, so a single
+       * multiplication or division yields the correctly rounded double.  Rounding it to float may
+       * be off by one ulp for inputs that are very close to the midpoint of two floats, but not for
+       * the shortest representation of a float.  Other inputs (long mantissas, large exponents)
+       * are rare and left to the standard library, which rounds correctly.
+       */
+      static const double powersOf10[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+                                          1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+                                          1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+      if (isTruncated || mantissa > (std::uint64_t (1) << 53) || exponent < -22 || exponent > 22)
+      {
+        return this->parseSlow (p, value);
+      }
+
+      double v = double(mantissa);
+
+      if (exponent < 0)
+      {
+        v /= powersOf10[-exponent];
+      }
+      else
+      {
+        v *= powersOf10[exponent];
+      }
+      value = float(isNegative ? -v : v);
+      this->pos = p;
+      return true;
+    }
+
+    // parses [pos, end) with the classic locale
+    bool parseSlow (const char* end, float& value)
+    {
+      std::istringstream stream (std::string (this->pos, end));
+      stream.imbue (std::locale::classic ());
+
+      if (stream >> value)
+      {
+        this->pos = end;
+        return true;
+      }
+      else
+      {
+        return false;
+      }
+    }
+
+    bool parse (glm::vec3& v)
+    {
+      return this->parse (v.x) && this->parse (v.y) && this->parse (v.z);
+    }
+  };
+
+  /* Binary files start with `binaryMagic`, the format version and a byte order mark.  Each chunk
+   * consists of its type, reserved flags, the size of its payload in bytes and the payload.
+   * Payloads only contain 4-byte values, so arrays of a memory-mapped file are properly aligned.
+   */
+  const char          binaryMagic[8] = {'\x89', 'D', 'L', 'Y', '\r', '\n', '\x1a', '\n'};
+  const std::uint32_t binaryVersion = 1;
+  const std::uint32_t binaryByteOrder = 0x01020304;
+
+  bool hasBinaryMagic (const char* data, std::size_t size)
+  {
+    return size >= sizeof (binaryMagic) &&
+           std::memcmp (data, binaryMagic, sizeof (binaryMagic)) == 0;
+  }
+
+  enum class BinaryChunk : std::uint32_t
+  {
+    Mesh = 1,
+    SketchTree = 2,
+    SketchPath = 3
+  };
+
+  struct BinaryWriter
+  {
+    std::ostream&     stream;
+    std::vector<char> payload;
+
+    BinaryWriter (std::ostream& s)
+      : stream (s)
+    {
+    }
+
+    template <typename T> void write (const T& value) { this->write (&value, 1); }
+
+    template <typename T> void write (const T* values, std::size_t n)
+    {
+      this->stream.write (reinterpret_cast<const char*> (values), n * sizeof (T));
+    }
+
+    template <typename T> void add (const T& value) { this->add (&value, 1); }
+
+    template <typename T> void add (const T* values, std::size_t n)
+    {
+      static_assert (sizeof (T) % 4 == 0, "Unexpected size of chunk data");
+
+      const char* bytes = reinterpret_cast<const char*> (values);
+      this->payload.insert (this->payload.end (), bytes, bytes + (n * sizeof (T)));
+    }
+
+    void writeHeader ()
+    {
+      this->write (binaryMagic, sizeof (binaryMagic));
+      this->write (binaryVersion);
+      this->write (binaryByteOrder);
+    }
+
+    void writeChunk (BinaryChunk type)
+    {
+      this->write (std::uint32_t (type));
+      this->write (std::uint32_t (0));
+      this->write (std::uint64_t (this->payload.size ()));
+      this->write (this->payload.data (), this->payload.size ());
+      this->payload.clear ();
+    }
+  };
+
+  struct BinaryReader
+  {
+    const char* data;
+    std::size_t size;
+    std::size_t offset;
+
+    BinaryReader (const char* d, std::size_t s)
+      : data (d)
+      , size (s)
+      , offset (0)
+    {
+    }
+
+    bool isAtEnd () const { return this->offset == this->size; }
+
+    // returns a pointer to `n` values without copying them, or `nullptr` if the data is too short
+    template <typename T> const T* view (std::size_t n)
+    {
+      if (n > (this->size - this->offset) / sizeof (T))
+      {
+        return nullptr;
+      }
+      const T* values = reinterpret_cast<const T*> (this->data + this->offset);
+      assert (reinterpret_cast<std::uintptr_t> (values) % alignof (T) == 0);
+
+      this->offset += n * sizeof (T);
+      return values;
+    }
+
+    template <typename T> bool read (T& value) { return this->read (&value, 1); }
+
+    template <typename T> bool read (T* values, std::size_t n)
+    {
+      if (n > (this->size - this->offset) / sizeof (T))
+      {
+        return false;
+      }
+      std::memcpy (values, this->data + this->offset, n * sizeof (T));
+      this->offset += n * sizeof (T);
+      return true;
+    }
+  };
+
+  void toBinaryDlyFile (BinaryWriter& writer, const Mesh& mesh)
+  {
+    writer.payload.reserve ((2 * sizeof (std::uint32_t)) +
+                            (mesh.numVertices () * 2 * sizeof (glm::vec3)) +
+                            (mesh.numIndices () * sizeof (std::uint32_t)));
+
+    writer.add (std::uint32_t (mesh.numVertices ()));
+    writer.add (std::uint32_t (mesh.numIndices ()));
+
+    for (unsigned int i = 0; i < mesh.numVertices (); i++)
+    {
+      writer.add (mesh.vertex (i));
+      writer.add (mesh.normal (i));
+    }
+    for (unsigned int i = 0; i < mesh.numIndices (); i++)
+    {
+      writer.add (std::uint32_t (mesh.index (i)));
+    }
+    writer.writeChunk (BinaryChunk::Mesh);
+  }
+
+  unsigned int toBinaryDlyFile (BinaryWriter& writer, const SketchNode& node,
+                                unsigned int parentIndex, unsigned nodeIndex)
+  {
+    writer.add (std::uint32_t (parentIndex));
+    writer.add (node.data ().center ());
+    writer.add (node.data ().radius ());
+
+    unsigned int childIndex = nodeIndex;
+
+    node.forEachConstChild ([&writer, nodeIndex, &childIndex](const SketchNode& child) {
+      childIndex = toBinaryDlyFile (writer, child, nodeIndex, childIndex + 1);
+    });
+    return childIndex;
+  }
+
+  void toBinaryDlyFile (BinaryWriter& writer, const SketchPath& path)
+  {
+    if (path.isEmpty () == false)
+    {
+      writer.add (path.intersectionFirst ());
+      writer.add (path.intersectionLast ());
+      writer.add (std::uint32_t (path.spheres ().size ()));
+
+      for (const PrimSphere& s : path.spheres ())
+      {
+        writer.add (s.center ());
+        writer.add (s.radius ());
+      }
+      writer.writeChunk (BinaryChunk::SketchPath);
+    }
+  }
+
+  void toBinaryDlyFile (BinaryWriter& writer, const SketchTree& tree, const SketchPaths& paths)
+  {
+    if (tree.hasRoot () || paths.empty () == false)
+    {
+      std::uint32_t numNodes = 0;
+      writer.add (numNodes);
+
+      if (tree.hasRoot ())
+      {
+        numNodes = toBinaryDlyFile (writer, tree.root (), Util::invalidIndex (), 0) + 1;
+        std::memcpy (writer.payload.data (), &numNodes, sizeof (numNodes));
+      }
+      writer.writeChunk (BinaryChunk::SketchTree);
+
+      for (const SketchPath& p : paths)
+      {
+        toBinaryDlyFile (writer, p);
+      }
+    }
+  }
+
+  bool fromBinaryDlyChunk (BinaryReader& reader, Mesh& mesh)
+  {
+    std::uint32_t numVertices, numIndices;
+
+    if (reader.read (numVertices) == false || reader.read (numIndices) == false)
+    {
+      return false;
+    }
+    const float*         vertices = reader.view<float> (std::size_t (numVertices) * 6);
+    const std::uint32_t* indices = reader.view<std::uint32_t> (numIndices);
+
+    if (vertices == nullptr || indices == nullptr || numIndices % 3 != 0 ||
+        std::any_of (indices, indices + numIndices,
+                     [numVertices](std::uint32_t i) { return i >= numVertices; }))
+    {
+      return false;
+    }
+    mesh.addVertices (vertices, numVertices);
+    mesh.addIndices (indices, numIndices);
+    return true;
+  }
+
+  bool fromBinaryDlyChunk (BinaryReader& reader, SketchMesh& sketch)
+  {
+    std::uint32_t            numNodes;
+    std::vector<SketchNode*> nodes;
+
+    if (reader.read (numNodes) == false)
+    {
+      return false;
+    }
+    for (std::uint32_t i = 0; i < numNodes; i++)
+    {
+      std::uint32_t parentIndex;
+      glm::vec3     center;
+      float         radius;
+
+      if (reader.read (parentIndex) == false || reader.read (center) == false ||
+          reader.read (radius) == false)
+      {
+        return false;
+      }
+      else if (i == 0)
+      {
+        nodes.push_back (&sketch.tree ().emplaceRoot (PrimSphere (center, radius)));
+      }
+      else if (parentIndex < nodes.size ())
+      {
+        nodes.push_back (&nodes.at (parentIndex)->emplaceChild (PrimSphere (center, radius)));
+      }
+      else
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool fromBinaryDlyChunk (BinaryReader& reader, SketchPath& path)
+  {
+    glm::vec3     intersectionFirst, intersectionLast;
+    std::uint32_t numSpheres;
+
+    if (reader.read (intersectionFirst) == false || reader.read (intersectionLast) == false ||
+        reader.read (numSpheres) == false)
+    {
+      return false;
+    }
+    for (std::uint32_t i = 0; i < numSpheres; i++)
+    {
+      glm::vec3 center;
+      float     radius;
+
+      if (reader.read (center) == false || reader.read (radius) == false)
+      {
+        return false;
+      }
+      path.addSphere (i == 0 ? intersectionFirst : intersectionLast, center, radius);
+    }
+    return true;
+  }
 };
 
 namespace ImportExport
@@ -106,13 +616,49 @@ namespace ImportExport
     }
   }
 
-  bool toDlyFile (const std::string& fileName, Scene& scene, bool isObjFile)
+  void toBinaryDlyFile (std::ostream& stream, Scene& scene)
+  {
+    BinaryWriter writer (stream);
+
+    writer.writeHeader ();
+
+    scene.forEachMesh ([&writer](DynamicMesh& mesh) {
+      mesh.prune ();
+      ::toBinaryDlyFile (writer, mesh.mesh ());
+    });
+    scene.forEachConstMesh ([&writer](const SketchMesh& mesh) {
+      ::toBinaryDlyFile (writer, mesh.tree (), mesh.paths ());
+    });
+  }
+
+  void toBinaryDlyHeader (std::ostream& stream) { BinaryWriter (stream).writeHeader (); }
+
+  void toBinaryDlyChunk (std::ostream& stream, const Mesh& mesh)
+  {
+    BinaryWriter writer (stream);
+    ::toBinaryDlyFile (writer, mesh);
+  }
+
+  void toBinaryDlyChunks (std::ostream& stream, const SketchTree& tree, const SketchPaths& paths)
   {
-    std::ofstream file (fileName);
+    BinaryWriter writer (stream);
+    ::toBinaryDlyFile (writer, tree, paths);
+  }
 
+  bool toDlyFile (const std::string& fileName, Scene& scene, Format format)
+  {
+    std::ofstream file (fileName, format == Format::BinaryDly ? std::ios::out | std::ios::binary
+                                                              : std::ios::out);
     if (file.is_open ())
     {
-      ImportExport::toDlyFile (file, scene, isObjFile);
+      if (format == Format::BinaryDly)
+      {
+        ImportExport::toBinaryDlyFile (file, scene);
+      }
+      else
+      {
+        ImportExport::toDlyFile (file, scene, format == Format::Obj);
+      }
       file.close ();
       return true;
     }
@@ -124,117 +670,87 @@ namespace ImportExport
 
   bool fromDlyFile (std::istream& stream, const Config& config, Scene& scene)
   {
-    unsigned int       lineNumber = 0;
-    std::istringstream lineStream;
+    std::string data;
+    char        block[1 << 16];
 
+    while (stream.read (block, sizeof (block)) || stream.gcount () > 0)
+    {
+      data.append (block, stream.gcount ());
+    }
+    return ImportExport::fromDlyFile (data.data (), data.size (), config, scene);
+  }
+
+  bool fromDlyFile (const char* data, std::size_t size, const Config& config, Scene& scene)
+  {
+    TextParser               parser (data, size);
     std::vector<Mesh>        meshes;
     std::vector<SketchNode*> nodes;
     SketchMesh*              sketch = nullptr;
     SketchPath*              sketchPath = nullptr;
     glm::vec3                intersectionFirst, intersectionLast;
 
-    auto extractFirst = [](const std::string& string, unsigned int& value) -> bool {
-      auto slashPos = string.find ('/');
-      return Util::fromString (string.substr (0, slashPos), value);
-    };
-
-    auto nextLine = [&stream, &lineNumber, &lineStream]() -> bool {
-      std::string line;
-      std::getline (stream, line);
-
-      if (stream)
+    auto currentMesh = [&meshes]() -> Mesh& {
+      if (meshes.empty ())
       {
-        lineNumber++;
-        lineStream.clear ();
-        lineStream.str (line);
-        return true;
-      }
-      else
-      {
-        return false;
+        meshes.push_back (Mesh ());
       }
+      return meshes.back ();
     };
 
-    while (nextLine ())
+    while (parser.nextLine ())
     {
-      std::string keyword;
-      lineStream >> keyword;
+      const unsigned int lineNumber = parser.lineNumber;
 
-      if (lineStream.fail () == false)
+      if (parser.parseKeyword ())
       {
-        if (keyword == "o")
+        if (parser.isKeyword ("o"))
         {
           meshes.push_back (Mesh ());
         }
-        else if (keyword == "v")
+        else if (parser.isKeyword ("v"))
         {
           glm::vec3 vertex;
-          lineStream >> vertex;
 
-          if (lineStream.fail ())
+          if (parser.parse (vertex) == false)
           {
             DILAY_WARN ("could not parse vertex at line %u", lineNumber)
             return false;
           }
           else
           {
-            if (meshes.empty ())
-            {
-              meshes.push_back (Mesh ());
-            }
-            meshes.back ().addVertex (vertex);
+            currentMesh ().addVertex (vertex);
           }
         }
-        else if (keyword == "f")
+        else if (parser.isKeyword ("f"))
         {
-          std::string  v1String, v2String, v3String;
-          unsigned int v1, v2, v3;
-
-          lineStream >> v1String >> v2String >> v3String;
+          unsigned int v1, v2, v3, v4;
 
-          if (lineStream.fail () || extractFirst (v1String, v1) == false ||
-              extractFirst (v2String, v2) == false || extractFirst (v3String, v3) == false)
+          if (parser.parseIndex (v1) == false || parser.parseIndex (v2) == false ||
+              parser.parseIndex (v3) == false)
+          {
+            DILAY_WARN ("could not parse face at line %u", lineNumber)
+            return false;
+          }
+          else if (parser.isAtLineEnd ())
+          {
+            MeshUtil::addFace (currentMesh (), v1 - 1, v2 - 1, v3 - 1);
+          }
+          else if (parser.parseIndex (v4) == false)
           {
             DILAY_WARN ("could not parse face at line %u", lineNumber)
             return false;
           }
           else
           {
-            std::string  v4String;
-            unsigned int v4;
-            lineStream >> v4String;
-
-            if (lineStream.fail ())
-            {
-              lineStream.clear ();
-
-              if (meshes.empty ())
-              {
-                meshes.push_back (Mesh ());
-              }
-              MeshUtil::addFace (meshes.back (), v1 - 1, v2 - 1, v3 - 1);
-            }
-            else if (extractFirst (v4String, v4) == false)
-            {
-              DILAY_WARN ("could not parse face at line %u", lineNumber)
-              return false;
-            }
-            else
-            {
-              if (meshes.empty ())
-              {
-                meshes.push_back (Mesh ());
-              }
-              MeshUtil::addFace (meshes.back (), v1 - 1, v2 - 1, v3 - 1, v4 - 1);
-            }
+            MeshUtil::addFace (currentMesh (), v1 - 1, v2 - 1, v3 - 1, v4 - 1);
           }
         }
-        else if (keyword == "dly_sketch_mesh")
+        else if (parser.isKeyword ("dly_sketch_mesh"))
         {
           nodes.clear ();
           sketch = &scene.newSketchMesh (config, SketchTree ());
         }
-        else if (keyword == "dly_sketch_node")
+        else if (parser.isKeyword ("dly_sketch_node"))
         {
           if (sketch == nullptr)
           {
@@ -246,9 +762,8 @@ namespace ImportExport
           glm::vec3    center;
           float        radius;
 
-          lineStream >> nodeIndex >> parentIndex >> center >> radius;
-
-          if (lineStream.fail ())
+          if (parser.parse (nodeIndex) == false || parser.parse (parentIndex) == false ||
+              parser.parse (center) == false || parser.parse (radius) == false)
           {
             DILAY_WARN ("could not parse sketch node at line %u", lineNumber)
             return false;
@@ -276,11 +791,10 @@ namespace ImportExport
             return false;
           }
         }
-        else if (keyword == "dly_sketch_path")
+        else if (parser.isKeyword ("dly_sketch_path"))
         {
-          lineStream >> intersectionFirst >> intersectionLast;
-
-          if (lineStream.fail ())
+          if (parser.parse (intersectionFirst) == false ||
+              parser.parse (intersectionLast) == false)
           {
             DILAY_WARN ("could not parse sketch path at line %u", lineNumber)
             return false;
@@ -295,14 +809,12 @@ namespace ImportExport
             return false;
           }
         }
-        else if (keyword == "dly_sketch_sphere")
+        else if (parser.isKeyword ("dly_sketch_sphere"))
         {
           glm::vec3 center;
           float     radius;
 
-          lineStream >> center >> radius;
-
-          if (lineStream.fail ())
+          if (parser.parse (center) == false || parser.parse (radius) == false)
           {
             DILAY_WARN ("could not parse sketch sphere at line %u", lineNumber)
             return false;
@@ -347,13 +859,116 @@ namespace ImportExport
     }
   }
 
+  bool fromBinaryDlyFile (const char* data, std::size_t size, const Config& config, Scene& scene)
+  {
+    BinaryReader      reader (data, size);
+    const char*       magic = reader.view<char> (sizeof (binaryMagic));
+    std::uint32_t     version, byteOrder;
+    std::vector<Mesh> meshes;
+    SketchMesh*       sketch = nullptr;
+
+    if (magic == nullptr || std::memcmp (magic, binaryMagic, sizeof (binaryMagic)) != 0 ||
+        reader.read (version) == false || reader.read (byteOrder) == false)
+    {
+      DILAY_WARN ("could not parse header of binary file")
+      return false;
+    }
+    else if (version > binaryVersion)
+    {
+      DILAY_WARN ("unsupported version %u of binary file", version)
+      return false;
+    }
+    else if (byteOrder != binaryByteOrder)
+    {
+      DILAY_WARN ("unsupported byte order of binary file")
+      return false;
+    }
+
+    while (reader.isAtEnd () == false)
+    {
+      std::uint32_t type, flags;
+      std::uint64_t payloadSize;
+
+      if (reader.read (type) == false || reader.read (flags) == false ||
+          reader.read (payloadSize) == false || payloadSize > reader.size - reader.offset ||
+          payloadSize % 4 != 0)
+      {
+        DILAY_WARN ("could not parse chunk header at offset %u", (unsigned int) reader.offset)
+        return false;
+      }
+      const std::size_t offset = reader.offset;
+      BinaryReader      chunk (reader.view<char> (payloadSize), payloadSize);
+      bool              success = true;
+
+      switch (BinaryChunk (type))
+      {
+        case BinaryChunk::Mesh:
+          meshes.push_back (Mesh ());
+          success = fromBinaryDlyChunk (chunk, meshes.back ());
+          break;
+
+        case BinaryChunk::SketchTree:
+          sketch = &scene.newSketchMesh (config, SketchTree ());
+          success = fromBinaryDlyChunk (chunk, *sketch);
+          break;
+
+        case BinaryChunk::SketchPath:
+          success = sketch && fromBinaryDlyChunk (chunk, sketch->addPath (SketchPath ()));
+          break;
+
+        // chunks of newer versions are skipped
+        default:
+          break;
+      }
+      if (success == false)
+      {
+        DILAY_WARN ("could not parse chunk at offset %u", (unsigned int) offset)
+        return false;
+      }
+    }
+    meshes.erase (std::remove_if (meshes.begin (), meshes.end (),
+                                  [](Mesh& m) { return m.numVertices () == 0; }),
+                  meshes.end ());
+
+    if (std::all_of (meshes.begin (), meshes.end (),
+                     [](Mesh& m) { return MeshUtil::checkConsistency (m); }))
+    {
+      for (Mesh& m : meshes)
+      {
+        scene.newDynamicMesh (config, m);
+      }
+      return true;
+    }
+    else
+    {
+      return false;
+    }
+  }
+
   bool fromDlyFile (const std::string& fileName, const Config& config, Scene& scene)
   {
-    std::ifstream file (fileName);
+    QFile file (QString::fromStdString (fileName));
 
-    if (file.is_open ())
+    if (file.open (QIODevice::ReadOnly))
     {
-      const bool success = ImportExport::fromDlyFile (file, config, scene);
+      auto parse = [&config, &scene](const char* data, std::size_t size) {
+        return hasBinaryMagic (data, size)
+                 ? ImportExport::fromBinaryDlyFile (data, size, config, scene)
+                 : ImportExport::fromDlyFile (data, size, config, scene);
+      };
+      const uchar* data = file.size () > 0 ? file.map (0, file.size ()) : nullptr;
+      bool         success;
+
+      if (data)
+      {
+        success = parse (reinterpret_cast<const char*> (data), file.size ());
+        file.unmap (const_cast<uchar*> (data));
+      }
+      else
+      {
+        const QByteArray bytes = file.readAll ();
+        success = parse (bytes.constData (), bytes.size ());
+      }
       file.close ();
       return success;
     }
@@ -362,4 +977,26 @@ namespace ImportExport
       return false;
     }
   }
+
+  Format fileFormat (const std::string& fileName)
+  {
+    std::ifstream file (fileName, std::ios::in | std::ios::binary);
+    char          magic[sizeof (binaryMagic)];
+
+    if (file.read (magic, sizeof (magic)) && hasBinaryMagic (magic, sizeof (magic)))
+    {
+      return Format::BinaryDly;
+    }
+    else
+    {
+      return Util::hasSuffix (fileName, ".obj") ? Format::Obj : Format::Dly;
+    }
+  }
+
+  bool parseFloat (const std::string& string, float& value)
+  {
+    TextParser parser (string.data (), string.size ());
+
+    return parser.parse (value) && parser.pos == parser.end;
+  }
 };
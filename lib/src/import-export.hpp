@@ -5,18 +5,44 @@
 #ifndef DILAY_IMPORT_EXPORT
 #define DILAY_IMPORT_EXPORT
 
+#include <cstddef>
 #include <iosfwd>
 #include <string>
+#include "sketch/fwd.hpp"
 
 class Config;
+class Mesh;
 class Scene;
 
 namespace ImportExport
 {
-  void toDlyFile (std::ostream&, Scene&, bool);
-  bool toDlyFile (const std::string&, Scene&, bool);
-  bool fromDlyFile (std::istream&, const Config&, Scene&);
-  bool fromDlyFile (const std::string&, const Config&, Scene&);
+  /* Besides the textual formats, scenes can be stored in a versioned binary format.  It consists
+   * of a header followed by a sequence of chunks (dynamic meshes, sketch trees, sketch paths).
+   * Vertex and index arrays are stored as in memory, so that loading does not need to parse them.
+   * Header and chunks can also be written separately, e.g. from a copy of the scene (see
+   * `Autosave`).
+   */
+  enum class Format
+  {
+    Dly,
+    BinaryDly,
+    Obj
+  };
+
+  void   toDlyFile (std::ostream&, Scene&, bool);
+  void   toBinaryDlyFile (std::ostream&, Scene&);
+  void   toBinaryDlyHeader (std::ostream&);
+  void   toBinaryDlyChunk (std::ostream&, const Mesh&);
+  void   toBinaryDlyChunks (std::ostream&, const SketchTree&, const SketchPaths&);
+  bool   toDlyFile (const std::string&, Scene&, Format);
+  bool   fromDlyFile (std::istream&, const Config&, Scene&);
+  bool   fromDlyFile (const char*, std::size_t, const Config&, Scene&);
+  bool   fromBinaryDlyFile (const char*, std::size_t, const Config&, Scene&);
+  bool   fromDlyFile (const std::string&, const Config&, Scene&);
+  Format fileFormat (const std::string&);
+
+  // parses a number as the text formats do, i.e. independently of the current locale
+  bool parseFloat (const std::string&, float&);
 };
 
 #endif
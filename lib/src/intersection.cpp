@@ -8,6 +8,7 @@
 #include "primitive/aabox.hpp"
 #include "primitive/cone.hpp"
 #include "primitive/cylinder.hpp"
+#include "primitive/frustum.hpp"
 #include "primitive/plane.hpp"
 #include "primitive/ray.hpp"
 #include "primitive/sphere.hpp"
@@ -254,6 +255,11 @@ bool IntersectionUtil::intersects (const PrimRay& ray, const PrimTriangle& tri,
 }
 
 bool IntersectionUtil::intersects (const PrimRay& ray, const PrimAABox& box)
+{
+  return IntersectionUtil::intersects (ray, box, nullptr);
+}
+
+bool IntersectionUtil::intersects (const PrimRay& ray, const PrimAABox& box, float* t)
 {
   const glm::vec3 invDir = glm::vec3 (1.0f) / ray.direction ();
   const glm::vec3 lowerTs = (box.minimum () - ray.origin ()) * invDir;
@@ -264,7 +270,15 @@ bool IntersectionUtil::intersects (const PrimRay& ray, const PrimAABox& box)
   const float tMin = glm::max (glm::max (min.x, min.y), min.z);
   const float tMax = glm::min (glm::min (max.x, max.y), max.z);
 
-  return (tMax >= 0.0f || ray.isLine ()) && tMin <= tMax;
+  if ((tMax >= 0.0f || ray.isLine ()) && tMin <= tMax)
+  {
+    Util::setIfNotNull (t, tMin);
+    return true;
+  }
+  else
+  {
+    return false;
+  }
 }
 
 bool IntersectionUtil::intersects (const PrimRay& ray, const PrimCylinder& cylinder, float* tRay,
@@ -473,3 +487,24 @@ bool IntersectionUtil::intersects (const PrimAABox& box, const PrimTriangle& tri
     return IntersectionUtil::intersects (PrimPlane (tri.vertex1 (), tri.normal ()), box);
   }
 }
+
+// Conservative: boxes that straddle the frustum corners may be reported as intersecting
+bool IntersectionUtil::intersects (const PrimFrustum& frustum, const PrimAABox& box)
+{
+  const glm::vec3& max = box.maximum ();
+  const glm::vec3& min = box.minimum ();
+
+  for (unsigned int i = 0; i < PrimFrustum::numPlanes; i++)
+  {
+    const glm::vec4& plane = frustum.plane (i);
+    const glm::vec3  p =
+      glm::vec3 (plane.x >= 0.0f ? max.x : min.x, plane.y >= 0.0f ? max.y : min.y,
+                 plane.z >= 0.0f ? max.z : min.z);
+
+    if (glm::dot (glm::vec3 (plane), p) + plane.w < 0.0f)
+    {
+      return false;
+    }
+  }
+  return true;
+}
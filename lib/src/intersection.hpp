@@ -11,6 +11,7 @@
 class PrimAABox;
 class PrimCone;
 class PrimCylinder;
+class PrimFrustum;
 class PrimPlane;
 class PrimRay;
 class PrimSphere;
@@ -43,6 +44,7 @@ namespace IntersectionUtil
   bool intersects (const PrimRay&, const PrimPlane&, float*);
   bool intersects (const PrimRay&, const PrimTriangle&, bool, float*);
   bool intersects (const PrimRay&, const PrimAABox&);
+  bool intersects (const PrimRay&, const PrimAABox&, float*);
   bool intersects (const PrimRay&, const PrimCylinder&, float*, float*);
   bool intersects (const PrimRay&, const PrimCone&, float*, float*);
   bool intersects (const PrimPlane&, const PrimAABox&);
@@ -51,6 +53,7 @@ namespace IntersectionUtil
   bool intersects (const PrimCone&, const glm::vec3&);
   bool intersects (const PrimAABox&, const PrimAABox&);
   bool intersects (const PrimAABox&, const PrimTriangle&);
+  bool intersects (const PrimFrustum&, const PrimAABox&);
 }
 
 #endif
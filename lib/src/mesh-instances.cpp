@@ -0,0 +1,151 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2017 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#include <cstddef>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_inverse.hpp>
+#include <vector>
+#include "color.hpp"
+#include "mesh-instances.hpp"
+#include "opengl-buffer-id.hpp"
+#include "opengl.hpp"
+
+namespace
+{
+  struct Instance
+  {
+    glm::mat4x4 model;
+    glm::mat3x3 modelNormal;
+    glm::vec3   color;
+  };
+
+  static_assert (sizeof (Instance) == 28 * sizeof (float), "Unexpected memory layout");
+
+  void bindMatrix (unsigned int index, unsigned int numColumns, std::size_t offset)
+  {
+    for (unsigned int i = 0; i < numColumns; i++)
+    {
+      const std::size_t columnOffset = offset + (i * numColumns * sizeof (float));
+
+      OpenGL::glEnableVertexAttribArray (index + i);
+      OpenGL::glVertexAttribPointer (index + i, numColumns, OpenGL::Float (), false,
+                                     sizeof (Instance),
+                                     reinterpret_cast<const void*> (columnOffset));
+      OpenGL::glVertexAttribDivisor (index + i, 1);
+    }
+  }
+
+  void unbindMatrix (unsigned int index, unsigned int numColumns)
+  {
+    for (unsigned int i = 0; i < numColumns; i++)
+    {
+      OpenGL::glVertexAttribDivisor (index + i, 0);
+      OpenGL::glDisableVertexAttribArray (index + i);
+    }
+  }
+}
+
+struct MeshInstances::Impl
+{
+  std::vector<Instance> instances;
+  OpenGLBufferId        id;
+  bool                  isBuffered;
+
+  Impl ()
+    : isBuffered (false)
+  {
+  }
+
+  unsigned int numInstances () const { return this->instances.size (); }
+
+  const glm::mat4x4& modelMatrix (unsigned int i) const
+  {
+    assert (i < this->instances.size ());
+    return this->instances[i].model;
+  }
+
+  const glm::mat3x3& modelNormalMatrix (unsigned int i) const
+  {
+    assert (i < this->instances.size ());
+    return this->instances[i].modelNormal;
+  }
+
+  Color color (unsigned int i) const
+  {
+    assert (i < this->instances.size ());
+    return Color (this->instances[i].color);
+  }
+
+  void addInstance (const glm::mat4x4& model, const Color& color)
+  {
+    this->instances.push_back (
+      Instance{model, glm::inverseTranspose (glm::mat3x3 (model)), color.vec3 ()});
+    this->isBuffered = false;
+  }
+
+  void reserve (unsigned int n) { this->instances.reserve (n); }
+
+  void reset ()
+  {
+    this->instances.clear ();
+    this->isBuffered = false;
+  }
+
+  void bufferData ()
+  {
+    // copies do not share buffers, cf. `OpenGLBufferId`
+    if ((this->isBuffered == false || this->id.isValid () == false) && OpenGL::hasInstancing ())
+    {
+      if (this->id.isValid () == false)
+      {
+        this->id.allocate ();
+      }
+      OpenGL::glBindBuffer (OpenGL::ArrayBuffer (), this->id.id ());
+      OpenGL::glBufferData (OpenGL::ArrayBuffer (), this->instances.size () * sizeof (Instance),
+                            this->instances.data (), OpenGL::DynamicDraw ());
+      OpenGL::glBindBuffer (OpenGL::ArrayBuffer (), 0);
+
+      this->isBuffered = true;
+    }
+  }
+
+  void bindAttributes () const
+  {
+    assert (this->isBuffered && this->id.isValid ());
+
+    OpenGL::glBindBuffer (OpenGL::ArrayBuffer (), this->id.id ());
+
+    OpenGL::glEnableVertexAttribArray (OpenGL::InstanceColorIndex);
+    OpenGL::glVertexAttribPointer (OpenGL::InstanceColorIndex, 3, OpenGL::Float (), false,
+                                   sizeof (Instance),
+                                   reinterpret_cast<const void*> (offsetof (Instance, color)));
+    OpenGL::glVertexAttribDivisor (OpenGL::InstanceColorIndex, 1);
+
+    bindMatrix (OpenGL::InstanceModelIndex, 4, offsetof (Instance, model));
+    bindMatrix (OpenGL::InstanceModelNormalIndex, 3, offsetof (Instance, modelNormal));
+
+    OpenGL::glBindBuffer (OpenGL::ArrayBuffer (), 0);
+  }
+
+  void unbindAttributes () const
+  {
+    OpenGL::glVertexAttribDivisor (OpenGL::InstanceColorIndex, 0);
+    OpenGL::glDisableVertexAttribArray (OpenGL::InstanceColorIndex);
+
+    unbindMatrix (OpenGL::InstanceModelIndex, 4);
+    unbindMatrix (OpenGL::InstanceModelNormalIndex, 3);
+  }
+};
+
+DELEGATE_BIG6 (MeshInstances)
+DELEGATE_CONST (unsigned int, MeshInstances, numInstances)
+DELEGATE1_CONST (const glm::mat4x4&, MeshInstances, modelMatrix, unsigned int)
+DELEGATE1_CONST (const glm::mat3x3&, MeshInstances, modelNormalMatrix, unsigned int)
+DELEGATE1_CONST (Color, MeshInstances, color, unsigned int)
+DELEGATE2 (void, MeshInstances, addInstance, const glm::mat4x4&, const Color&)
+DELEGATE1 (void, MeshInstances, reserve, unsigned int)
+DELEGATE (void, MeshInstances, reset)
+DELEGATE (void, MeshInstances, bufferData)
+DELEGATE_CONST (void, MeshInstances, bindAttributes)
+DELEGATE_CONST (void, MeshInstances, unbindAttributes)
@@ -0,0 +1,37 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2017 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#ifndef DILAY_MESH_INSTANCES
+#define DILAY_MESH_INSTANCES
+
+#include <glm/fwd.hpp>
+#include "macro.hpp"
+
+class Color;
+
+/* Model matrices and colors of several instances of a mesh, which are rendered with a single draw
+ * call by `Mesh::renderInstances`.  Instances are uploaded as per-instance vertex attributes (cf.
+ * `OpenGL::InstanceModelIndex`) when they have been modified since the last upload.
+ */
+class MeshInstances
+{
+public:
+  DECLARE_BIG6 (MeshInstances)
+
+  unsigned int       numInstances () const;
+  const glm::mat4x4& modelMatrix (unsigned int) const;
+  const glm::mat3x3& modelNormalMatrix (unsigned int) const;
+  Color              color (unsigned int) const;
+  void               addInstance (const glm::mat4x4&, const Color&);
+  void               reserve (unsigned int);
+  void               reset ();
+  void               bufferData ();
+  void               bindAttributes () const;
+  void               unbindAttributes () const;
+
+private:
+  IMPLEMENTATION
+};
+
+#endif
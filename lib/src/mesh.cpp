@@ -2,12 +2,18 @@
  * Copyright © 2015-2017 Alexander Bau
  * Use and redistribute under the terms of the GNU General Public License
  */
+#include <algorithm>
+#include <cstddef>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_inverse.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+#include <atomic>
+#include <limits>
+#include <memory>
 #include <vector>
 #include "camera.hpp"
 #include "color.hpp"
+#include "mesh-instances.hpp"
 #include "mesh.hpp"
 #include "opengl-buffer-id.hpp"
 #include "opengl.hpp"
@@ -19,66 +25,210 @@ namespace
 {
   static_assert (sizeof (glm::vec3) == 3 * sizeof (float), "Unexpected memory layout");
 
+  /* Modifications are tracked per page of `pageSize` elements.  Buffering uploads each run of
+   * consecutive dirty pages with a single call, so the amount of uploaded data depends on the
+   * number of modified elements rather than on the distance between them.
+   * The data is shared between copies and copied on the first modification, i.e. copying a mesh
+   * is cheap and copies can be read on other threads (cf. `Autosave`).
+   */
   template <typename T> struct BufferedData
   {
-    OpenGLBufferId id;
-    std::vector<T> data;
-    unsigned int   dataLowerBound;
-    unsigned int   dataUpperBound;
-    unsigned int   bufferSize;
+    static constexpr unsigned int pageSize = 1024;
+
+    OpenGLBufferId                  id;
+    std::shared_ptr<std::vector<T>> shared;
+    std::vector<unsigned char>      dirtyPages;
+    unsigned int                    dirtyLowerPage;
+    unsigned int                    dirtyUpperPage;
+    unsigned int                    bufferSize;
 
     BufferedData () { this->reset (); }
 
+    BufferedData (const BufferedData&) = default;
+
+    BufferedData (BufferedData&& other)
+      : id (std::move (other.id))
+      , shared (std::move (other.shared))
+      , dirtyPages (std::move (other.dirtyPages))
+      , dirtyLowerPage (other.dirtyLowerPage)
+      , dirtyUpperPage (other.dirtyUpperPage)
+      , bufferSize (other.bufferSize)
+    {
+      other.shared = BufferedData::empty ();
+    }
+
+    BufferedData& operator= (const BufferedData&) = default;
+
+    BufferedData& operator= (BufferedData&& other)
+    {
+      this->id = std::move (other.id);
+      this->shared = std::move (other.shared);
+      this->dirtyPages = std::move (other.dirtyPages);
+      this->dirtyLowerPage = other.dirtyLowerPage;
+      this->dirtyUpperPage = other.dirtyUpperPage;
+      this->bufferSize = other.bufferSize;
+      other.shared = BufferedData::empty ();
+      return *this;
+    }
+
+    static const std::shared_ptr<std::vector<T>>& empty ()
+    {
+      static const std::shared_ptr<std::vector<T>> e = std::make_shared<std::vector<T>> ();
+      return e;
+    }
+
+    const std::vector<T>& data () const { return *this->shared; }
+
+    std::vector<T>& mutableData ()
+    {
+      if (this->shared.use_count () > 1)
+      {
+        this->shared = std::make_shared<std::vector<T>> (*this->shared);
+      }
+      else
+      {
+        // synchronizes with copies that have been released on other threads
+        std::atomic_thread_fence (std::memory_order_acquire);
+      }
+      return *this->shared;
+    }
+
     void reset ()
     {
       this->id.reset ();
-      this->data.clear ();
-      this->resetBounds ();
+      this->shared = BufferedData::empty ();
+      this->dirtyPages.clear ();
+      this->resetDirtyPages ();
       this->bufferSize = 0;
     }
 
-    void resetBounds ()
+    void resetDirtyPages ()
     {
-      this->dataLowerBound = Util::maxUnsignedInt ();
-      this->dataUpperBound = 0;
+      std::fill (this->dirtyPages.begin (), this->dirtyPages.end (), 0);
+      this->dirtyLowerPage = Util::maxUnsignedInt ();
+      this->dirtyUpperPage = 0;
     }
 
-    unsigned int numElements () const { return this->data.size (); }
+    bool hasDirtyPages () const { return this->dirtyLowerPage <= this->dirtyUpperPage; }
+
+    bool isDirty (unsigned int index) const
+    {
+      const unsigned int page = index / pageSize;
+      return page < this->dirtyPages.size () && this->dirtyPages[page];
+    }
 
-    void reserve (unsigned int size) { this->data.reserve (size); }
+    unsigned int numElements () const { return this->data ().size (); }
+
+    void reserve (unsigned int size) { this->mutableData ().reserve (size); }
 
     void shrink (unsigned int n)
     {
       assert (n <= this->numElements ());
-      this->data.resize (n);
-      this->dataLowerBound = 0;
-      this->dataUpperBound = n > 0 ? n - 1 : 0;
+      this->mutableData ().resize (n);
+      this->dirtyPages.resize ((n + pageSize - 1) / pageSize, 0);
+
+      for (unsigned int i = 0; i < n; i += pageSize)
+      {
+        this->setDirty (i);
+      }
     }
 
-    void updateBounds (unsigned int index)
+    void setDirty (unsigned int index)
     {
-      this->dataLowerBound = glm::min (this->dataLowerBound, index);
-      this->dataUpperBound = glm::max (this->dataUpperBound, index);
+      const unsigned int page = index / pageSize;
+
+      if (page >= this->dirtyPages.size ())
+      {
+        this->dirtyPages.resize (page + 1, 0);
+      }
+      this->dirtyPages[page] = 1;
+      this->dirtyLowerPage = glm::min (this->dirtyLowerPage, page);
+      this->dirtyUpperPage = glm::max (this->dirtyUpperPage, page);
     }
 
     unsigned int add (const T& value)
     {
-      this->data.push_back (value);
-      this->updateBounds (this->numElements () - 1);
+      this->mutableData ().push_back (value);
+      this->setDirty (this->numElements () - 1);
       return this->numElements () - 1;
     }
 
+    void add (const T* values, unsigned int n)
+    {
+      const unsigned int first = this->numElements ();
+
+      std::vector<T>& d = this->mutableData ();
+      d.insert (d.end (), values, values + n);
+
+      for (unsigned int i = first; i < first + n; i += pageSize)
+      {
+        this->setDirty (i);
+      }
+      if (n > 0)
+      {
+        this->setDirty (first + n - 1);
+      }
+    }
+
     void set (unsigned int index, const T& value)
     {
       assert (index < this->numElements ());
-      this->data[index] = value;
-      this->updateBounds (index);
+      this->mutableData ()[index] = value;
+      this->setDirty (index);
     }
 
     const T& get (unsigned int index) const
     {
       assert (index < this->numElements ());
-      return this->data[index];
+      return this->data ()[index];
+    }
+
+    template <typename F> void forEachDirtyIndex (const F& f) const
+    {
+      const unsigned int numPages = glm::min (this->dirtyUpperPage + 1,
+                                              (this->numElements () + pageSize - 1) / pageSize);
+
+      for (unsigned int page = this->dirtyLowerPage; page < numPages; page++)
+      {
+        if (this->dirtyPages[page])
+        {
+          const unsigned int end = glm::min ((page + 1) * pageSize, this->numElements ());
+
+          for (unsigned int i = page * pageSize; i < end; i++)
+          {
+            f (i);
+          }
+        }
+      }
+    }
+
+    void bufferDirtyPages (unsigned int target)
+    {
+      const unsigned int numPages = glm::min (this->dirtyUpperPage + 1,
+                                              (this->numElements () + pageSize - 1) / pageSize);
+      unsigned int page = this->dirtyLowerPage;
+
+      while (page < numPages)
+      {
+        if (this->dirtyPages[page])
+        {
+          const unsigned int first = page;
+
+          while (page < numPages && this->dirtyPages[page])
+          {
+            page++;
+          }
+          const unsigned int begin = first * pageSize;
+          const unsigned int end = glm::min (page * pageSize, this->numElements ());
+
+          OpenGL::glBufferSubData (target, begin * sizeof (T), (end - begin) * sizeof (T),
+                                   &this->get (begin));
+        }
+        else
+        {
+          page++;
+        }
+      }
     }
 
     void bufferData (unsigned int target)
@@ -94,40 +244,65 @@ namespace
 
       if (this->bufferSize == 0)
       {
-        OpenGL::glBufferData (target, dataSize, this->data.data (), OpenGL::StaticDraw ());
+        OpenGL::glBufferData (target, dataSize, this->data ().data (), OpenGL::StaticDraw ());
         this->bufferSize = dataSize;
       }
       else if (this->bufferSize < dataSize)
       {
-        const unsigned int newBufferSize = this->bufferSize + (100 * (dataSize - this->bufferSize));
+        const unsigned int newBufferSize =
+          glm::max (dataSize, this->bufferSize + (this->bufferSize / 2));
 
-        OpenGL::glBufferData (target, newBufferSize, nullptr, OpenGL::StaticDraw ());
-        OpenGL::glBufferSubData (target, 0, dataSize, this->data.data ());
+        OpenGL::glBufferData (target, newBufferSize, nullptr, OpenGL::DynamicDraw ());
+        OpenGL::glBufferSubData (target, 0, dataSize, this->data ().data ());
         this->bufferSize = newBufferSize;
       }
-      else if (this->dataLowerBound <= this->dataUpperBound)
+      else if (this->hasDirtyPages ())
       {
-        const unsigned int size = (this->dataUpperBound - this->dataLowerBound + 1) * sizeof (T);
-
-        OpenGL::glBufferSubData (target, this->dataLowerBound * sizeof (T), size,
-                                 &this->get (this->dataLowerBound));
+        this->bufferDirtyPages (target);
       }
-      this->resetBounds ();
+      this->resetDirtyPages ();
     }
   };
+
+  // positions and normals are interleaved in a single buffer
+  struct Vertex
+  {
+    glm::vec3 position;
+    glm::vec3 normal;
+  };
+  static_assert (sizeof (Vertex) == 6 * sizeof (float), "Unexpected memory layout");
+
+  /* Wireframes are rendered in a single pass by blending the edges of each triangle in the
+   * fragment shader, which needs the barycentric coordinates of each fragment.  Without a geometry
+   * shader, each corner of each triangle becomes a vertex of its own that stores its barycentric
+   * coordinates (cf. `Mesh::Impl::bufferWireframe`).  The barycentric coordinates are either 0 or
+   * 1 and are stored as normalized bytes, which keeps the overhead per corner at 4 bytes.
+   */
+  struct WireframeVertex
+  {
+    glm::vec3     position;
+    glm::vec3     normal;
+    unsigned char barycentric[4];
+  };
+  static_assert (sizeof (WireframeVertex) == 7 * sizeof (float), "Unexpected memory layout");
+
+  constexpr unsigned int maxShortIndex = std::numeric_limits<unsigned short>::max ();
 }
 
 struct Mesh::Impl
 {
   // cf. copy-constructor, reset
-  glm::mat4x4                scalingMatrix;
-  glm::mat4x4                rotationMatrix;
-  glm::mat4x4                translationMatrix;
-  BufferedData<glm::vec3>    vertices;
-  BufferedData<unsigned int> indices;
-  BufferedData<glm::vec3>    normals;
-  Color                      color;
-  Color                      wireframeColor;
+  glm::mat4x4                   scalingMatrix;
+  glm::mat4x4                   rotationMatrix;
+  glm::mat4x4                   translationMatrix;
+  BufferedData<Vertex>          vertices;
+  BufferedData<unsigned short>  shortIndices;
+  BufferedData<unsigned int>    indices;
+  BufferedData<WireframeVertex> wireframeVertices;
+  std::vector<unsigned int>     modifiedVertices;
+  bool                          hasShortIndices;
+  Color                         color;
+  Color                         wireframeColor;
 
   RenderMode renderMode;
 
@@ -135,6 +310,7 @@ struct Mesh::Impl
     : scalingMatrix (glm::mat4x4 (1.0f))
     , rotationMatrix (glm::mat4x4 (1.0f))
     , translationMatrix (glm::mat4x4 (1.0f))
+    , hasShortIndices (true)
     , color (Color::White ())
     , wireframeColor (Color::Black ())
   {
@@ -143,13 +319,20 @@ struct Mesh::Impl
 
   unsigned int numVertices () const { return this->vertices.numElements (); }
 
-  unsigned int numIndices () const { return this->indices.numElements (); }
+  unsigned int numIndices () const
+  {
+    return this->hasShortIndices ? this->shortIndices.numElements ()
+                                 : this->indices.numElements ();
+  }
 
-  const glm::vec3& vertex (unsigned int i) const { return this->vertices.get (i); }
+  const glm::vec3& vertex (unsigned int i) const { return this->vertices.get (i).position; }
 
-  unsigned int index (unsigned int i) const { return this->indices.get (i); }
+  unsigned int index (unsigned int i) const
+  {
+    return this->hasShortIndices ? this->shortIndices.get (i) : this->indices.get (i);
+  }
 
-  const glm::vec3& normal (unsigned int i) const { return this->normals.get (i); }
+  const glm::vec3& normal (unsigned int i) const { return this->vertices.get (i).normal; }
 
   void copyNonGeometry (const Mesh& source)
   {
@@ -161,11 +344,80 @@ struct Mesh::Impl
     this->renderMode = source.impl->renderMode;
   }
 
-  unsigned int addIndex (unsigned int i) { return this->indices.add (i); }
+  /* Indices are stored as `unsigned short` until an index exceeds its range.  The index buffer
+   * is then promoted to `unsigned int` for the remaining lifetime of the geometry.
+   */
+  void promoteIndices ()
+  {
+    assert (this->hasShortIndices);
+
+    this->indices.reset ();
+    this->indices.reserve (this->shortIndices.data ().capacity ());
+
+    for (unsigned short i : this->shortIndices.data ())
+    {
+      this->indices.add (i);
+    }
+    this->shortIndices.reset ();
+    this->hasShortIndices = false;
+  }
+
+  unsigned int addIndex (unsigned int i)
+  {
+    if (this->hasShortIndices && i > maxShortIndex)
+    {
+      this->promoteIndices ();
+    }
+    return this->hasShortIndices ? this->shortIndices.add ((unsigned short) i)
+                                 : this->indices.add (i);
+  }
+
+  void addIndices (const unsigned int* is, unsigned int n)
+  {
+    if (this->hasShortIndices &&
+        std::any_of (is, is + n, [](unsigned int i) { return i > maxShortIndex; }))
+    {
+      this->promoteIndices ();
+    }
 
-  void reserveIndices (unsigned int n) { this->indices.reserve (n); }
+    if (this->hasShortIndices)
+    {
+      this->shortIndices.reserve (this->shortIndices.numElements () + n);
 
-  void shrinkIndices (unsigned int n) { this->indices.shrink (n); }
+      for (unsigned int i = 0; i < n; i++)
+      {
+        this->shortIndices.add ((unsigned short) is[i]);
+      }
+    }
+    else
+    {
+      this->indices.add (is, n);
+    }
+  }
+
+  void reserveIndices (unsigned int n)
+  {
+    if (this->hasShortIndices)
+    {
+      this->shortIndices.reserve (n);
+    }
+    else
+    {
+      this->indices.reserve (n);
+    }
+  }
+
+  void shrinkIndices (unsigned int n)
+  {
+    if (this->hasShortIndices)
+    {
+      this->shortIndices.shrink (n);
+    }
+    else
+    {
+      this->indices.shrink (n);
+    }
+  }
 
   unsigned int addVertex (const glm::vec3& v) { return this->addVertex (v, glm::vec3 (0.0f)); }
 
@@ -173,43 +425,169 @@ struct Mesh::Impl
   {
     assert (Util::isNaN (v) == false);
     assert (Util::isNaN (n) == false);
-    assert (this->vertices.numElements () == this->normals.numElements ());
 
-    this->vertices.add (v);
-    return this->normals.add (n);
+    return this->vertices.add (Vertex{v, n});
   }
 
-  void reserveVertices (unsigned int n)
+  // `vs` holds `n` interleaved pairs of positions and normals
+  void addVertices (const float* vs, unsigned int n)
   {
-    this->vertices.reserve (n);
-    this->normals.reserve (n);
+    this->vertices.add (reinterpret_cast<const Vertex*> (vs), n);
   }
 
-  void shrinkVertices (unsigned int n)
+  void reserveVertices (unsigned int n) { this->vertices.reserve (n); }
+
+  void shrinkVertices (unsigned int n) { this->vertices.shrink (n); }
+
+  void index (unsigned int i, unsigned int index)
   {
-    this->vertices.shrink (n);
-    this->normals.shrink (n);
-  }
+    if (this->hasShortIndices && index > maxShortIndex)
+    {
+      this->promoteIndices ();
+    }
 
-  void index (unsigned int i, unsigned int index) { this->indices.set (i, index); }
+    if (this->hasShortIndices)
+    {
+      this->shortIndices.set (i, (unsigned short) index);
+    }
+    else
+    {
+      this->indices.set (i, index);
+    }
+  }
 
   void vertex (unsigned int i, const glm::vec3& v)
   {
     assert (Util::isNaN (v) == false);
-    this->vertices.set (i, v);
+    this->vertices.set (i, Vertex{v, this->normal (i)});
+    this->setModified (i);
   }
 
   void normal (unsigned int i, const glm::vec3& n)
   {
     assert (Util::isNaN (n) == false);
-    this->normals.set (i, n);
+    this->vertices.set (i, Vertex{this->vertex (i), n});
+    this->setModified (i);
+  }
+
+  // modified vertices are only tracked to update the corners of buffered wireframe vertices
+  void setModified (unsigned int i)
+  {
+    if (this->wireframeVertices.numElements () > 0 &&
+        (this->modifiedVertices.empty () || this->modifiedVertices.back () != i))
+    {
+      this->modifiedVertices.push_back (i);
+    }
+  }
+
+  bool needsWireframeVertices () const
+  {
+    return this->renderMode.renderWireframe () && OpenGL::hasGeometryShader () == false;
+  }
+
+  bool hasWireframeVertices () const
+  {
+    return this->wireframeVertices.id.isValid () &&
+           this->wireframeVertices.numElements () == this->numIndices ();
+  }
+
+  WireframeVertex wireframeVertex (unsigned int corner) const
+  {
+    const unsigned int index = this->index (corner);
+    WireframeVertex    v{this->vertex (index), this->normal (index), {0, 0, 0, 0}};
+
+    v.barycentric[corner % 3] = std::numeric_limits<unsigned char>::max ();
+    return v;
+  }
+
+  /* Must be called before the dirty pages of the indices are reset.  A corner is rewritten if its
+   * index has been modified or if it is one of `corners`, which must contain all corners of
+   * modified vertices.  Without `corners`, all corners are searched for modified vertices.
+   * Only the pages of rewritten corners are uploaded.
+   */
+  void bufferWireframe (const std::vector<unsigned int>* corners)
+  {
+    if (this->needsWireframeVertices () == false)
+    {
+      this->wireframeVertices.reset ();
+      this->modifiedVertices.clear ();
+      return;
+    }
+
+    const unsigned int numCorners = this->numIndices ();
+    const unsigned int numOldCorners =
+      glm::min (numCorners, this->wireframeVertices.numElements ());
+
+    if (numOldCorners < this->wireframeVertices.numElements ())
+    {
+      this->wireframeVertices.shrink (numOldCorners);
+    }
+
+    const auto update = [this, numOldCorners](unsigned int corner) {
+      if (corner < numOldCorners)
+      {
+        this->wireframeVertices.set (corner, this->wireframeVertex (corner));
+      }
+    };
+
+    if (this->hasShortIndices)
+    {
+      this->shortIndices.forEachDirtyIndex (update);
+    }
+    else
+    {
+      this->indices.forEachDirtyIndex (update);
+    }
+
+    if (corners)
+    {
+      std::for_each (corners->begin (), corners->end (), update);
+    }
+    else if (this->modifiedVertices.empty () == false)
+    {
+      std::vector<unsigned char> isModified (this->numVertices (), 0);
+
+      for (unsigned int i : this->modifiedVertices)
+      {
+        if (i < isModified.size ())
+        {
+          isModified[i] = 1;
+        }
+      }
+      for (unsigned int i = 0; i < numOldCorners; i++)
+      {
+        if (isModified[this->index (i)])
+        {
+          update (i);
+        }
+      }
+    }
+
+    for (unsigned int i = numOldCorners; i < numCorners; i++)
+    {
+      this->wireframeVertices.add (this->wireframeVertex (i));
+    }
+    this->wireframeVertices.bufferData (OpenGL::ArrayBuffer ());
+    this->modifiedVertices.clear ();
   }
 
-  void bufferData ()
+  void bufferData () { this->bufferData (nullptr); }
+
+  void bufferData (const std::vector<unsigned int>& corners) { this->bufferData (&corners); }
+
+  void bufferData (const std::vector<unsigned int>* corners)
   {
+    this->bufferWireframe (corners);
     this->vertices.bufferData (OpenGL::ArrayBuffer ());
-    this->indices.bufferData (OpenGL::ElementArrayBuffer ());
-    this->normals.bufferData (OpenGL::ArrayBuffer ());
+
+    if (this->hasShortIndices)
+    {
+      this->shortIndices.bufferData (OpenGL::ElementArrayBuffer ());
+    }
+    else
+    {
+      this->indices.bufferData (OpenGL::ElementArrayBuffer ());
+    }
 
     OpenGL::glBindBuffer (OpenGL::ElementArrayBuffer (), 0);
     OpenGL::glBindBuffer (OpenGL::ArrayBuffer (), 0);
@@ -230,9 +608,23 @@ struct Mesh::Impl
     camera.setModelViewProjection (this->modelMatrix (), this->modelNormalMatrix (), noZoom);
   }
 
+  // wireframes are rendered in a second pass if they have not been buffered yet (cf. `render`)
+  bool rendersWireframeInSecondPass () const
+  {
+    return this->needsWireframeVertices () && this->hasWireframeVertices () == false;
+  }
+
   void renderBegin (Camera& camera) const
   {
-    if (this->renderMode.renderWireframe () && OpenGL::hasGeometryShader () == false)
+    this->renderBegin (camera, this->rendersWireframeInSecondPass () == false);
+  }
+
+  /* Without a wireframe, the indexed vertices are bound even if wireframe vertices have been
+   * buffered, i.e. `glDrawElements` can be used (cf. `renderInstances`, `renderLines`).
+   */
+  void renderBegin (Camera& camera, bool withWireframe) const
+  {
+    if (withWireframe == false)
     {
       RenderMode nonWireframeRenderMode (this->renderMode);
       nonWireframeRenderMode.renderWireframe (false);
@@ -248,18 +640,64 @@ struct Mesh::Impl
 
     this->setModelMatrix (camera, this->renderMode.cameraRotationOnly ());
 
-    OpenGL::glBindBuffer (OpenGL::ArrayBuffer (), this->vertices.id.id ());
+    if (withWireframe && this->needsWireframeVertices () && this->hasWireframeVertices ())
+    {
+      this->bindWireframeBuffer ();
+    }
+    else
+    {
+      this->bindBuffers ();
+    }
+  }
+
+  void bindWireframeBuffer () const
+  {
+    OpenGL::glBindBuffer (OpenGL::ArrayBuffer (), this->wireframeVertices.id.id ());
     OpenGL::glEnableVertexAttribArray (OpenGL::PositionIndex);
-    OpenGL::glVertexAttribPointer (OpenGL::PositionIndex, 3, OpenGL::Float (), false, 0, 0);
+    OpenGL::glVertexAttribPointer (
+      OpenGL::PositionIndex, 3, OpenGL::Float (), false, sizeof (WireframeVertex),
+      reinterpret_cast<const void*> (offsetof (WireframeVertex, position)));
+
+    if (this->renderMode.smoothShading ())
+    {
+      OpenGL::glEnableVertexAttribArray (OpenGL::NormalIndex);
+      OpenGL::glVertexAttribPointer (
+        OpenGL::NormalIndex, 3, OpenGL::Float (), false, sizeof (WireframeVertex),
+        reinterpret_cast<const void*> (offsetof (WireframeVertex, normal)));
+    }
+
+    OpenGL::glEnableVertexAttribArray (OpenGL::BarycentricIndex);
+    OpenGL::glVertexAttribPointer (
+      OpenGL::BarycentricIndex, 3, OpenGL::UnsignedByte (), true, sizeof (WireframeVertex),
+      reinterpret_cast<const void*> (offsetof (WireframeVertex, barycentric)));
+
+    OpenGL::glBindBuffer (OpenGL::ArrayBuffer (), 0);
+
+    if (this->renderMode.noDepthTest ())
+    {
+      OpenGL::glDisable (OpenGL::DepthTest ());
+    }
+  }
 
-    OpenGL::glBindBuffer (OpenGL::ElementArrayBuffer (), this->indices.id.id ());
+  void bindBuffers () const
+  {
+    OpenGL::glBindBuffer (OpenGL::ArrayBuffer (), this->vertices.id.id ());
+    OpenGL::glEnableVertexAttribArray (OpenGL::PositionIndex);
+    OpenGL::glVertexAttribPointer (OpenGL::PositionIndex, 3, OpenGL::Float (), false,
+                                   sizeof (Vertex),
+                                   reinterpret_cast<const void*> (offsetof (Vertex, position)));
 
     if (this->renderMode.smoothShading ())
     {
-      OpenGL::glBindBuffer (OpenGL::ArrayBuffer (), this->normals.id.id ());
       OpenGL::glEnableVertexAttribArray (OpenGL::NormalIndex);
-      OpenGL::glVertexAttribPointer (OpenGL::NormalIndex, 3, OpenGL::Float (), false, 0, 0);
+      OpenGL::glVertexAttribPointer (OpenGL::NormalIndex, 3, OpenGL::Float (), false,
+                                     sizeof (Vertex),
+                                     reinterpret_cast<const void*> (offsetof (Vertex, normal)));
     }
+
+    OpenGL::glBindBuffer (OpenGL::ElementArrayBuffer (), this->hasShortIndices
+                                                           ? this->shortIndices.id.id ()
+                                                           : this->indices.id.id ());
     OpenGL::glBindBuffer (OpenGL::ArrayBuffer (), 0);
 
     if (this->renderMode.noDepthTest ())
@@ -272,25 +710,56 @@ struct Mesh::Impl
   {
     OpenGL::glDisableVertexAttribArray (OpenGL::PositionIndex);
     OpenGL::glDisableVertexAttribArray (OpenGL::NormalIndex);
+    OpenGL::glDisableVertexAttribArray (OpenGL::BarycentricIndex);
     OpenGL::glBindBuffer (OpenGL::ArrayBuffer (), 0);
     OpenGL::glBindBuffer (OpenGL::ElementArrayBuffer (), 0);
     OpenGL::glEnable (OpenGL::DepthTest ());
   }
 
+  unsigned int indexType () const
+  {
+    return this->hasShortIndices ? OpenGL::UnsignedShort () : OpenGL::UnsignedInt ();
+  }
+
+  void drawTriangles (unsigned int first, unsigned int count) const
+  {
+    if (this->needsWireframeVertices () && this->hasWireframeVertices ())
+    {
+      OpenGL::glDrawArrays (OpenGL::Triangles (), first, count);
+    }
+    else
+    {
+      const std::size_t indexSize =
+        this->hasShortIndices ? sizeof (unsigned short) : sizeof (unsigned int);
+
+      OpenGL::glDrawElements (OpenGL::Triangles (), count, this->indexType (),
+                              reinterpret_cast<const void*> (first * indexSize));
+    }
+  }
+
   void render (Camera& camera) const
+  {
+    this->renderRanges (camera, {glm::uvec2 (0, this->numIndices ())});
+  }
+
+  void renderRanges (Camera& camera, const std::vector<glm::uvec2>& ranges) const
   {
     this->renderBegin (camera);
 
-    OpenGL::glDrawElements (OpenGL::Triangles (), this->numIndices (), OpenGL::UnsignedInt (),
-                            nullptr);
+    for (const glm::uvec2& r : ranges)
+    {
+      this->drawTriangles (r.x, r.y);
+    }
 
-    if (this->renderMode.renderWireframe () && OpenGL::hasGeometryShader () == false)
+    if (this->rendersWireframeInSecondPass ())
     {
       camera.renderer ().setColor (this->wireframeColor);
       OpenGL::glPolygonMode (OpenGL::FrontAndBack (), OpenGL::Line ());
 
-      OpenGL::glDrawElements (OpenGL::Triangles (), this->numIndices (), OpenGL::UnsignedInt (),
-                              nullptr);
+      for (const glm::uvec2& r : ranges)
+      {
+        this->drawTriangles (r.x, r.y);
+      }
 
       OpenGL::glPolygonMode (OpenGL::FrontAndBack (), OpenGL::Fill ());
     }
@@ -298,10 +767,54 @@ struct Mesh::Impl
     this->renderEnd ();
   }
 
+  void renderInstances (Camera& camera, MeshInstances& instances) const
+  {
+    if (instances.numInstances () == 0)
+    {
+      return;
+    }
+    else if (OpenGL::hasInstancing ())
+    {
+      RenderMode instancedRenderMode (this->renderMode);
+      instancedRenderMode.renderWireframe (false);
+      instancedRenderMode.instanced (true);
+
+      instances.bufferData ();
+
+      camera.renderer ().setProgram (instancedRenderMode);
+      camera.setModelViewProjection (glm::mat4x4 (1.0f), glm::mat3x3 (1.0f),
+                                     this->renderMode.cameraRotationOnly ());
+      this->bindBuffers ();
+      instances.bindAttributes ();
+
+      OpenGL::glDrawElementsInstanced (OpenGL::Triangles (), this->numIndices (),
+                                       this->indexType (), nullptr, instances.numInstances ());
+
+      instances.unbindAttributes ();
+      this->renderEnd ();
+    }
+    else
+    {
+      // binds the buffers only once and updates the uniforms of each instance
+      this->renderBegin (camera, false);
+
+      for (unsigned int i = 0; i < instances.numInstances (); i++)
+      {
+        camera.renderer ().setColor (instances.color (i));
+        camera.setModelViewProjection (instances.modelMatrix (i), instances.modelNormalMatrix (i),
+                                       this->renderMode.cameraRotationOnly ());
+
+        OpenGL::glDrawElements (OpenGL::Triangles (), this->numIndices (), this->indexType (),
+                                nullptr);
+      }
+      this->renderEnd ();
+    }
+  }
+
   void renderLines (Camera& camera) const
   {
-    this->renderBegin (camera);
-    OpenGL::glDrawElements (OpenGL::Lines (), this->numIndices (), OpenGL::UnsignedInt (), nullptr);
+    this->renderBegin (camera, false);
+    OpenGL::glDrawElements (OpenGL::Lines (), this->numIndices (), this->indexType (), nullptr);
     this->renderEnd ();
   }
 
@@ -316,8 +829,11 @@ struct Mesh::Impl
   void resetGeometry ()
   {
     this->vertices.reset ();
+    this->shortIndices.reset ();
     this->indices.reset ();
-    this->normals.reset ();
+    this->wireframeVertices.reset ();
+    this->modifiedVertices.clear ();
+    this->hasShortIndices = true;
   }
 
   void scale (const glm::vec3& v) { this->scalingMatrix = glm::scale (this->scalingMatrix, v); }
@@ -404,8 +920,8 @@ struct Mesh::Impl
 
     for (unsigned int i = 0; i < this->numVertices (); i++)
     {
-      min = glm::min (min, this->vertices.get (i));
-      max = glm::max (max, this->vertices.get (i));
+      min = glm::min (min, this->vertex (i));
+      max = glm::max (max, this->vertex (i));
     }
   }
 };
@@ -419,10 +935,12 @@ DELEGATE1_CONST (const glm::vec3&, Mesh, normal, unsigned int)
 
 DELEGATE1 (void, Mesh, copyNonGeometry, const Mesh&)
 DELEGATE1 (unsigned int, Mesh, addIndex, unsigned int)
+DELEGATE2 (void, Mesh, addIndices, const unsigned int*, unsigned int)
 DELEGATE1 (void, Mesh, reserveIndices, unsigned int)
 DELEGATE1 (void, Mesh, shrinkIndices, unsigned int)
 DELEGATE1 (unsigned int, Mesh, addVertex, const glm::vec3&)
 DELEGATE2 (unsigned int, Mesh, addVertex, const glm::vec3&, const glm::vec3&)
+DELEGATE2 (void, Mesh, addVertices, const float*, unsigned int)
 DELEGATE1 (void, Mesh, reserveVertices, unsigned int)
 DELEGATE1 (void, Mesh, shrinkVertices, unsigned int)
 DELEGATE2 (void, Mesh, index, unsigned int, unsigned int)
@@ -430,11 +948,15 @@ DELEGATE2 (void, Mesh, vertex, unsigned int, const glm::vec3&)
 DELEGATE2 (void, Mesh, normal, unsigned int, const glm::vec3&)
 
 DELEGATE (void, Mesh, bufferData)
+DELEGATE1 (void, Mesh, bufferData, const std::vector<unsigned int>&)
+GETTER_CONST (const std::vector<unsigned int>&, Mesh, modifiedVertices)
 DELEGATE_CONST (glm::mat4x4, Mesh, modelMatrix)
 DELEGATE_CONST (glm::mat3x3, Mesh, modelNormalMatrix)
 DELEGATE1_CONST (void, Mesh, renderBegin, Camera&)
 DELEGATE_CONST (void, Mesh, renderEnd)
 DELEGATE1_CONST (void, Mesh, render, Camera&)
+DELEGATE2_CONST (void, Mesh, renderRanges, Camera&, const std::vector<glm::uvec2>&)
+DELEGATE2_CONST (void, Mesh, renderInstances, Camera&, MeshInstances&)
 DELEGATE1_CONST (void, Mesh, renderLines, Camera&)
 DELEGATE (void, Mesh, reset)
 DELEGATE (void, Mesh, resetGeometry)
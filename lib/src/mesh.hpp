@@ -6,10 +6,12 @@
 #define DILAY_MESH
 
 #include <glm/fwd.hpp>
+#include <vector>
 #include "macro.hpp"
 
 class Camera;
 class Color;
+class MeshInstances;
 class RenderFlags;
 class RenderMode;
 
@@ -25,22 +27,31 @@ public:
   const glm::vec3& normal (unsigned int) const;
   void             copyNonGeometry (const Mesh&);
   unsigned int     addIndex (unsigned int);
+  void             addIndices (const unsigned int*, unsigned int);
   void             reserveIndices (unsigned int);
   void             shrinkIndices (unsigned int);
   unsigned int     addVertex (const glm::vec3&);
   unsigned int     addVertex (const glm::vec3&, const glm::vec3&);
+  void             addVertices (const float*, unsigned int);
   void             reserveVertices (unsigned int);
   void             shrinkVertices (unsigned int);
   void             index (unsigned int, unsigned int);
   void             vertex (unsigned int, const glm::vec3&);
   void             normal (unsigned int, const glm::vec3&);
 
+  // vertices modified since the last `bufferData` while wireframe vertices are buffered
+  const std::vector<unsigned int>& modifiedVertices () const;
+  // the given corners must include all corners of `modifiedVertices`
+  void                             bufferData (const std::vector<unsigned int>&);
+
   void              bufferData ();
   glm::mat4x4       modelMatrix () const;
   glm::mat3x3       modelNormalMatrix () const;
   void              renderBegin (Camera&) const;
   void              renderEnd () const;
   void              render (Camera&) const;
+  void              renderRanges (Camera&, const std::vector<glm::uvec2>&) const;
+  void              renderInstances (Camera&, MeshInstances&) const;
   void              renderLines (Camera&) const;
   void              reset ();
   void              resetGeometry ();
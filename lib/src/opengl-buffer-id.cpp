@@ -18,13 +18,19 @@ OpenGLBufferId::OpenGLBufferId (const OpenGLBufferId&)
 OpenGLBufferId::OpenGLBufferId (OpenGLBufferId&& other)
   : _id (other._id)
 {
+  other._id = 0;
 }
 
 const OpenGLBufferId& OpenGLBufferId::operator= (const OpenGLBufferId&) { return *this; }
 
 const OpenGLBufferId& OpenGLBufferId::operator= (OpenGLBufferId&& other)
 {
-  this->_id = other._id;
+  if (this != &other)
+  {
+    this->reset ();
+    this->_id = other._id;
+    other._id = 0;
+  }
   return *this;
 }
 
@@ -41,6 +41,8 @@ namespace OpenGL
 
   static QOpenGLFunctions_2_1*                                  fun = nullptr;
   static std::unique_ptr<QOpenGLExtension_EXT_geometry_shader4> gsFun;
+  static std::unique_ptr<QOpenGLExtension_ARB_draw_instanced>   diFun;
+  static std::unique_ptr<QOpenGLExtension_ARB_instanced_arrays> iaFun;
 
   void setDefaultFormat ()
   {
@@ -79,11 +81,27 @@ namespace OpenGL
       }
     }
 
+    const bool supportInstancing =
+      QOpenGLContext::currentContext ()->hasExtension (QByteArray ("GL_ARB_draw_instanced")) &&
+      QOpenGLContext::currentContext ()->hasExtension (QByteArray ("GL_ARB_instanced_arrays"));
+    if (supportInstancing)
+    {
+      diFun = std::make_unique<QOpenGLExtension_ARB_draw_instanced> ();
+      iaFun = std::make_unique<QOpenGLExtension_ARB_instanced_arrays> ();
+      if (diFun == nullptr || iaFun == nullptr)
+      {
+        DILAY_PANIC ("could not initialize instancing extensions")
+      }
+      diFun->initializeOpenGLFunctions ();
+      iaFun->initializeOpenGLFunctions ();
+    }
+
     DILAY_INFO ("OpenGL version: %s", fun->glGetString (GL_VERSION));
     DILAY_INFO ("OpenGL vendor: %s", fun->glGetString (GL_VENDOR));
     DILAY_INFO ("OpenGL renderer: %s", fun->glGetString (GL_RENDERER));
     DILAY_INFO ("OpenGL GLSL version: %s", fun->glGetString (GL_SHADING_LANGUAGE_VERSION));
     DILAY_INFO ("OpenGL supports GL_EXT_geometry_shader4: %i", gsFun != nullptr);
+    DILAY_INFO ("OpenGL supports instancing: %i", diFun != nullptr);
   }
 
   DELEGATE_GL_CONSTANT (Always, GL_ALWAYS);
@@ -100,6 +118,7 @@ namespace OpenGL
   DELEGATE_GL_CONSTANT (DepthBufferBit, GL_DEPTH_BUFFER_BIT);
   DELEGATE_GL_CONSTANT (DepthTest, GL_DEPTH_TEST);
   DELEGATE_GL_CONSTANT (DstColor, GL_DST_COLOR);
+  DELEGATE_GL_CONSTANT (DynamicDraw, GL_DYNAMIC_DRAW);
   DELEGATE_GL_CONSTANT (ElementArrayBuffer, GL_ELEMENT_ARRAY_BUFFER);
   DELEGATE_GL_CONSTANT (Equal, GL_EQUAL);
   DELEGATE_GL_CONSTANT (Fill, GL_FILL);
@@ -122,7 +141,9 @@ namespace OpenGL
   DELEGATE_GL_CONSTANT (StencilBufferBit, GL_STENCIL_BUFFER_BIT);
   DELEGATE_GL_CONSTANT (StencilTest, GL_STENCIL_TEST);
   DELEGATE_GL_CONSTANT (Triangles, GL_TRIANGLES);
+  DELEGATE_GL_CONSTANT (UnsignedByte, GL_UNSIGNED_BYTE);
   DELEGATE_GL_CONSTANT (UnsignedInt, GL_UNSIGNED_INT);
+  DELEGATE_GL_CONSTANT (UnsignedShort, GL_UNSIGNED_SHORT);
   DELEGATE_GL_CONSTANT (Zero, GL_ZERO);
 
   DELEGATE2_GL (void, glBindBuffer, unsigned int, unsigned int)
@@ -139,7 +160,16 @@ namespace OpenGL
   DELEGATE1_GL (void, glDepthMask, bool)
   DELEGATE1_GL (void, glDisable, unsigned int)
   DELEGATE1_GL (void, glDisableVertexAttribArray, unsigned int)
+  DELEGATE3_GL (void, glDrawArrays, unsigned int, unsigned int, unsigned int)
   DELEGATE4_GL (void, glDrawElements, unsigned int, unsigned int, unsigned int, const void*)
+
+  void glDrawElementsInstanced (unsigned int mode, unsigned int count, unsigned int type,
+                                const void* indices, unsigned int primcount)
+  {
+    assert (OpenGL::hasInstancing ());
+    diFun->glDrawElementsInstancedARB (mode, count, type, indices, primcount);
+  }
+
   DELEGATE1_GL (void, glEnable, unsigned int)
   DELEGATE1_GL (void, glEnableVertexAttribArray, unsigned int)
   DELEGATE1_GL (void, glFrontFace, unsigned int)
@@ -156,12 +186,21 @@ namespace OpenGL
   DELEGATE4_GL (void, glUniformMatrix3fv, int, unsigned int, bool, const float*)
   DELEGATE4_GL (void, glUniformMatrix4fv, int, unsigned int, bool, const float*)
   DELEGATE1_GL (void, glUseProgram, unsigned int)
+
+  void glVertexAttribDivisor (unsigned int index, unsigned int divisor)
+  {
+    assert (OpenGL::hasInstancing ());
+    iaFun->glVertexAttribDivisorARB (index, divisor);
+  }
+
   DELEGATE6_GL (void, glVertexAttribPointer, unsigned int, int, unsigned int, bool, unsigned int,
                 const void*)
   DELEGATE4_GL (void, glViewport, unsigned int, unsigned int, unsigned int, unsigned int)
 
   bool hasGeometryShader () { return bool(gsFun); }
 
+  bool hasInstancing () { return bool(diFun); }
+
   void glUniformVec3 (unsigned int id, const glm::vec3& v) { fun->glUniform3f (id, v.x, v.y, v.z); }
   void glUniformVec4 (unsigned int id, const glm::vec4& v)
   {
@@ -255,6 +294,10 @@ namespace OpenGL
 
     fun->glBindAttribLocation (programId, OpenGL::PositionIndex, "position");
     fun->glBindAttribLocation (programId, OpenGL::NormalIndex, "normal");
+    fun->glBindAttribLocation (programId, OpenGL::BarycentricIndex, "vertexBarycentric");
+    fun->glBindAttribLocation (programId, OpenGL::InstanceColorIndex, "instanceColor");
+    fun->glBindAttribLocation (programId, OpenGL::InstanceModelIndex, "instanceModel");
+    fun->glBindAttribLocation (programId, OpenGL::InstanceModelNormalIndex, "instanceModelNormal");
 
     fun->glLinkProgram (programId);
 
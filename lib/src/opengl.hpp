@@ -29,6 +29,7 @@ namespace OpenGL
   unsigned int DepthBufferBit ();
   unsigned int DepthTest ();
   unsigned int DstColor ();
+  unsigned int DynamicDraw ();
   unsigned int ElementArrayBuffer ();
   unsigned int Equal ();
   unsigned int Fill ();
@@ -51,7 +52,9 @@ namespace OpenGL
   unsigned int StencilBufferBit ();
   unsigned int StencilTest ();
   unsigned int Triangles ();
+  unsigned int UnsignedByte ();
   unsigned int UnsignedInt ();
+  unsigned int UnsignedShort ();
   unsigned int Zero ();
 
   void glBindBuffer (unsigned int, unsigned int);
@@ -68,7 +71,10 @@ namespace OpenGL
   void glDepthMask (bool);
   void glDisable (unsigned int);
   void glDisableVertexAttribArray (unsigned int);
+  void glDrawArrays (unsigned int, unsigned int, unsigned int);
   void glDrawElements (unsigned int, unsigned int, unsigned int, const void*);
+  void glDrawElementsInstanced (unsigned int, unsigned int, unsigned int, const void*,
+                                unsigned int);
   void glEnable (unsigned int);
   void glEnableVertexAttribArray (unsigned int);
   void glFrontFace (unsigned int);
@@ -85,6 +91,7 @@ namespace OpenGL
   void glUniformMatrix3fv (int, unsigned int, bool, const float*);
   void glUniformMatrix4fv (int, unsigned int, bool, const float*);
   void glUseProgram (unsigned int);
+  void glVertexAttribDivisor (unsigned int, unsigned int);
   void glVertexAttribPointer (unsigned int, int, unsigned int, bool, unsigned int, const void*);
   void glViewport (unsigned int, unsigned int, unsigned int, unsigned int);
 
@@ -92,10 +99,15 @@ namespace OpenGL
   enum VertexAttributIndex
   {
     PositionIndex = 0,
-    NormalIndex = 1
+    NormalIndex = 1,
+    BarycentricIndex = 2,
+    InstanceColorIndex = 3,
+    InstanceModelIndex = 4,      // mat4: occupies 4 consecutive indices
+    InstanceModelNormalIndex = 8 // mat3: occupies 3 consecutive indices
   };
 
   bool         hasGeometryShader ();
+  bool         hasInstancing ();
   void         glUniformVec3 (unsigned int, const glm::vec3&);
   void         glUniformVec4 (unsigned int, const glm::vec4&);
   void         safeDeleteBuffer (unsigned int&);
@@ -0,0 +1,186 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2017 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "parallel.hpp"
+
+namespace
+{
+  thread_local bool isRunningRange = false;
+
+  /* A call of `forRange` that is shared with the workers.  It lives on the stack of the calling
+   * thread, which waits until no worker is running one of its ranges anymore.
+   */
+  struct Job
+  {
+    const Parallel::RangeCallback* callback;
+    unsigned int                   numElements;
+    unsigned int                   grainSize;
+    std::atomic<unsigned int>      nextElement;
+    unsigned int                   numActive;
+
+    Job (const Parallel::RangeCallback& f, unsigned int n, unsigned int grain)
+      : callback (&f)
+      , numElements (n)
+      , grainSize (grain)
+      , nextElement (0)
+      , numActive (0)
+    {
+    }
+
+    // returns false if all ranges have been claimed
+    bool runRange ()
+    {
+      const unsigned int begin = this->nextElement.fetch_add (this->grainSize);
+
+      if (begin < this->numElements)
+      {
+        (*this->callback) (begin, std::min (this->numElements, begin + this->grainSize));
+        return true;
+      }
+      else
+      {
+        return false;
+      }
+    }
+  };
+
+  /* Concurrent calls of `forRange` (e.g. from the GUI thread and from a background job) are queued
+   * and share the workers: each worker claims one range at a time and continues with the next
+   * queued job, so that no call has to wait for another one to finish.
+   */
+  class ThreadPool
+  {
+  public:
+    ThreadPool ()
+      : stop (false)
+      , nextJob (0)
+    {
+      const unsigned int numThreads = std::max (1u, std::thread::hardware_concurrency ());
+
+      for (unsigned int i = 1; i < numThreads; i++)
+      {
+        this->workers.emplace_back ([this]() { this->workerLoop (); });
+      }
+    }
+
+    ~ThreadPool ()
+    {
+      {
+        std::lock_guard<std::mutex> lock (this->mutex);
+        this->stop = true;
+      }
+      this->startCondition.notify_all ();
+
+      for (std::thread& w : this->workers)
+      {
+        w.join ();
+      }
+    }
+
+    unsigned int numThreads () const { return this->workers.size () + 1; }
+
+    void forRange (unsigned int n, unsigned int grain, const Parallel::RangeCallback& f)
+    {
+      if (n <= grain || this->workers.empty () || isRunningRange)
+      {
+        for (unsigned int begin = 0; begin < n; begin += grain)
+        {
+          f (begin, std::min (n, begin + grain));
+        }
+        return;
+      }
+
+      Job job (f, n, grain);
+      {
+        std::lock_guard<std::mutex> lock (this->mutex);
+        this->jobs.push_back (&job);
+      }
+      this->startCondition.notify_all ();
+
+      isRunningRange = true;
+      while (job.runRange ())
+      {
+      }
+      isRunningRange = false;
+
+      std::unique_lock<std::mutex> lock (this->mutex);
+      this->dequeue (job);
+      this->doneCondition.wait (lock, [&job]() { return job.numActive == 0; });
+    }
+
+  private:
+    // requires a locked mutex
+    void dequeue (Job& job)
+    {
+      const auto it = std::find (this->jobs.begin (), this->jobs.end (), &job);
+
+      if (it != this->jobs.end ())
+      {
+        this->jobs.erase (it);
+      }
+    }
+
+    void workerLoop ()
+    {
+      std::unique_lock<std::mutex> lock (this->mutex);
+
+      while (true)
+      {
+        this->startCondition.wait (lock,
+                                   [this]() { return this->stop || this->jobs.empty () == false; });
+        if (this->stop)
+        {
+          return;
+        }
+
+        Job& job = *this->jobs[this->nextJob++ % this->jobs.size ()];
+        job.numActive++;
+
+        lock.unlock ();
+        isRunningRange = true;
+        const bool ranRange = job.runRange ();
+        isRunningRange = false;
+        lock.lock ();
+
+        if (ranRange == false)
+        {
+          this->dequeue (job);
+        }
+        if (--job.numActive == 0)
+        {
+          this->doneCondition.notify_all ();
+        }
+      }
+    }
+
+    std::vector<std::thread> workers;
+    std::mutex               mutex;
+    std::condition_variable  startCondition;
+    std::condition_variable  doneCondition;
+    bool                     stop;
+    std::vector<Job*>        jobs;
+    unsigned int             nextJob;
+  };
+
+  ThreadPool& threadPool ()
+  {
+    static ThreadPool pool;
+    return pool;
+  }
+}
+
+unsigned int Parallel::numThreads () { return threadPool ().numThreads (); }
+
+void Parallel::forRange (unsigned int n, unsigned int grainSize, const RangeCallback& f)
+{
+  assert (grainSize > 0);
+  threadPool ().forRange (n, grainSize, f);
+}
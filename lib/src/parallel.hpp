@@ -0,0 +1,23 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2017 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#ifndef DILAY_PARALLEL
+#define DILAY_PARALLEL
+
+#include <functional>
+
+namespace Parallel
+{
+  typedef std::function<void(unsigned int, unsigned int)> RangeCallback;
+
+  unsigned int numThreads ();
+
+  /* Splits [0, n) into consecutive ranges of at most `grainSize` elements and calls the callback
+   * once per range.  Ranges are distributed dynamically between the calling thread and a pool of
+   * worker threads that is shared by concurrent calls.  Nested calls run serially.
+   */
+  void forRange (unsigned int n, unsigned int grainSize, const RangeCallback&);
+}
+
+#endif
@@ -0,0 +1,32 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2017 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#include "primitive/frustum.hpp"
+
+namespace
+{
+  glm::vec4 normalizePlane (const glm::vec4& p)
+  {
+    return p / glm::length (glm::vec3 (p));
+  }
+}
+
+constexpr unsigned int PrimFrustum::numPlanes;
+
+// Gribb & Hartmann: Fast Extraction of Viewing Frustum Planes from the
+// World-View-Projection Matrix
+PrimFrustum::PrimFrustum (const glm::mat4x4& m)
+{
+  const glm::vec4 row0 = glm::vec4 (m[0][0], m[1][0], m[2][0], m[3][0]);
+  const glm::vec4 row1 = glm::vec4 (m[0][1], m[1][1], m[2][1], m[3][1]);
+  const glm::vec4 row2 = glm::vec4 (m[0][2], m[1][2], m[2][2], m[3][2]);
+  const glm::vec4 row3 = glm::vec4 (m[0][3], m[1][3], m[2][3], m[3][3]);
+
+  this->_planes[0] = normalizePlane (row3 + row0);
+  this->_planes[1] = normalizePlane (row3 - row0);
+  this->_planes[2] = normalizePlane (row3 + row1);
+  this->_planes[3] = normalizePlane (row3 - row1);
+  this->_planes[4] = normalizePlane (row3 + row2);
+  this->_planes[5] = normalizePlane (row3 - row2);
+}
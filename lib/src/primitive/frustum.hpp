@@ -0,0 +1,27 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2017 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#ifndef DILAY_PRIMITIVE_FRUSTUM
+#define DILAY_PRIMITIVE_FRUSTUM
+
+#include <array>
+#include <glm/glm.hpp>
+
+class PrimFrustum
+{
+public:
+  /* Extracts the planes of a frustum from a (projection * view * model) matrix.  Each plane
+   * (n, d) satisfies dot (n, p) + d >= 0 for points p inside the frustum.
+   */
+  PrimFrustum (const glm::mat4x4&);
+
+  const glm::vec4& plane (unsigned int i) const { return this->_planes[i]; }
+
+  static constexpr unsigned int numPlanes = 6;
+
+private:
+  std::array<glm::vec4, numPlanes> _planes;
+};
+
+#endif
@@ -2,7 +2,9 @@
  * Copyright © 2015-2017 Alexander Bau
  * Use and redistribute under the terms of the GNU General Public License
  */
+#include <cassert>
 #include <cstdlib>
+#include "opengl.hpp"
 #include "render-mode.hpp"
 #include "shader.hpp"
 #include "util.hpp"
@@ -13,6 +15,7 @@ RenderMode::RenderMode ()
   this->renderWireframe (false);
   this->cameraRotationOnly (false);
   this->noDepthTest (false);
+  this->instanced (false);
 }
 
 RenderMode::RenderMode (const RenderMode& other)
@@ -32,9 +35,49 @@ bool RenderMode::cameraRotationOnly () const { return this->flags.get<4> (); }
 
 bool RenderMode::noDepthTest () const { return this->flags.get<5> (); }
 
+bool RenderMode::instanced () const { return this->flags.get<6> (); }
+
 const char* RenderMode::vertexShader () const
 {
-  if (this->smoothShading ())
+  if (this->instanced ())
+  {
+    if (this->smoothShading ())
+    {
+      return Shader::smoothInstancedVertexShader ();
+    }
+    else if (this->flatShading ())
+    {
+      return Shader::flatInstancedVertexShader ();
+    }
+    else if (this->constantShading ())
+    {
+      return Shader::constantInstancedVertexShader ();
+    }
+    else
+    {
+      DILAY_IMPOSSIBLE
+    }
+  }
+  else if (this->renderWireframe () && OpenGL::hasGeometryShader () == false)
+  {
+    if (this->smoothShading ())
+    {
+      return Shader::smoothBarycentricVertexShader ();
+    }
+    else if (this->flatShading ())
+    {
+      return Shader::flatBarycentricVertexShader ();
+    }
+    else if (this->constantShading ())
+    {
+      return Shader::constantBarycentricVertexShader ();
+    }
+    else
+    {
+      DILAY_IMPOSSIBLE
+    }
+  }
+  else if (this->smoothShading ())
   {
     return Shader::smoothVertexShader ();
   }
@@ -54,7 +97,34 @@ const char* RenderMode::vertexShader () const
 
 const char* RenderMode::fragmentShader () const
 {
-  if (this->smoothShading ())
+  if (this->instanced ())
+  {
+    assert (this->renderWireframe () == false);
+
+    // instanced vertex shaders compute the final color, except for flat shading
+    return this->flatShading () ? Shader::flatInstancedFragmentShader ()
+                                : Shader::smoothFragmentShader ();
+  }
+  else if (this->renderWireframe () && OpenGL::hasGeometryShader () == false)
+  {
+    if (this->smoothShading ())
+    {
+      return Shader::smoothBarycentricFragmentShader ();
+    }
+    else if (this->flatShading ())
+    {
+      return Shader::flatBarycentricFragmentShader ();
+    }
+    else if (this->constantShading ())
+    {
+      return Shader::constantWireframeFragmentShader ();
+    }
+    else
+    {
+      DILAY_IMPOSSIBLE
+    }
+  }
+  else if (this->smoothShading ())
   {
     return this->renderWireframe () ? Shader::smoothWireframeFragmentShader ()
                                     : Shader::smoothFragmentShader ();
@@ -110,3 +180,5 @@ void RenderMode::renderWireframe (bool v) { this->flags.set<3> (v); }
 void RenderMode::cameraRotationOnly (bool v) { this->flags.set<4> (v); }
 
 void RenderMode::noDepthTest (bool v) { this->flags.set<5> (v); }
+
+void RenderMode::instanced (bool v) { this->flags.set<6> (v); }
@@ -3,6 +3,7 @@
  * Use and redistribute under the terms of the GNU General Public License
  */
 #include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
 #include "color.hpp"
 #include "config.hpp"
 #include "opengl.hpp"
@@ -14,6 +15,54 @@ namespace
 {
   const unsigned int numLights = 2;
 
+  // remembers the last value of a uniform in order to skip redundant uploads
+  template <typename T> struct CachedUniform
+  {
+    T    value;
+    bool isSet;
+
+    CachedUniform ()
+      : isSet (false)
+    {
+    }
+
+    bool update (const T& v)
+    {
+      if (this->isSet && this->value == v)
+      {
+        return false;
+      }
+      this->value = v;
+      this->isSet = true;
+      return true;
+    }
+  };
+
+  /* Uniforms are part of a program's state, i.e. they keep their values when other programs are
+   * used.  Thus uniforms are only uploaded if they differ from the values in the program.
+   */
+  struct UniformCache
+  {
+    CachedUniform<glm::mat4x4> model;
+    CachedUniform<glm::mat3x3> modelNormal;
+    CachedUniform<glm::mat4x4> view;
+    CachedUniform<glm::mat4x4> projection;
+    CachedUniform<glm::vec4>   color;
+    CachedUniform<glm::vec4>   wireframeColor;
+    unsigned int               globalUniformsVersion;
+
+    UniformCache ()
+      : globalUniformsVersion (0)
+    {
+    }
+  };
+
+  // colors without opacity are cached with a negative opacity
+  glm::vec4 cacheKey (const Color& c, bool withOpacity)
+  {
+    return withOpacity ? c.vec4 () : glm::vec4 (c.vec3 (), -1.0f);
+  }
+
   struct LightIds
   {
     int directionId;
@@ -40,6 +89,7 @@ namespace
     int          eyePointId;
     int          barycentricId;
     LightIds     lightIds[numLights];
+    UniformCache cache;
 
     ShaderIds ()
       : programId (0)
@@ -71,15 +121,17 @@ namespace
 
 struct Renderer::Impl
 {
-  static const unsigned int numShaders = 6;
+  static const unsigned int numShaders = 9;
 
   ShaderIds      shaderIds[Impl::numShaders];
   ShaderIds*     activeShaderIndex;
   GlobalUniforms globalUniforms;
+  unsigned int   globalUniformsVersion;
   Color          clearColor;
 
   Impl (const Config& config)
     : activeShaderIndex (nullptr)
+    , globalUniformsVersion (1)
   {
     this->runFromConfig (config);
   }
@@ -94,6 +146,9 @@ struct Renderer::Impl
 
   void setupRendering ()
   {
+    // other painters may have changed the active program since the last frame
+    this->activeShaderIndex = nullptr;
+
     OpenGL::glClearColor (this->clearColor.r (), this->clearColor.g (), this->clearColor.b (),
                           0.0f);
     OpenGL::glClearStencil (0);
@@ -113,7 +168,28 @@ struct Renderer::Impl
 
   unsigned int shaderIndex (const RenderMode& renderMode)
   {
-    if (renderMode.smoothShading ())
+    if (renderMode.instanced ())
+    {
+      assert (renderMode.renderWireframe () == false);
+
+      if (renderMode.smoothShading ())
+      {
+        return 6;
+      }
+      else if (renderMode.flatShading ())
+      {
+        return 7;
+      }
+      else if (renderMode.constantShading ())
+      {
+        return 8;
+      }
+      else
+      {
+        DILAY_IMPOSSIBLE
+      }
+    }
+    else if (renderMode.smoothShading ())
     {
       return renderMode.renderWireframe () ? 0 : 1;
     }
@@ -133,10 +209,9 @@ struct Renderer::Impl
 
   void initalizeProgram (const RenderMode& renderMode)
   {
-    assert (renderMode.renderWireframe () == false || OpenGL::hasGeometryShader ());
-
-    const unsigned int id = OpenGL::loadProgram (
-      renderMode.vertexShader (), renderMode.fragmentShader (), renderMode.renderWireframe ());
+    const unsigned int id =
+      OpenGL::loadProgram (renderMode.vertexShader (), renderMode.fragmentShader (),
+                           renderMode.renderWireframe () && OpenGL::hasGeometryShader ());
 
     unsigned int index = this->shaderIndex (renderMode);
     assert (this->shaderIds[index].programId == 0);
@@ -170,46 +245,75 @@ struct Renderer::Impl
     }
     assert (this->shaderIds[index].programId);
 
-    this->activeShaderIndex = &this->shaderIds[index];
-    OpenGL::glUseProgram (this->activeShaderIndex->programId);
+    if (this->activeShaderIndex != &this->shaderIds[index])
+    {
+      this->activeShaderIndex = &this->shaderIds[index];
+      OpenGL::glUseProgram (this->activeShaderIndex->programId);
+    }
 
-    OpenGL::glUniformVec3 (this->activeShaderIndex->eyePointId, this->globalUniforms.eyePoint);
+    ShaderIds* s = this->activeShaderIndex;
 
-    for (unsigned int i = 0; i < numLights; i++)
+    if (s->cache.globalUniformsVersion != this->globalUniformsVersion)
     {
-      OpenGL::glUniformVec3 (this->activeShaderIndex->lightIds[i].directionId,
-                             this->globalUniforms.lightUniforms[i].direction);
-      OpenGL::glUniformVec3 (this->activeShaderIndex->lightIds[i].colorId,
-                             this->globalUniforms.lightUniforms[i].color.vec3 ());
-      OpenGL::glUniform1f (this->activeShaderIndex->lightIds[i].irradianceId,
-                           this->globalUniforms.lightUniforms[i].irradiance);
+      OpenGL::glUniformVec3 (s->eyePointId, this->globalUniforms.eyePoint);
+
+      for (unsigned int i = 0; i < numLights; i++)
+      {
+        OpenGL::glUniformVec3 (s->lightIds[i].directionId,
+                               this->globalUniforms.lightUniforms[i].direction);
+        OpenGL::glUniformVec3 (s->lightIds[i].colorId,
+                               this->globalUniforms.lightUniforms[i].color.vec3 ());
+        OpenGL::glUniform1f (s->lightIds[i].irradianceId,
+                             this->globalUniforms.lightUniforms[i].irradiance);
+      }
+      s->cache.globalUniformsVersion = this->globalUniformsVersion;
     }
   }
 
   void setModel (const float* model, const float* modelNormal)
   {
     assert (this->activeShaderIndex);
-    OpenGL::glUniformMatrix4fv (this->activeShaderIndex->modelId, 1, false, model);
-    OpenGL::glUniformMatrix3fv (this->activeShaderIndex->modelNormalId, 1, false, modelNormal);
+    UniformCache& cache = this->activeShaderIndex->cache;
+
+    if (cache.model.update (glm::make_mat4x4 (model)))
+    {
+      OpenGL::glUniformMatrix4fv (this->activeShaderIndex->modelId, 1, false, model);
+    }
+    if (cache.modelNormal.update (glm::make_mat3x3 (modelNormal)))
+    {
+      OpenGL::glUniformMatrix3fv (this->activeShaderIndex->modelNormalId, 1, false, modelNormal);
+    }
   }
 
   void setView (const float* view)
   {
     assert (this->activeShaderIndex);
-    OpenGL::glUniformMatrix4fv (this->activeShaderIndex->viewId, 1, false, view);
+
+    if (this->activeShaderIndex->cache.view.update (glm::make_mat4x4 (view)))
+    {
+      OpenGL::glUniformMatrix4fv (this->activeShaderIndex->viewId, 1, false, view);
+    }
   }
 
   void setProjection (const float* projection)
   {
     assert (this->activeShaderIndex);
-    OpenGL::glUniformMatrix4fv (this->activeShaderIndex->projectionId, 1, false, projection);
+
+    if (this->activeShaderIndex->cache.projection.update (glm::make_mat4x4 (projection)))
+    {
+      OpenGL::glUniformMatrix4fv (this->activeShaderIndex->projectionId, 1, false, projection);
+    }
   }
 
   void setColor (const Color& c, bool withOpacity)
   {
     assert (this->activeShaderIndex);
 
-    if (withOpacity)
+    if (this->activeShaderIndex->cache.color.update (cacheKey (c, withOpacity)) == false)
+    {
+      return;
+    }
+    else if (withOpacity)
     {
       OpenGL::glUniformVec4 (this->activeShaderIndex->colorId, c.vec4 ());
     }
@@ -223,7 +327,11 @@ struct Renderer::Impl
   {
     assert (this->activeShaderIndex);
 
-    if (withOpacity)
+    if (this->activeShaderIndex->cache.wireframeColor.update (cacheKey (c, withOpacity)) == false)
+    {
+      return;
+    }
+    else if (withOpacity)
     {
       OpenGL::glUniformVec4 (this->activeShaderIndex->wireframeColorId, c.vec4 ());
     }
@@ -233,24 +341,37 @@ struct Renderer::Impl
     }
   }
 
-  void setEyePoint (const glm::vec3& e) { this->globalUniforms.eyePoint = e; }
+  // programs receive modified global uniforms by the next call to `setProgram`
+  template <typename T> void setGlobalUniform (T& uniform, const T& value)
+  {
+    uniform = value;
+    this->globalUniformsVersion++;
+  }
+
+  void setEyePoint (const glm::vec3& e)
+  {
+    if (this->globalUniforms.eyePoint != e)
+    {
+      this->setGlobalUniform (this->globalUniforms.eyePoint, e);
+    }
+  }
 
   void setLightDirection (unsigned int i, const glm::vec3& d)
   {
     assert (i < numLights);
-    this->globalUniforms.lightUniforms[i].direction = d;
+    this->setGlobalUniform (this->globalUniforms.lightUniforms[i].direction, d);
   }
 
   void setLightColor (unsigned int i, const Color& c)
   {
     assert (i < numLights);
-    this->globalUniforms.lightUniforms[i].color = c;
+    this->setGlobalUniform (this->globalUniforms.lightUniforms[i].color, c);
   }
 
   void setLightIrradiance (unsigned int i, float irr)
   {
     assert (i < numLights);
-    this->globalUniforms.lightUniforms[i].irradiance = irr;
+    this->setGlobalUniform (this->globalUniforms.lightUniforms[i].irradiance, irr);
   }
 
   void runFromConfig (const Config& config)
@@ -2,7 +2,10 @@
  * Copyright © 2015-2017 Alexander Bau
  * Use and redistribute under the terms of the GNU General Public License
  */
+#include <glm/glm.hpp>
 #include <list>
+#include <vector>
+#include "bvh.hpp"
 #include "config.hpp"
 #include "dynamic/mesh-intersection.hpp"
 #include "dynamic/mesh.hpp"
@@ -17,16 +20,71 @@
 #include "sketch/path-intersection.hpp"
 #include "util.hpp"
 
+namespace
+{
+  /* Meshes are intersected in the order of a bounding volume hierarchy over their bounding
+   * boxes.  The hierarchy is rebuilt if meshes have been added or deleted.  Otherwise only the
+   * leaves of meshes whose bounding boxes have changed (e.g. by sculpting or moving a mesh) are
+   * refitted.  Meshes cache their bounding boxes, i.e. `minMax` does not visit their geometry
+   * unless it has been modified since the last query.
+   */
+  template <typename T> struct MeshBvh
+  {
+    Bvh             bvh;
+    std::vector<T*> meshes;
+    bool            isOutdated;
+
+    MeshBvh ()
+      : isOutdated (true)
+    {
+    }
+
+    void update (std::list<T>& list)
+    {
+      glm::vec3 min, max;
+
+      if (this->isOutdated)
+      {
+        this->bvh.reset ();
+        this->meshes.clear ();
+
+        for (T& mesh : list)
+        {
+          mesh.minMax (min, max);
+          this->bvh.addElement (min, max);
+          this->meshes.push_back (&mesh);
+        }
+        this->bvh.build ();
+        this->isOutdated = false;
+      }
+      else
+      {
+        assert (this->meshes.size () == list.size ());
+
+        for (unsigned int i = 0; i < this->meshes.size (); i++)
+        {
+          this->meshes[i]->minMax (min, max);
+          this->bvh.updateElement (i, min, max);
+        }
+      }
+    }
+  };
+}
+
 struct Scene::Impl
 {
   Scene*                 self;
   std::list<DynamicMesh> dynamicMeshes;
   std::list<SketchMesh>  sketchMeshes;
+  MeshBvh<DynamicMesh>   dynamicMeshBvh;
+  MeshBvh<SketchMesh>    sketchMeshBvh;
   RenderMode             commonRenderMode;
   std::string            fileName;
+  ImportExport::Format   fileFormat;
 
   Impl (Scene* s, const Config& config)
     : self (s)
+    , fileFormat (ImportExport::Format::BinaryDly)
   {
     this->runFromConfig (config);
 
@@ -36,6 +94,7 @@ struct Scene::Impl
   DynamicMesh& newDynamicMesh (const Config& config, const DynamicMesh& other)
   {
     this->dynamicMeshes.emplace_back (other);
+    this->dynamicMeshBvh.isOutdated = true;
     this->setupMesh (config, this->dynamicMeshes.back ());
     return this->dynamicMeshes.back ();
   }
@@ -43,6 +102,7 @@ struct Scene::Impl
   DynamicMesh& newDynamicMesh (const Config& config, const Mesh& mesh)
   {
     this->dynamicMeshes.emplace_back (mesh);
+    this->dynamicMeshBvh.isOutdated = true;
     this->setupMesh (config, this->dynamicMeshes.back ());
     return this->dynamicMeshes.back ();
   }
@@ -50,6 +110,7 @@ struct Scene::Impl
   SketchMesh& newSketchMesh (const Config& config, const SketchMesh& other)
   {
     this->sketchMeshes.emplace_back (other);
+    this->sketchMeshBvh.isOutdated = true;
     this->setupMesh (config, this->sketchMeshes.back ());
     return this->sketchMeshes.back ();
   }
@@ -57,6 +118,7 @@ struct Scene::Impl
   SketchMesh& newSketchMesh (const Config& config, const SketchTree& tree)
   {
     this->sketchMeshes.emplace_back ();
+    this->sketchMeshBvh.isOutdated = true;
     this->sketchMeshes.back ().fromTree (tree);
     this->setupMesh (config, this->sketchMeshes.back ());
     return this->sketchMeshes.back ();
@@ -64,8 +126,8 @@ struct Scene::Impl
 
   void setupMesh (const Config& config, DynamicMesh& mesh)
   {
-    mesh.bufferData ();
     mesh.renderMode () = this->commonRenderMode;
+    mesh.bufferData ();
     mesh.fromConfig (config);
   }
 
@@ -82,6 +144,7 @@ struct Scene::Impl
       if (&*it == &mesh)
       {
         this->dynamicMeshes.erase (it);
+        this->dynamicMeshBvh.isOutdated = true;
         this->resetIfEmpty ();
         return;
       }
@@ -96,6 +159,7 @@ struct Scene::Impl
       if (&*it == &mesh)
       {
         this->sketchMeshes.erase (it);
+        this->sketchMeshBvh.isOutdated = true;
         this->resetIfEmpty ();
         return;
       }
@@ -103,12 +167,23 @@ struct Scene::Impl
     DILAY_IMPOSSIBLE
   }
 
-  void deleteDynamicMeshes () { this->dynamicMeshes.clear (); }
+  void deleteDynamicMeshes ()
+  {
+    this->dynamicMeshes.clear ();
+    this->dynamicMeshBvh.isOutdated = true;
+  }
 
-  void deleteSketchMeshes () { this->sketchMeshes.clear (); }
+  void deleteSketchMeshes ()
+  {
+    this->sketchMeshes.clear ();
+    this->sketchMeshBvh.isOutdated = true;
+  }
 
   void deleteEmptyMeshes ()
   {
+    this->dynamicMeshBvh.isOutdated = true;
+    this->sketchMeshBvh.isOutdated = true;
+
     for (auto it = this->dynamicMeshes.begin (); it != this->dynamicMeshes.end ();)
     {
       if (it->isEmpty ())
@@ -141,43 +216,52 @@ struct Scene::Impl
   }
 
   template <typename TMesh, typename TIntersection, typename... Ts>
-  bool intersectsT (const PrimRay& ray, TIntersection& intersection, Ts... args)
-  {
-    this->forEachMesh ([&ray, &intersection, &args...](TMesh& m) {
-      m.intersects (ray, intersection, std::forward<Ts> (args)...);
-    });
+  bool intersectsT (MeshBvh<TMesh>& meshBvh, std::list<TMesh>& meshes, const PrimRay& ray,
+                    TIntersection& intersection, Ts... args)
+  {
+    meshBvh.update (meshes);
+    meshBvh.bvh.closestIntersection (
+      ray, [&meshBvh, &ray, &intersection, &args...](unsigned int i, float& t) {
+        if (meshBvh.meshes[i]->intersects (ray, intersection, std::forward<Ts> (args)...))
+        {
+          t = intersection.distance ();
+          return true;
+        }
+        return false;
+      });
     return intersection.isIntersection ();
   }
 
   bool intersects (const PrimRay& ray, DynamicMeshIntersection& intersection)
   {
-    return this->intersectsT<DynamicMesh> (ray, intersection);
+    return this->intersectsT (this->dynamicMeshBvh, this->dynamicMeshes, ray, intersection);
   }
 
   bool intersects (const PrimRay& ray, SketchNodeIntersection& intersection)
   {
-    return this->intersectsT<SketchMesh> (ray, intersection);
+    return this->intersectsT (this->sketchMeshBvh, this->sketchMeshes, ray, intersection);
   }
 
   bool intersects (const PrimRay& ray, SketchBoneIntersection& intersection)
   {
-    return this->intersectsT<SketchMesh> (ray, intersection);
+    return this->intersectsT (this->sketchMeshBvh, this->sketchMeshes, ray, intersection);
   }
 
   bool intersects (const PrimRay& ray, SketchMeshIntersection& intersection)
   {
-    return this->intersectsT<SketchMesh> (ray, intersection);
+    return this->intersectsT (this->sketchMeshBvh, this->sketchMeshes, ray, intersection);
   }
 
   bool intersects (const PrimRay& ray, SketchMeshIntersection& intersection,
                    unsigned int numExcludedLastPaths)
   {
-    return this->intersectsT<SketchMesh> (ray, intersection, numExcludedLastPaths);
+    return this->intersectsT (this->sketchMeshBvh, this->sketchMeshes, ray, intersection,
+                              numExcludedLastPaths);
   }
 
   bool intersects (const PrimRay& ray, SketchPathIntersection& intersection)
   {
-    return this->intersectsT<SketchMesh> (ray, intersection);
+    return this->intersectsT (this->sketchMeshBvh, this->sketchMeshes, ray, intersection);
   }
 
   bool intersects (const PrimRay& ray, Intersection& intersection)
@@ -289,6 +373,7 @@ struct Scene::Impl
     this->deleteDynamicMeshes ();
     this->deleteSketchMeshes ();
     this->fileName.clear ();
+    this->fileFormat = ImportExport::Format::BinaryDly;
   }
 
   void resetIfEmpty ()
@@ -302,7 +387,10 @@ struct Scene::Impl
   void setCommonRenderMode (const RenderMode& mode)
   {
     this->commonRenderMode = mode;
-    this->forEachMesh ([this](DynamicMesh& mesh) { mesh.renderMode () = this->commonRenderMode; });
+    this->forEachMesh ([this](DynamicMesh& mesh) {
+      mesh.renderMode () = this->commonRenderMode;
+      mesh.bufferData ();
+    });
     this->forEachMesh (
       [&mode](SketchMesh& mesh) { mesh.renderWireframe (mode.renderWireframe ()); });
   }
@@ -345,12 +433,12 @@ struct Scene::Impl
 
   bool hasFileName () const { return !this->fileName.empty (); }
 
-  bool toDlyFile (bool isObjFile)
+  bool toDlyFile ()
   {
     assert (this->hasFileName ());
 
-    return Util::withCLocale<bool> ([this, isObjFile]() {
-      if (ImportExport::toDlyFile (this->fileName, *this->self, isObjFile))
+    return Util::withCLocale<bool> ([this]() {
+      if (ImportExport::toDlyFile (this->fileName, *this->self, this->fileFormat))
       {
         return true;
       }
@@ -362,15 +450,17 @@ struct Scene::Impl
     });
   }
 
-  bool toDlyFile (const std::string& newFileName, bool isObjFile)
+  bool toDlyFile (const std::string& newFileName, ImportExport::Format format)
   {
     this->fileName = newFileName;
-    return this->toDlyFile (isObjFile);
+    this->fileFormat = format;
+    return this->toDlyFile ();
   }
 
   bool fromDlyFile (const Config& config, const std::string& newFileName)
   {
     this->fileName = newFileName;
+    this->fileFormat = ImportExport::fileFormat (newFileName);
 
     if (ImportExport::fromDlyFile (this->fileName, config, *this->self))
     {
@@ -429,7 +519,8 @@ DELEGATE_CONST (unsigned int, Scene, numSketchMeshes)
 DELEGATE_CONST (unsigned int, Scene, numFaces)
 DELEGATE_CONST (bool, Scene, hasFileName)
 GETTER_CONST (const std::string&, Scene, fileName)
-DELEGATE1 (bool, Scene, toDlyFile, bool)
-DELEGATE2 (bool, Scene, toDlyFile, const std::string&, bool)
+GETTER_CONST (ImportExport::Format, Scene, fileFormat)
+DELEGATE (bool, Scene, toDlyFile)
+DELEGATE2 (bool, Scene, toDlyFile, const std::string&, ImportExport::Format)
 DELEGATE2 (bool, Scene, fromDlyFile, const Config&, const std::string&)
 DELEGATE1 (void, Scene, runFromConfig, const Config&)
@@ -4,16 +4,14 @@
  */
 #include "shader.hpp"
 
-#define SMOOTH_VERTEX_SHADER                                                                   \
+#define SMOOTH_VERTEX_SHADER_FOR(INPUTS, MODEL, MODEL_NORMAL, COLOR, DECLARATIONS, MAIN)       \
   "#version 120                                                                            \n" \
   "                                                                                        \n" \
-  "uniform   mat4  model;                                                                  \n" \
-  "uniform   mat3  modelNormal;                                                            \n" \
+  INPUTS                                                                                       \
   "uniform   mat4  view;                                                                   \n" \
   "uniform   mat4  projection;                                                             \n" \
   "attribute vec3  position;                                                               \n" \
   "attribute vec3  normal;                                                                 \n" \
-  "uniform   vec3  color;                                                                  \n" \
   "uniform   vec3  light1Direction;                                                        \n" \
   "uniform   vec3  light1Color;                                                            \n" \
   "uniform   float light1Irradiance;                                                       \n" \
@@ -22,15 +20,17 @@
   "uniform   float light2Irradiance;                                                       \n" \
   "                                                                                        \n" \
   "varying vec3 vsColor;                                                                   \n" \
+  DECLARATIONS                                                                                 \
   "                                                                                        \n" \
   "void main () {                                                                          \n" \
-  "  gl_Position      = (projection * view * model) * vec4 (position, 1.0);                \n" \
-  "  vec3  viewNormal = vec3 (view * vec4 (normalize (modelNormal * normal), 0.0));        \n" \
+  "  gl_Position      = (projection * view * " MODEL ") * vec4 (position, 1.0);            \n" \
+  "  vec3  viewNormal = vec3 (view * vec4 (normalize (" MODEL_NORMAL " * normal), 0.0));   \n" \
   "  float light1Diff = max (0.0, dot (-light1Direction, viewNormal));                     \n" \
   "  float light2Diff = max (0.0, dot (-light2Direction, viewNormal));                     \n" \
   "  vec3  light1     = light1Irradiance * light1Color * light1Diff;                       \n" \
   "  vec3  light2     = light2Irradiance * light2Color * light2Diff;                       \n" \
-  "        vsColor    = color * (light1 + light2);                                         \n" \
+  "        vsColor    = " COLOR " * (light1 + light2);                                     \n" \
+  MAIN                                                                                         \
   "}                                                                                       \n"
 
 #define SMOOTH_FRAGMENT_SHADER(COLOR, FINAL)                                                   \
@@ -45,27 +45,28 @@
   "  gl_FragColor = vec4 (" COLOR                                                              \
   ", 1.0);                                                 \n" FINAL                           \
   "}                                                                                       \n"
-
-#define FLAT_VERTEX_SHADER                                                                     \
+#define FLAT_VERTEX_SHADER_FOR(INPUTS, MODEL, DECLARATIONS, MAIN)                              \
   "#version 120                                                                            \n" \
   "                                                                                        \n" \
-  "uniform   mat4 model;                                                                   \n" \
+  INPUTS                                                                                       \
   "uniform   mat4 view;                                                                    \n" \
   "uniform   mat4 projection;                                                              \n" \
   "attribute vec3 position;                                                                \n" \
   "                                                                                        \n" \
   "varying vec3 vsColor;                                                                   \n" \
+  DECLARATIONS                                                                                 \
   "                                                                                        \n" \
   "void main () {                                                                          \n" \
-  "  gl_Position = (projection * view * model) * vec4 (position,1.0);                      \n" \
-  "  vsColor     = vec3 (model * vec4 (position, 1.0));                                    \n" \
+  "  gl_Position = (projection * view * " MODEL ") * vec4 (position,1.0);                  \n" \
+  "  vsColor     = vec3 (" MODEL " * vec4 (position, 1.0));                                \n" \
+  MAIN                                                                                         \
   "}                                                                                       \n"
 
-#define FLAT_FRAGMENT_SHADER(COLOR, FINAL)                                                     \
+#define FLAT_FRAGMENT_SHADER_FOR(INPUTS, COLOR, DIFFUSE, FINAL)                                \
   "#version 120                                                                            \n" \
   "                                                                                        \n" \
+  INPUTS                                                                                       \
   "uniform mat4  view;                                                                     \n" \
-  "uniform vec3  color;                                                                    \n" \
   "uniform vec3  wireframeColor;                                                           \n" \
   "uniform vec3  light1Direction;                                                          \n" \
   "uniform vec3  light1Color;                                                              \n" \
@@ -86,20 +87,22 @@
   "  vec3  light1     = light1Irradiance * light1Color * vec3 (light1Diff);                \n" \
   "  vec3  light2     = light2Irradiance * light2Color * vec3 (light2Diff);                \n" \
   "                                                                                        \n" \
-  "  gl_FragColor     = vec4 (color * (light1 + light2), 1.0);                             "   \
-  "\n" FINAL                                                                                   \
+  "  gl_FragColor     = vec4 (" DIFFUSE " * (light1 + light2), 1.0);                       \n" \
+  FINAL                                                                                        \
   "}                                                                                       \n"
 
-#define CONSTANT_VERTEX_SHADER                                                                 \
+#define CONSTANT_VERTEX_SHADER_FOR(INPUTS, MODEL, DECLARATIONS, MAIN)                          \
   "#version 120                                                                            \n" \
   "                                                                                        \n" \
-  "uniform   mat4 model;                                                                   \n" \
+  INPUTS                                                                                       \
   "uniform   mat4 view;                                                                    \n" \
   "uniform   mat4 projection;                                                              \n" \
   "attribute vec3 position;                                                                \n" \
+  DECLARATIONS                                                                                 \
   "                                                                                        \n" \
   "void main(){                                                                            \n" \
-  "  gl_Position = (projection * view * model) * vec4 (position,1.0);                      \n" \
+  "  gl_Position = (projection * view * " MODEL ") * vec4 (position,1.0);                  \n" \
+  MAIN                                                                                         \
   "}                                                                                       \n"
 
 #define CONSTANT_FRAGMENT_SHADER(FINAL)                                                        \
@@ -114,6 +117,55 @@
   "  gl_FragColor = vec4 (color, 1.0);                                                     "   \
   "\n" FINAL                                                                                   \
   "}                                                                                       \n"
+#define SMOOTH_UNIFORM_DECLARATIONS                                                            \
+  "uniform   mat4  model;                                                                  \n" \
+  "uniform   mat3  modelNormal;                                                            \n" \
+  "uniform   vec3  color;                                                                  \n"
+
+#define MODEL_UNIFORM_DECLARATION                                                              \
+  "uniform   mat4 model;                                                                   \n"
+
+#define SMOOTH_VERTEX_SHADER(DECLARATIONS, MAIN)                                               \
+  SMOOTH_VERTEX_SHADER_FOR (SMOOTH_UNIFORM_DECLARATIONS, "model", "modelNormal", "color",      \
+                            DECLARATIONS, MAIN)
+
+#define FLAT_VERTEX_SHADER(DECLARATIONS, MAIN)                                                 \
+  FLAT_VERTEX_SHADER_FOR (MODEL_UNIFORM_DECLARATION, "model", DECLARATIONS, MAIN)
+
+#define FLAT_FRAGMENT_SHADER(COLOR, FINAL)                                                     \
+  FLAT_FRAGMENT_SHADER_FOR ("uniform vec3 color;\n", COLOR, "color", FINAL)
+
+#define CONSTANT_VERTEX_SHADER(DECLARATIONS, MAIN)                                             \
+  CONSTANT_VERTEX_SHADER_FOR (MODEL_UNIFORM_DECLARATION, "model", DECLARATIONS, MAIN)
+
+/* The instanced variants read the model matrices and colors from per-instance attributes
+ * (cf. `MeshInstances`) instead of uniforms.
+ */
+#define INSTANCE_ATTRIBUTE_DECLARATIONS                                                        \
+  "attribute vec3 instanceColor;                                                           \n" \
+  "attribute mat4 instanceModel;                                                           \n"
+
+#define PASS_INSTANCE_COLOR_DECLARATIONS                                                       \
+  "varying vec3 vsInstanceColor;                                                           \n"
+
+#define PASS_INSTANCE_COLOR                                                                    \
+  "  vsInstanceColor = instanceColor;                                                      \n"
+
+#define SMOOTH_INSTANCED_VERTEX_SHADER                                                         \
+  SMOOTH_VERTEX_SHADER_FOR (INSTANCE_ATTRIBUTE_DECLARATIONS                                    \
+                            "attribute mat3 instanceModelNormal;\n",                           \
+                            "instanceModel", "instanceModelNormal", "instanceColor", "", "")
+
+#define FLAT_INSTANCED_VERTEX_SHADER                                                           \
+  FLAT_VERTEX_SHADER_FOR (INSTANCE_ATTRIBUTE_DECLARATIONS, "instanceModel",                    \
+                          PASS_INSTANCE_COLOR_DECLARATIONS, PASS_INSTANCE_COLOR)
+
+#define FLAT_INSTANCED_FRAGMENT_SHADER                                                         \
+  FLAT_FRAGMENT_SHADER_FOR (PASS_INSTANCE_COLOR_DECLARATIONS, "vsColor", "vsInstanceColor", "")
+
+#define CONSTANT_INSTANCED_VERTEX_SHADER                                                       \
+  CONSTANT_VERTEX_SHADER_FOR (INSTANCE_ATTRIBUTE_DECLARATIONS, "instanceModel",                \
+                              "varying vec3 vsColor;\n", "  vsColor = instanceColor;\n")
 
 #define ADD_WIREFRAME                                                                          \
   "vec3 barycDelta = fwidth (barycentric);                                                 \n" \
@@ -123,6 +175,13 @@
   "                                                                                        \n" \
   "gl_FragColor.rgb = mix (wireframeColor, gl_FragColor.rgb, minEdgeFactor);               \n"
 
+#define PASS_BARYCENTRIC_DECLARATIONS                                                          \
+  "attribute vec3 vertexBarycentric;                                                       \n" \
+  "varying   vec3 barycentric;                                                             \n"
+
+#define PASS_BARYCENTRIC                                                                       \
+  "  barycentric = vertexBarycentric;                                                      \n"
+
 #define GEOMETRY_SHADER                                                                        \
   "#extension GL_EXT_geometry_shader4: require                                             \n" \
   "                                                                                        \n" \
@@ -149,7 +208,7 @@
   "    EndPrimitive();                                                                     \n" \
   "}                                                                                       \n"
 
-const char* Shader::smoothVertexShader () { return SMOOTH_VERTEX_SHADER; }
+const char* Shader::smoothVertexShader () { return SMOOTH_VERTEX_SHADER ("", ""); }
 
 const char* Shader::smoothFragmentShader () { return SMOOTH_FRAGMENT_SHADER ("vsColor", ""); }
 
@@ -158,7 +217,7 @@ const char* Shader::smoothWireframeFragmentShader ()
   return SMOOTH_FRAGMENT_SHADER ("gsColor", ADD_WIREFRAME);
 }
 
-const char* Shader::flatVertexShader () { return FLAT_VERTEX_SHADER; }
+const char* Shader::flatVertexShader () { return FLAT_VERTEX_SHADER ("", ""); }
 
 const char* Shader::flatFragmentShader () { return FLAT_FRAGMENT_SHADER ("vsColor", ""); }
 
@@ -167,7 +226,7 @@ const char* Shader::flatWireframeFragmentShader ()
   return FLAT_FRAGMENT_SHADER ("gsColor", ADD_WIREFRAME);
 }
 
-const char* Shader::constantVertexShader () { return CONSTANT_VERTEX_SHADER; }
+const char* Shader::constantVertexShader () { return CONSTANT_VERTEX_SHADER ("", ""); }
 
 const char* Shader::constantFragmentShader () { return CONSTANT_FRAGMENT_SHADER (""); }
 
@@ -176,4 +235,37 @@ const char* Shader::constantWireframeFragmentShader ()
   return CONSTANT_FRAGMENT_SHADER (ADD_WIREFRAME);
 }
 
+const char* Shader::smoothBarycentricVertexShader ()
+{
+  return SMOOTH_VERTEX_SHADER (PASS_BARYCENTRIC_DECLARATIONS, PASS_BARYCENTRIC);
+}
+
+const char* Shader::smoothBarycentricFragmentShader ()
+{
+  return SMOOTH_FRAGMENT_SHADER ("vsColor", ADD_WIREFRAME);
+}
+
+const char* Shader::flatBarycentricVertexShader ()
+{
+  return FLAT_VERTEX_SHADER (PASS_BARYCENTRIC_DECLARATIONS, PASS_BARYCENTRIC);
+}
+
+const char* Shader::flatBarycentricFragmentShader ()
+{
+  return FLAT_FRAGMENT_SHADER ("vsColor", ADD_WIREFRAME);
+}
+
+const char* Shader::constantBarycentricVertexShader ()
+{
+  return CONSTANT_VERTEX_SHADER (PASS_BARYCENTRIC_DECLARATIONS, PASS_BARYCENTRIC);
+}
+
+const char* Shader::smoothInstancedVertexShader () { return SMOOTH_INSTANCED_VERTEX_SHADER; }
+
+const char* Shader::flatInstancedVertexShader () { return FLAT_INSTANCED_VERTEX_SHADER; }
+
+const char* Shader::flatInstancedFragmentShader () { return FLAT_INSTANCED_FRAGMENT_SHADER; }
+
+const char* Shader::constantInstancedVertexShader () { return CONSTANT_INSTANCED_VERTEX_SHADER; }
+
 const char* Shader::geometryShader () { return GEOMETRY_SHADER; }
@@ -18,6 +18,19 @@ namespace Shader
   const char* constantVertexShader ();
   const char* constantFragmentShader ();
   const char* constantWireframeFragmentShader ();
+
+  // wireframe shaders that read barycentric coordinates from a vertex attribute
+  const char* smoothBarycentricVertexShader ();
+  const char* smoothBarycentricFragmentShader ();
+  const char* flatBarycentricVertexShader ();
+  const char* flatBarycentricFragmentShader ();
+  const char* constantBarycentricVertexShader ();
+
+  const char* smoothInstancedVertexShader ();
+  const char* flatInstancedVertexShader ();
+  const char* flatInstancedFragmentShader ();
+  const char* constantInstancedVertexShader ();
+
   const char* geometryShader ();
 };
 
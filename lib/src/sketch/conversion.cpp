@@ -2,6 +2,9 @@
  * Copyright © 2015-2017 Alexander Bau
  * Use and redistribute under the terms of the GNU General Public License
  */
+#include <algorithm>
+#include <atomic>
+#include <functional>
 #include <glm/glm.hpp>
 #include <glm/gtx/norm.hpp>
 #include <thread>
@@ -9,6 +12,7 @@
 #include "../mesh.hpp"
 #include "distance.hpp"
 #include "mesh-util.hpp"
+#include "parallel.hpp"
 #include "primitive/cone-sphere.hpp"
 #include "sketch/conversion.hpp"
 #include "sketch/mesh.hpp"
@@ -346,17 +350,61 @@ namespace
     return n + 1;
   }
 
+  bool hasAmbiguousFace (unsigned int configuration)
+  {
+    assert (configuration < 256);
+
+    for (unsigned int i = 0; i < 6; i++)
+    {
+      unsigned int numIntersectedEdges = 0;
+      for (unsigned int j = 0; j < 4; j++)
+      {
+        const unsigned int edge = edgeIndicesByFace[i][j];
+        const unsigned int vertex1 = vertexIndicesByEdge[edge][0];
+        const unsigned int vertex2 = vertexIndicesByEdge[edge][1];
+
+        if (((configuration >> vertex1) & 1) != ((configuration >> vertex2) & 1))
+        {
+          numIntersectedEdges++;
+        }
+      }
+      if (numIntersectedEdges == 4)
+      {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // the contour of a simple configuration is either empty or a single disk
+  bool isSimpleConfiguration (unsigned int configuration)
+  {
+    static const std::vector<bool> isSimple = []() {
+      std::vector<bool> result (256);
+      for (unsigned int i = 0; i < 256; i++)
+      {
+        result[i] = numVertices (i) <= 1 && hasAmbiguousFace (i) == false;
+      }
+      return result;
+    }();
+
+    assert (configuration < 256);
+    return isSimple[configuration];
+  }
+
   struct Cube
   {
     unsigned int              configuration;
     glm::vec3                 vertex;
     std::vector<unsigned int> vertexIndicesInMesh;
     bool                      nonManifold;
+    unsigned char             leafLevel; // cube is part of a merged cell of 2^leafLevel cubes
 
     Cube ()
       : configuration (Util::invalidIndex ())
       , vertex (invalidVec3)
       , nonManifold (false)
+      , leafLevel (0)
     {
     }
 
@@ -382,6 +430,13 @@ namespace
     unsigned int vertexIndex (unsigned int edge) const
     {
       assert (edge < 12);
+
+      if (this->leafLevel > 0)
+      {
+        assert (this->vertexIndicesInMesh.size () == 1);
+        return this->vertexIndicesInMesh.at (0);
+      }
+
       assert (this->configuration < 256);
       assert (vertexIndicesByConfiguration[this->configuration][edge] >= 0);
       assert (this->nonManifold == false || this->nonManifoldConfig ());
@@ -426,19 +481,75 @@ namespace
     }
   };
 
+  /* Samples are only evaluated and stored in a narrow band around the surface.  The grid of cubes
+   * is partitioned into blocks of `blockSize`^3 cubes.  A block is active if its samples may differ
+   * in sign.  Otherwise all of its samples have the sign of the distance at its center.
+   */
+  constexpr unsigned int blockSize = 8;
+  constexpr unsigned int blockSamples = blockSize + 1;
+
+  struct Block
+  {
+    unsigned int activeIndex;
+    float        distance;
+  };
+
+  /* Progress is shared between a running conversion and the thread that started it.  The
+   * conversion checks for cancellation once per block.
+   */
+  struct Progress
+  {
+    typedef SketchConversionJob::Phase Phase;
+
+    std::atomic<Phase>        phase;
+    std::atomic<unsigned int> numProcessed;
+    std::atomic<unsigned int> numBlocks;
+    std::atomic<bool>         cancelled;
+
+    Progress ()
+      : phase (Phase::Sample)
+      , numProcessed (0)
+      , numBlocks (0)
+      , cancelled (false)
+    {
+    }
+
+    void begin (Phase p, unsigned int n)
+    {
+      this->numProcessed = 0;
+      this->numBlocks = n;
+      this->phase = p;
+    }
+
+    float fraction () const
+    {
+      const unsigned int n = this->numBlocks;
+      return n == 0 ? 0.0f : glm::min (1.0f, float(this->numProcessed) / float(n));
+    }
+  };
+
   struct Parameters
   {
-    float              resolution;
-    glm::vec3          sampleOrigin;
-    glm::uvec3         numSamples;
-    std::vector<float> samples;
-    glm::uvec3         numCubes;
-    std::vector<Cube>  grid;
-
-    Parameters ()
-      : resolution (0.0f)
+    Progress*                 progress;
+    float                     resolution;
+    bool                      adaptive;
+    glm::vec3                 sampleOrigin;
+    glm::uvec3                numSamples;
+    glm::uvec3                numCubes;
+    glm::uvec3                numBlocks;
+    std::vector<Block>        blocks;
+    std::vector<unsigned int> activeBlocks;
+    std::vector<float>        samples;
+    std::vector<Cube>         grid;
+
+    Parameters (Progress& p)
+      : progress (&p)
+      , resolution (0.0f)
+      , adaptive (false)
       , sampleOrigin (glm::vec3 (0.0f))
       , numSamples (glm::uvec3 (0))
+      , numCubes (glm::uvec3 (0))
+      , numBlocks (glm::uvec3 (0))
     {
     }
 
@@ -452,63 +563,152 @@ namespace
              (glm::vec3 (this->resolution) * glm::vec3 (float(x), float(y), float(z)));
     }
 
-    glm::vec3 samplePos (unsigned int i) const
+    unsigned int blockIndex (unsigned int x, unsigned int y, unsigned int z) const
+    {
+      return (z * this->numBlocks.x * this->numBlocks.y) + (y * this->numBlocks.x) + x;
+    }
+
+    glm::uvec3 firstCubeOfActiveBlock (unsigned int activeIndex) const
     {
-      const std::div_t divZ = std::div (int(i), int(this->numSamples.x * this->numSamples.y));
-      const std::div_t divY = std::div (divZ.rem, int(this->numSamples.x));
+      const unsigned int i = this->activeBlocks.at (activeIndex);
+      const std::div_t   divZ = std::div (int(i), int(this->numBlocks.x * this->numBlocks.y));
+      const std::div_t   divY = std::div (divZ.rem, int(this->numBlocks.x));
 
-      const unsigned int x = (unsigned int) (divY.rem);
-      const unsigned int y = (unsigned int) (divY.quot);
-      const unsigned int z = (unsigned int) (divZ.quot);
+      return glm::uvec3 (divY.rem, divY.quot, divZ.quot) * blockSize;
+    }
 
-      assert (this->sampleIndex (x, y, z) == i);
+    const Block& blockOfCube (unsigned int x, unsigned int y, unsigned int z) const
+    {
+      assert (x < this->numCubes.x);
+      assert (y < this->numCubes.y);
+      assert (z < this->numCubes.z);
 
-      return this->samplePos (x, y, z);
+      return this->blocks.at (this->blockIndex (x / blockSize, y / blockSize, z / blockSize));
     }
 
-    unsigned int sampleIndex (unsigned int x, unsigned int y, unsigned int z) const
+    unsigned int sampleIndex (unsigned int activeIndex, unsigned int x, unsigned int y,
+                              unsigned int z) const
     {
-      return (z * this->numSamples.x * this->numSamples.y) + (y * this->numSamples.x) + x;
+      assert (x < blockSamples && y < blockSamples && z < blockSamples);
+
+      return (activeIndex * blockSamples * blockSamples * blockSamples) +
+             (z * blockSamples * blockSamples) + (y * blockSamples) + x;
     }
 
-    unsigned int sampleIndex (unsigned int cubeIndex, unsigned int vertex) const
+    // vertices of a cube are ordered as in the vertex layout, i.e. bit 0 of `vertex` selects x etc.
+    float sample (unsigned int x, unsigned int y, unsigned int z, unsigned int vertex) const
     {
       assert (vertex < 8);
 
-      const std::div_t   divZ = std::div (int(cubeIndex), int(this->numCubes.x * this->numCubes.y));
-      const std::div_t   divY = std::div (divZ.rem, int(this->numCubes.x));
-      const unsigned int x = (unsigned int) (divY.rem);
-      const unsigned int y = (unsigned int) (divY.quot);
-      const unsigned int z = (unsigned int) (divZ.quot);
-
-      assert (this->cubeIndex (x, y, z) == cubeIndex);
-
-      switch (vertex)
-      {
-        case 0:
-          return this->sampleIndex (x, y, z);
-        case 1:
-          return this->sampleIndex (x + 1, y, z);
-        case 2:
-          return this->sampleIndex (x, y + 1, z);
-        case 3:
-          return this->sampleIndex (x + 1, y + 1, z);
-        case 4:
-          return this->sampleIndex (x, y, z + 1);
-        case 5:
-          return this->sampleIndex (x + 1, y, z + 1);
-        case 6:
-          return this->sampleIndex (x, y + 1, z + 1);
-        case 7:
-          return this->sampleIndex (x + 1, y + 1, z + 1);
-        default:
-          DILAY_IMPOSSIBLE
+      const Block& block = this->blockOfCube (x, y, z);
+
+      if (block.activeIndex == Util::invalidIndex ())
+      {
+        return block.distance;
+      }
+      else
+      {
+        return this->samples.at (this->sampleIndex (block.activeIndex,
+                                                    (x % blockSize) + (vertex & 1),
+                                                    (y % blockSize) + ((vertex >> 1) & 1),
+                                                    (z % blockSize) + ((vertex >> 2) & 1)));
       }
     }
 
+    // returns `Util::invalidIndex ()` if the cube is not part of an active block
     unsigned int cubeIndex (unsigned int x, unsigned int y, unsigned int z) const
     {
-      return (z * this->numCubes.x * this->numCubes.y) + (y * this->numCubes.x) + x;
+      const Block& block = this->blockOfCube (x, y, z);
+
+      if (block.activeIndex == Util::invalidIndex ())
+      {
+        return Util::invalidIndex ();
+      }
+      else
+      {
+        return (block.activeIndex * blockSize * blockSize * blockSize) +
+               ((z % blockSize) * blockSize * blockSize) + ((y % blockSize) * blockSize) +
+               (x % blockSize);
+      }
+    }
+
+    // returns the index of the first cube of the (merged) cell that contains a cube
+    unsigned int leafIndex (unsigned int x, unsigned int y, unsigned int z) const
+    {
+      const unsigned int index = this->cubeIndex (x, y, z);
+
+      if (index == Util::invalidIndex () || this->grid.at (index).leafLevel == 0)
+      {
+        return index;
+      }
+      else
+      {
+        const unsigned int mask = ~((1u << this->grid.at (index).leafLevel) - 1u);
+        return this->cubeIndex (x & mask, y & mask, z & mask);
+      }
+    }
+
+#ifndef NDEBUG
+    unsigned int configuration (unsigned int x, unsigned int y, unsigned int z) const
+    {
+      const unsigned int index = this->cubeIndex (x, y, z);
+
+      if (index == Util::invalidIndex ())
+      {
+        return this->blockOfCube (x, y, z).distance < 0.0f ? 255 : 0;
+      }
+      else
+      {
+        return this->grid.at (index).configuration;
+      }
+    }
+#endif
+
+    void forEachCube (unsigned int                                                   activeIndex,
+                      const std::function<void(unsigned int, unsigned int, unsigned int)>& f) const
+    {
+      const glm::uvec3 first = this->firstCubeOfActiveBlock (activeIndex);
+      const glm::uvec3 last = glm::min (first + glm::uvec3 (blockSize), this->numCubes);
+
+      for (unsigned int z = first.z; z < last.z; z++)
+      {
+        for (unsigned int y = first.y; y < last.y; y++)
+        {
+          for (unsigned int x = first.x; x < last.x; x++)
+          {
+            f (x, y, z);
+          }
+        }
+      }
+    }
+
+    bool isCancelled () const { return this->progress->cancelled; }
+
+    // blocks are distributed among threads, remaining blocks are skipped after cancellation
+    void forEachBlockParallel (SketchConversionJob::Phase phase,
+                               const std::function<void(unsigned int)>& f) const
+    {
+      this->progress->begin (phase, this->activeBlocks.size ());
+
+      Parallel::forRange (this->activeBlocks.size (), 1,
+                          [this, &f](unsigned int begin, unsigned int end) {
+                            for (unsigned int i = begin; i < end; i++)
+                            {
+                              if (this->isCancelled () == false)
+                              {
+                                f (i);
+                                this->progress->numProcessed++;
+                              }
+                            }
+                          });
+    }
+
+    // cubes of different blocks must be independent
+    void forEachCubeParallel (
+      SketchConversionJob::Phase                                           phase,
+      const std::function<void(unsigned int, unsigned int, unsigned int)>& f) const
+    {
+      this->forEachBlockParallel (phase, [this, &f](unsigned int i) { this->forEachCube (i, f); });
     }
   };
 
@@ -524,104 +724,399 @@ namespace
     params.numSamples = glm::vec3 (1.0f) + glm::ceil ((max - min) / glm::vec3 (params.resolution));
   }
 
-  float sampleAt (const SketchMesh& mesh, const glm::vec3& pos)
+  /* Bounding volume hierarchy over the primitives of a sketch mesh.  Each node bounds the surfaces
+   * of its primitives, so the distance from a point to its box (or its largest radius, negated, if
+   * the box contains the point) bounds the distance to all of its primitives from below.
+   */
+  struct DistanceTree
   {
-    float distance = Util::maxFloat ();
+    static constexpr unsigned int maxLeafSize = 4;
+    static constexpr unsigned int maxDepth = 64;
+    static constexpr unsigned int maxPacketSize = 16;
 
-    if (mesh.tree ().hasRoot ())
+    struct Node
     {
-      mesh.tree ().root ().forEachConstNode ([&pos, &distance](const SketchNode& node) {
-        const float d =
-          node.parent ()
-            ? Distance::distance (PrimConeSphere (node.data (), node.parent ()->data ()), pos)
-            : Distance::distance (node.data (), pos);
+      glm::vec3    minimum;
+      glm::vec3    maximum;
+      float        maxRadius;
+      unsigned int first;         // first child of inner nodes, first primitive of leaves
+      unsigned int numPrimitives; // zero for inner nodes
+    };
 
-        distance = glm::min (distance, d);
-      });
+    std::vector<PrimConeSphere> coneSpheres;
+    std::vector<PrimSphere>     spheres;
+    std::vector<unsigned int>   primitives;
+    std::vector<Node>           nodes;
+
+    DistanceTree (const SketchMesh& mesh)
+    {
+      if (mesh.tree ().hasRoot ())
+      {
+        mesh.tree ().root ().forEachConstNode ([this](const SketchNode& node) {
+          if (node.parent ())
+          {
+            this->coneSpheres.emplace_back (node.data (), node.parent ()->data ());
+          }
+          else
+          {
+            this->spheres.push_back (node.data ());
+          }
+        });
+      }
+      for (const SketchPath& p : mesh.paths ())
+      {
+        this->spheres.insert (this->spheres.end (), p.spheres ().begin (), p.spheres ().end ());
+      }
+
+      const unsigned int numPrimitives = this->coneSpheres.size () + this->spheres.size ();
+
+      this->primitives.resize (numPrimitives);
+      for (unsigned int i = 0; i < numPrimitives; i++)
+      {
+        this->primitives[i] = i;
+      }
+
+      if (numPrimitives > 0)
+      {
+        this->nodes.emplace_back ();
+        this->build (0, 0, numPrimitives);
+      }
     }
-    for (const SketchPath& p : mesh.paths ())
+
+    // primitives below `coneSpheres.size ()` are cone spheres, all others are spheres
+    void primitiveDistances (unsigned int primitive, unsigned int n, const float* x,
+                             const float* y, const float* z, float* result) const
     {
-      for (const PrimSphere& s : p.spheres ())
+      if (primitive < this->coneSpheres.size ())
       {
-        distance = glm::min (distance, Distance::distance (s, pos));
+        Distance::distances (this->coneSpheres[primitive], n, x, y, z, result);
+      }
+      else
+      {
+        Distance::distances (this->spheres[primitive - this->coneSpheres.size ()], n, x, y, z,
+                             result);
       }
     }
-    return distance;
-  }
 
-  void sampleThread (const SketchMesh& mesh, Parameters& params, unsigned int numThreads,
-                     unsigned int threadId)
-  {
-    for (unsigned int z = 0; z < params.numSamples.z; z++)
+    void primitiveBounds (unsigned int primitive, glm::vec3& min, glm::vec3& max,
+                          float& radius) const
     {
-      for (unsigned int y = 0; y < params.numSamples.y; y++)
+      auto sphereBounds = [&min, &max, &radius](const PrimSphere& sphere) {
+        min = glm::min (min, sphere.center () - glm::vec3 (sphere.radius ()));
+        max = glm::max (max, sphere.center () + glm::vec3 (sphere.radius ()));
+        radius = glm::max (radius, sphere.radius ());
+      };
+
+      min = glm::vec3 (Util::maxFloat ());
+      max = glm::vec3 (Util::minFloat ());
+      radius = 0.0f;
+
+      if (primitive < this->coneSpheres.size ())
       {
-        for (unsigned int x = 0; x < params.numSamples.x; x++)
+        sphereBounds (this->coneSpheres[primitive].sphere1 ());
+        sphereBounds (this->coneSpheres[primitive].sphere2 ());
+      }
+      else
+      {
+        sphereBounds (this->spheres[primitive - this->coneSpheres.size ()]);
+      }
+    }
+
+    glm::vec3 primitiveCenter (unsigned int primitive) const
+    {
+      glm::vec3 min, max;
+      float     radius;
+
+      this->primitiveBounds (primitive, min, max, radius);
+      return (min + max) * 0.5f;
+    }
+
+    void build (unsigned int nodeIndex, unsigned int begin, unsigned int end)
+    {
+      assert (begin < end);
+
+      Node      node;
+      glm::vec3 minCenter = glm::vec3 (Util::maxFloat ());
+      glm::vec3 maxCenter = glm::vec3 (Util::minFloat ());
+
+      node.minimum = glm::vec3 (Util::maxFloat ());
+      node.maximum = glm::vec3 (Util::minFloat ());
+      node.maxRadius = 0.0f;
+
+      for (unsigned int i = begin; i < end; i++)
+      {
+        glm::vec3 min, max;
+        float     radius;
+
+        this->primitiveBounds (this->primitives[i], min, max, radius);
+
+        node.minimum = glm::min (node.minimum, min);
+        node.maximum = glm::max (node.maximum, max);
+        node.maxRadius = glm::max (node.maxRadius, radius);
+        minCenter = glm::min (minCenter, (min + max) * 0.5f);
+        maxCenter = glm::max (maxCenter, (min + max) * 0.5f);
+      }
+
+      if (end - begin <= maxLeafSize)
+      {
+        node.first = begin;
+        node.numPrimitives = end - begin;
+      }
+      else
+      {
+        const glm::vec3    extent = maxCenter - minCenter;
+        const unsigned int axis =
+          extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+        const unsigned int mid = begin + ((end - begin) / 2);
+
+        std::nth_element (this->primitives.begin () + begin, this->primitives.begin () + mid,
+                          this->primitives.begin () + end,
+                          [this, axis](unsigned int a, unsigned int b) {
+                            return this->primitiveCenter (a)[axis] <
+                                   this->primitiveCenter (b)[axis];
+                          });
+
+        node.first = this->nodes.size ();
+        node.numPrimitives = 0;
+
+        this->nodes.emplace_back ();
+        this->nodes.emplace_back ();
+        this->build (node.first, begin, mid);
+        this->build (node.first + 1, mid, end);
+      }
+      this->nodes[nodeIndex] = node;
+    }
+
+    float lowerBound (const Node& node, const glm::vec3& pos) const
+    {
+      const glm::vec3 delta =
+        glm::max (glm::vec3 (0.0f), glm::max (node.minimum - pos, pos - node.maximum));
+      const float distance = glm::length (delta);
+
+      return distance > 0.0f ? distance : -node.maxRadius;
+    }
+
+    // a small tolerance keeps culling conservative with respect to rounding errors
+    bool isCulled (const Node& node, unsigned int n, const float* x, const float* y,
+                   const float* z, const float* distances) const
+    {
+      for (unsigned int i = 0; i < n; i++)
+      {
+        if (this->lowerBound (node, glm::vec3 (x[i], y[i], z[i])) - Util::epsilon () <
+            distances[i])
         {
-          const unsigned int index = params.sampleIndex (x, y, z);
+          return false;
+        }
+      }
+      return true;
+    }
 
-          if (index % numThreads == threadId)
+    /* Computes the distances of a packet of `n` points.  A node is only culled if it is culled
+     * for all points of the packet, so packets should be spatially coherent.
+     */
+    void distances (unsigned int n, const float* x, const float* y, const float* z,
+                    float* result) const
+    {
+      assert (n > 0 && n <= maxPacketSize);
+
+      std::fill (result, result + n, Util::maxFloat ());
+
+      if (this->nodes.empty ())
+      {
+        return;
+      }
+
+      const glm::vec3 center (x[n / 2], y[n / 2], z[n / 2]);
+      unsigned int    stack[maxDepth];
+      unsigned int    stackSize = 0;
+      float           primitiveResult[maxPacketSize];
+
+      stack[stackSize++] = 0;
+
+      while (stackSize > 0)
+      {
+        const Node& node = this->nodes[stack[--stackSize]];
+
+        if (this->isCulled (node, n, x, y, z, result))
+        {
+          continue;
+        }
+        else if (node.numPrimitives > 0)
+        {
+          for (unsigned int i = node.first; i < node.first + node.numPrimitives; i++)
           {
-            const glm::vec3 pos = params.samplePos (x, y, z);
+            this->primitiveDistances (this->primitives[i], n, x, y, z, primitiveResult);
 
-            assert (params.samples.at (index) == Util::maxFloat ());
-            params.samples.at (index) = sampleAt (mesh, pos);
+            for (unsigned int j = 0; j < n; j++)
+            {
+              result[j] = glm::min (result[j], primitiveResult[j]);
+            }
+          }
+        }
+        else
+        {
+          assert (stackSize + 2 <= maxDepth);
 
-            assert (Util::isNaN (params.samples.at (index)) == false);
-            assert (params.samples.at (index) != Util::maxFloat ());
-            assert ((x > 0 && x < params.numSamples.x - 1) || params.samples.at (index) > 0.0f);
-            assert ((y > 0 && y < params.numSamples.y - 1) || params.samples.at (index) > 0.0f);
-            assert ((z > 0 && z < params.numSamples.z - 1) || params.samples.at (index) > 0.0f);
+          // the child nearer to the center of the packet is visited first
+          if (this->lowerBound (this->nodes[node.first], center) <=
+              this->lowerBound (this->nodes[node.first + 1], center))
+          {
+            stack[stackSize++] = node.first + 1;
+            stack[stackSize++] = node.first;
+          }
+          else
+          {
+            stack[stackSize++] = node.first;
+            stack[stackSize++] = node.first + 1;
           }
         }
       }
     }
-  }
 
-  void sample (const SketchMesh& mesh, Parameters& params)
+    float distance (const glm::vec3& pos) const
+    {
+      float result;
+      this->distances (1, &pos.x, &pos.y, &pos.z, &result);
+      return result;
+    }
+  };
+
+  /* Finds active blocks in [min, max) by coarse-to-fine refinement.  The distance field is
+   * 1-Lipschitz, so a range of blocks does not contain the surface if the absolute distance at
+   * its center exceeds its circumradius.
+   */
+  void activateBlocks (const DistanceTree& tree, Parameters& params, const glm::uvec3& min,
+                       const glm::uvec3& max)
   {
-    const unsigned int numSamples = params.numSamples.x * params.numSamples.y * params.numSamples.z;
-    params.samples.resize (numSamples, Util::maxFloat ());
+    assert (glm::all (glm::lessThan (min, max)));
 
-    const unsigned int       numThreads = std::thread::hardware_concurrency ();
-    std::vector<std::thread> threads;
+    const glm::vec3 firstCube = glm::vec3 (min * blockSize);
+    const glm::vec3 lastCube = glm::vec3 (glm::min (max * blockSize, params.numCubes));
+    const glm::vec3 center =
+      params.sampleOrigin + (0.5f * params.resolution * (firstCube + lastCube));
+    const float     radius = 0.5f * params.resolution * glm::length (lastCube - firstCube);
+    const float     distance = tree.distance (center);
 
-    for (unsigned int i = 0; i < numThreads; i++)
+    if (glm::abs (distance) > radius + Util::epsilon ())
     {
-      threads.emplace_back (sampleThread, std::ref (mesh), std::ref (params), numThreads, i);
+      for (unsigned int z = min.z; z < max.z; z++)
+      {
+        for (unsigned int y = min.y; y < max.y; y++)
+        {
+          for (unsigned int x = min.x; x < max.x; x++)
+          {
+            params.blocks.at (params.blockIndex (x, y, z)).distance = distance;
+          }
+        }
+      }
+    }
+    else if (max - min == glm::uvec3 (1))
+    {
+      const unsigned int index = params.blockIndex (min.x, min.y, min.z);
+
+      params.blocks.at (index).activeIndex = params.activeBlocks.size ();
+      params.activeBlocks.push_back (index);
     }
-    for (unsigned int i = 0; i < numThreads; i++)
+    else
     {
-      threads.at (i).join ();
+      const glm::uvec3 mid = min + glm::max (glm::uvec3 (1), (max - min) / glm::uvec3 (2));
+
+      for (unsigned int i = 0; i < 8; i++)
+      {
+        const glm::uvec3 childMin ((i & 1) ? mid.x : min.x, (i & 2) ? mid.y : min.y,
+                                   (i & 4) ? mid.z : min.z);
+        const glm::uvec3 childMax ((i & 1) ? max.x : mid.x, (i & 2) ? max.y : mid.y,
+                                   (i & 4) ? max.z : mid.z);
+
+        if (glm::all (glm::lessThan (childMin, childMax)))
+        {
+          activateBlocks (tree, params, childMin, childMax);
+        }
+      }
     }
   }
 
+  // samples are evaluated in packets of rows along the x-axis
+  void sampleBlock (const DistanceTree& tree, Parameters& params, unsigned int activeIndex)
+  {
+    static_assert (blockSamples <= DistanceTree::maxPacketSize, "rows exceed packet size");
+
+    const glm::uvec3 first = params.firstCubeOfActiveBlock (activeIndex);
+    const glm::uvec3 last = glm::min (first + glm::uvec3 (blockSamples), params.numSamples);
+
+    float xs[blockSamples], ys[blockSamples], zs[blockSamples], distances[blockSamples];
+
+    for (unsigned int z = first.z; z < last.z; z++)
+    {
+      for (unsigned int y = first.y; y < last.y; y++)
+      {
+        for (unsigned int x = first.x; x < last.x; x++)
+        {
+          const glm::vec3 pos = params.samplePos (x, y, z);
+
+          xs[x - first.x] = pos.x;
+          ys[x - first.x] = pos.y;
+          zs[x - first.x] = pos.z;
+        }
+        tree.distances (last.x - first.x, xs, ys, zs, distances);
+
+        for (unsigned int x = first.x; x < last.x; x++)
+        {
+          const unsigned int index =
+            params.sampleIndex (activeIndex, x - first.x, y - first.y, z - first.z);
+
+          assert (params.samples.at (index) == Util::maxFloat ());
+          params.samples.at (index) = distances[x - first.x];
+
+          assert (Util::isNaN (params.samples.at (index)) == false);
+          assert (params.samples.at (index) != Util::maxFloat ());
+          assert ((x > 0 && x < params.numSamples.x - 1) || params.samples.at (index) > 0.0f);
+          assert ((y > 0 && y < params.numSamples.y - 1) || params.samples.at (index) > 0.0f);
+          assert ((z > 0 && z < params.numSamples.z - 1) || params.samples.at (index) > 0.0f);
+        }
+      }
+    }
+  }
+
+  void sample (const DistanceTree& tree, Parameters& params)
+  {
+    params.numCubes = params.numSamples - glm::uvec3 (1);
+    params.numBlocks = (params.numCubes + glm::uvec3 (blockSize - 1)) / glm::uvec3 (blockSize);
+    params.blocks.resize (params.numBlocks.x * params.numBlocks.y * params.numBlocks.z,
+                          Block{Util::invalidIndex (), Util::maxFloat ()});
+
+    activateBlocks (tree, params, glm::uvec3 (0), params.numBlocks);
+
+    params.samples.resize (
+      params.activeBlocks.size () * blockSamples * blockSamples * blockSamples, Util::maxFloat ());
+
+    params.forEachBlockParallel (SketchConversionJob::Phase::Sample,
+                                 [&tree, &params](unsigned int i) {
+                                   sampleBlock (tree, params, i);
+                                 });
+  }
+
   bool isIntersecting (float s1, float s2)
   {
     return (s1 < 0.0f && s2 >= 0.0f) || (s1 >= 0.0f && s2 < 0.0f);
   }
 
-  void setCubeVertex (Parameters& params, unsigned int cubeIndex)
+  void setCubeVertex (Parameters& params, unsigned int x, unsigned int y, unsigned int z)
   {
     glm::vec3    vertex = glm::vec3 (0.0f);
     unsigned int numCrossedEdges = 0;
-    Cube&        cube = params.grid.at (cubeIndex);
-
-    const unsigned int indices[] = {
-      params.sampleIndex (cubeIndex, 0), params.sampleIndex (cubeIndex, 1),
-      params.sampleIndex (cubeIndex, 2), params.sampleIndex (cubeIndex, 3),
-      params.sampleIndex (cubeIndex, 4), params.sampleIndex (cubeIndex, 5),
-      params.sampleIndex (cubeIndex, 6), params.sampleIndex (cubeIndex, 7)};
+    Cube&        cube = params.grid.at (params.cubeIndex (x, y, z));
 
-    const float samples[] = {params.samples.at (indices[0]), params.samples.at (indices[1]),
-                             params.samples.at (indices[2]), params.samples.at (indices[3]),
-                             params.samples.at (indices[4]), params.samples.at (indices[5]),
-                             params.samples.at (indices[6]), params.samples.at (indices[7])};
+    const float samples[] = {params.sample (x, y, z, 0), params.sample (x, y, z, 1),
+                             params.sample (x, y, z, 2), params.sample (x, y, z, 3),
+                             params.sample (x, y, z, 4), params.sample (x, y, z, 5),
+                             params.sample (x, y, z, 6), params.sample (x, y, z, 7)};
 
-    const glm::vec3 positions[] = {params.samplePos (indices[0]), params.samplePos (indices[1]),
-                                   params.samplePos (indices[2]), params.samplePos (indices[3]),
-                                   params.samplePos (indices[4]), params.samplePos (indices[5]),
-                                   params.samplePos (indices[6]), params.samplePos (indices[7])};
+    const glm::vec3 positions[] = {
+      params.samplePos (x, y, z),         params.samplePos (x + 1, y, z),
+      params.samplePos (x, y + 1, z),     params.samplePos (x + 1, y + 1, z),
+      params.samplePos (x, y, z + 1),     params.samplePos (x + 1, y, z + 1),
+      params.samplePos (x, y + 1, z + 1), params.samplePos (x + 1, y + 1, z + 1)};
 
     auto checkEdge = [&numCrossedEdges, &vertex, &samples, &positions](unsigned short vertex1,
                                                                        unsigned short vertex2) {
@@ -696,58 +1191,52 @@ namespace
 
   void makeGrid (Parameters& params)
   {
-    params.numCubes = params.numSamples - glm::uvec3 (1);
-    params.grid.resize (params.numCubes.x * params.numCubes.y * params.numCubes.z);
+    params.grid.resize (params.activeBlocks.size () * blockSize * blockSize * blockSize);
+
+    params.forEachCubeParallel (SketchConversionJob::Phase::Grid,
+                                [&params](unsigned int x, unsigned int y, unsigned int z) {
+                                  setCubeVertex (params, x, y, z);
+                                });
 
-    for (unsigned int z = 0; z < params.numCubes.z; z++)
+    if (params.isCancelled ())
     {
-      for (unsigned int y = 0; y < params.numCubes.y; y++)
-      {
-        for (unsigned int x = 0; x < params.numCubes.x; x++)
-        {
-          setCubeVertex (params, params.cubeIndex (x, y, z));
-        }
-      }
+      return;
     }
 
 #ifndef NDEBUG
-    for (unsigned int z = 0; z < params.numCubes.z; z++)
+    for (unsigned int i = 0; i < params.activeBlocks.size (); i++)
     {
-      for (unsigned int y = 0; y < params.numCubes.y; y++)
-      {
-        for (unsigned int x = 0; x < params.numCubes.x; x++)
-        {
-          unsigned int config = params.grid.at (params.cubeIndex (x, y, z)).configuration;
+      params.forEachCube (i, [&params](unsigned int x, unsigned int y, unsigned int z) {
+        unsigned int config = params.configuration (x, y, z);
 
-          if (x > 0)
-          {
-            unsigned int left = params.grid.at (params.cubeIndex (x - 1, y, z)).configuration;
+        if (x > 0)
+        {
+          unsigned int left = params.configuration (x - 1, y, z);
 
-            assert (((config & (1 << 0)) == 0) == ((left & (1 << 1)) == 0));
-            assert (((config & (1 << 2)) == 0) == ((left & (1 << 3)) == 0));
-            assert (((config & (1 << 4)) == 0) == ((left & (1 << 5)) == 0));
-            assert (((config & (1 << 6)) == 0) == ((left & (1 << 7)) == 0));
-          }
-          if (y > 0)
-          {
-            unsigned int below = params.grid.at (params.cubeIndex (x, y - 1, z)).configuration;
+          assert (((config & (1 << 0)) == 0) == ((left & (1 << 1)) == 0));
+          assert (((config & (1 << 2)) == 0) == ((left & (1 << 3)) == 0));
+          assert (((config & (1 << 4)) == 0) == ((left & (1 << 5)) == 0));
+          assert (((config & (1 << 6)) == 0) == ((left & (1 << 7)) == 0));
+        }
+        if (y > 0)
+        {
+          unsigned int below = params.configuration (x, y - 1, z);
 
-            assert (((config & (1 << 0)) == 0) == ((below & (1 << 2)) == 0));
-            assert (((config & (1 << 1)) == 0) == ((below & (1 << 3)) == 0));
-            assert (((config & (1 << 4)) == 0) == ((below & (1 << 6)) == 0));
-            assert (((config & (1 << 5)) == 0) == ((below & (1 << 7)) == 0));
-          }
-          if (z > 0)
-          {
-            unsigned int behind = params.grid.at (params.cubeIndex (x, y, z - 1)).configuration;
+          assert (((config & (1 << 0)) == 0) == ((below & (1 << 2)) == 0));
+          assert (((config & (1 << 1)) == 0) == ((below & (1 << 3)) == 0));
+          assert (((config & (1 << 4)) == 0) == ((below & (1 << 6)) == 0));
+          assert (((config & (1 << 5)) == 0) == ((below & (1 << 7)) == 0));
+        }
+        if (z > 0)
+        {
+          unsigned int behind = params.configuration (x, y, z - 1);
 
-            assert (((config & (1 << 0)) == 0) == ((behind & (1 << 4)) == 0));
-            assert (((config & (1 << 1)) == 0) == ((behind & (1 << 5)) == 0));
-            assert (((config & (1 << 2)) == 0) == ((behind & (1 << 6)) == 0));
-            assert (((config & (1 << 3)) == 0) == ((behind & (1 << 7)) == 0));
-          }
+          assert (((config & (1 << 0)) == 0) == ((behind & (1 << 4)) == 0));
+          assert (((config & (1 << 1)) == 0) == ((behind & (1 << 5)) == 0));
+          assert (((config & (1 << 2)) == 0) == ((behind & (1 << 6)) == 0));
+          assert (((config & (1 << 3)) == 0) == ((behind & (1 << 7)) == 0));
         }
-      }
+      });
     }
 #endif
   }
@@ -760,9 +1249,18 @@ namespace
       assert (dim == -3 || dim == -2 || dim == -1 || dim == 1 || dim == 2 || dim == 3);
       unused (cube);
 
-      Cube& other = params.grid.at (params.cubeIndex (dim == -1 ? x - 1 : (dim == 1 ? x + 1 : x),
-                                                      dim == -2 ? y - 1 : (dim == 2 ? y + 1 : y),
-                                                      dim == -3 ? z - 1 : (dim == 3 ? z + 1 : z)));
+      const unsigned int otherIndex =
+        params.cubeIndex (dim == -1 ? x - 1 : (dim == 1 ? x + 1 : x),
+                          dim == -2 ? y - 1 : (dim == 2 ? y + 1 : y),
+                          dim == -3 ? z - 1 : (dim == 3 ? z + 1 : z));
+
+      if (otherIndex == Util::invalidIndex ())
+      {
+        return false;
+      }
+
+      const Cube& other = params.grid.at (otherIndex);
+
       if (other.nonManifoldConfig ())
       {
         const unsigned int otherAmbiguousFace = other.getAmbiguousFaceOfNonManifoldConfig ();
@@ -782,34 +1280,511 @@ namespace
       }
     };
 
-    for (unsigned int z = 0; z < params.numCubes.z; z++)
+    // cubes only read the configurations of their neighbors, so blocks are independent
+    auto resolve = [&params, &check](unsigned int x, unsigned int y, unsigned int z) {
+      Cube& cube = params.grid.at (params.cubeIndex (x, y, z));
+
+      if (cube.nonManifoldConfig ())
+      {
+        const unsigned int ambiguousFace = cube.getAmbiguousFaceOfNonManifoldConfig ();
+
+        const bool nx = x > 0 && check (cube, x, y, z, ambiguousFace, -1);
+        const bool px = x < params.numCubes.x - 1 && check (cube, x, y, z, ambiguousFace, 1);
+        const bool ny = y > 0 && check (cube, x, y, z, ambiguousFace, -2);
+        const bool py = y < params.numCubes.y - 1 && check (cube, x, y, z, ambiguousFace, 2);
+        const bool nz = z > 0 && check (cube, x, y, z, ambiguousFace, -3);
+        const bool pz = z < params.numCubes.z - 1 && check (cube, x, y, z, ambiguousFace, 3);
+
+        cube.nonManifold = nx || px || ny || py || nz || pz;
+      }
+      else
+      {
+        cube.nonManifold = false;
+      }
+    };
+    params.forEachCubeParallel (SketchConversionJob::Phase::NonManifolds, resolve);
+  }
+
+  // eigen decomposition of a symmetric matrix by cyclic Jacobi rotations
+  void symmetricEigen (const glm::mat3& matrix, glm::vec3& values, glm::mat3& vectors)
+  {
+    const unsigned int numSweeps = 8;
+    const unsigned int pairs[3][2] = {{0, 1}, {0, 2}, {1, 2}};
+
+    glm::mat3 a = matrix;
+    vectors = glm::mat3 (1.0f);
+
+    for (unsigned int sweep = 0; sweep < numSweeps; sweep++)
+    {
+      for (unsigned int i = 0; i < 3; i++)
+      {
+        const unsigned int p = pairs[i][0];
+        const unsigned int q = pairs[i][1];
+
+        if (glm::abs (a[q][p]) > Util::epsilon () * Util::epsilon ())
+        {
+          const float theta = (a[q][q] - a[p][p]) / (2.0f * a[q][p]);
+          const float t = (theta >= 0.0f ? 1.0f : -1.0f) /
+                          (glm::abs (theta) + glm::sqrt ((theta * theta) + 1.0f));
+          const float c = 1.0f / glm::sqrt ((t * t) + 1.0f);
+
+          glm::mat3 rotation (1.0f);
+          rotation[p][p] = c;
+          rotation[q][q] = c;
+          rotation[q][p] = t * c;
+          rotation[p][q] = -t * c;
+
+          a = glm::transpose (rotation) * a * rotation;
+          vectors = vectors * rotation;
+        }
+      }
+    }
+    values = glm::vec3 (a[0][0], a[1][1], a[2][2]);
+  }
+
+  /* Quadratic error function of the tangent planes at the intersections of a cell.  The minimizer
+   * is computed relative to the mass point of the intersections.  Small eigenvalues are truncated,
+   * so the vertex of a flat or cylindrical region stays close to the mass point.
+   */
+  struct Qef
+  {
+    glm::mat3    ata;
+    glm::vec3    atb;
+    glm::vec3    massPoint;
+    unsigned int numPlanes;
+
+    Qef ()
+      : ata (0.0f)
+      , atb (0.0f)
+      , massPoint (0.0f)
+      , numPlanes (0)
+    {
+    }
+
+    void add (const glm::vec3& point, const glm::vec3& normal)
+    {
+      this->ata += glm::outerProduct (normal, normal);
+      this->atb += normal * glm::dot (normal, point);
+      this->massPoint += point;
+      this->numPlanes++;
+    }
+
+    glm::vec3 minimizer () const
+    {
+      assert (this->numPlanes > 0);
+
+      const float     truncation = 0.1f;
+      const glm::vec3 center = this->massPoint / float(this->numPlanes);
+      const glm::vec3 rhs = this->atb - (this->ata * center);
+
+      glm::vec3 values;
+      glm::mat3 vectors;
+      symmetricEigen (this->ata, values, vectors);
+
+      const float maxValue = glm::max (glm::abs (values.x), glm::max (glm::abs (values.y),
+                                                                      glm::abs (values.z)));
+      glm::vec3   offset (0.0f);
+      for (unsigned int i = 0; i < 3; i++)
+      {
+        if (glm::abs (values[i]) > truncation * maxValue)
+        {
+          offset += vectors[i] * (glm::dot (vectors[i], rhs) / values[i]);
+        }
+      }
+      return center + offset;
+    }
+  };
+
+  struct Hermite
+  {
+    bool      isIntersection;
+    glm::vec3 point;
+    glm::vec3 normal;
+  };
+
+  /* Merges the cubes of an active block bottom-up into cells of 2^k cubes (k <= log2 (blockSize))
+   * with a single vertex at the minimizer of their QEF.  A cell is merged if
+   *
+   * - each of its children has been merged at the previous level,
+   * - the contour within the cell is topologically equivalent to the contour implied by the
+   *   signs of its corners, which must be a simple configuration,
+   * - and the minimizer of its QEF lies within the cell and approximates all tangent planes.
+   *
+   * Topological equivalence is tested on each edge, each face, and the interior of a cell: the
+   * samples of each sign must form a single (6-connected) component if a corner has this sign,
+   * and none otherwise.
+   */
+  struct BlockSimplification
+  {
+    static constexpr unsigned int numCubes3 = blockSize * blockSize * blockSize;
+    static constexpr unsigned int numSamples3 = blockSamples * blockSamples * blockSamples;
+
+    const DistanceTree&        tree;
+    Parameters&                params;
+    const float                maxError;
+    const unsigned int         activeIndex;
+    const glm::uvec3           first;
+    const glm::uvec3           numCubes;
+    std::vector<Hermite>       edges;
+    std::vector<unsigned char> levels;
+    std::vector<glm::vec3>     vertices;
+    std::vector<unsigned char> visited;
+    std::vector<glm::uvec3>    stack;
+
+    BlockSimplification (const DistanceTree& t, Parameters& p, float e, unsigned int a)
+      : tree (t)
+      , params (p)
+      , maxError (e)
+      , activeIndex (a)
+      , first (p.firstCubeOfActiveBlock (a))
+      , numCubes (glm::min (this->first + glm::uvec3 (blockSize), p.numCubes) - this->first)
+      , edges (3 * numSamples3, Hermite{false, glm::vec3 (0.0f), glm::vec3 (0.0f)})
+      , levels (numCubes3, 0)
+      , vertices (numCubes3, invalidVec3)
+      , visited (numSamples3, 0)
+    {
+    }
+
+    float sample (const glm::uvec3& l) const
+    {
+      return this->params.samples.at (this->params.sampleIndex (this->activeIndex, l.x, l.y, l.z));
+    }
+
+    bool isNegative (const glm::uvec3& l) const { return this->sample (l) < 0.0f; }
+
+    glm::vec3 samplePos (const glm::uvec3& l) const
+    {
+      const glm::uvec3 g = this->first + l;
+      return this->params.samplePos (g.x, g.y, g.z);
+    }
+
+    Cube& cube (const glm::uvec3& l)
+    {
+      const glm::uvec3 g = this->first + l;
+      return this->params.grid.at (this->params.cubeIndex (g.x, g.y, g.z));
+    }
+
+    unsigned int cubeIndex (const glm::uvec3& l) const
+    {
+      return (l.z * blockSize * blockSize) + (l.y * blockSize) + l.x;
+    }
+
+    unsigned int sampleIndex (const glm::uvec3& l) const
+    {
+      return (l.z * blockSamples * blockSamples) + (l.y * blockSamples) + l.x;
+    }
+
+    Hermite& edge (unsigned int dim, const glm::uvec3& l)
+    {
+      return this->edges.at ((dim * numSamples3) + this->sampleIndex (l));
+    }
+
+    static glm::uvec3 corner (const glm::uvec3& min, const glm::uvec3& max, unsigned int i)
+    {
+      return glm::uvec3 ((i & 1) ? max.x : min.x, (i & 2) ? max.y : min.y,
+                         (i & 4) ? max.z : min.z);
+    }
+
+    template <typename F> static void forEach (const glm::uvec3& min, const glm::uvec3& max, F f)
     {
-      for (unsigned int y = 0; y < params.numCubes.y; y++)
+      for (unsigned int z = min.z; z <= max.z; z++)
       {
-        for (unsigned int x = 0; x < params.numCubes.x; x++)
+        for (unsigned int y = min.y; y <= max.y; y++)
         {
-          Cube& cube = params.grid.at (params.cubeIndex (x, y, z));
+          for (unsigned int x = min.x; x <= max.x; x++)
+          {
+            f (glm::uvec3 (x, y, z));
+          }
+        }
+      }
+    }
+
+    glm::vec3 normal (const glm::vec3& p, const glm::vec3& fallback) const
+    {
+      const float h = 0.25f * this->params.resolution;
+      const float xs[] = {p.x + h, p.x - h, p.x, p.x, p.x, p.x};
+      const float ys[] = {p.y, p.y, p.y + h, p.y - h, p.y, p.y};
+      const float zs[] = {p.z, p.z, p.z, p.z, p.z + h, p.z - h};
+      float       d[6];
+
+      this->tree.distances (6, xs, ys, zs, d);
+
+      const glm::vec3 gradient (d[0] - d[1], d[2] - d[3], d[4] - d[5]);
+      const float     length = glm::length (gradient);
+
+      return length > Util::epsilon () ? gradient / length : fallback;
+    }
+
+    void computeEdges ()
+    {
+      for (unsigned int dim = 0; dim < 3; dim++)
+      {
+        glm::uvec3 max = this->numCubes;
+        glm::uvec3 step (0);
+        max[dim]--;
+        step[dim] = 1;
+
+        forEach (glm::uvec3 (0), max, [this, dim, &step](const glm::uvec3& l) {
+          const float s1 = this->sample (l);
+          const float s2 = this->sample (l + step);
 
-          if (cube.nonManifoldConfig ())
+          if (isIntersecting (s1, s2))
           {
-            const unsigned int ambiguousFace = cube.getAmbiguousFaceOfNonManifoldConfig ();
+            const glm::vec3 p1 = this->samplePos (l);
+            const glm::vec3 p2 = this->samplePos (l + step);
+            Hermite&        hermite = this->edge (dim, l);
+
+            hermite.isIntersection = true;
+            hermite.point = p1 + ((p2 - p1) * (s1 / (s1 - s2)));
+            hermite.normal =
+              this->normal (hermite.point, glm::vec3 (step) * (s2 > s1 ? 1.0f : -1.0f));
+          }
+        });
+      }
+    }
+
+    unsigned int numComponents (const glm::uvec3& min, const glm::uvec3& max, bool negative)
+    {
+      unsigned int n = 0;
 
-            const bool nx = x > 0 && check (cube, x, y, z, ambiguousFace, -1);
-            const bool px = x < params.numCubes.x - 1 && check (cube, x, y, z, ambiguousFace, 1);
-            const bool ny = y > 0 && check (cube, x, y, z, ambiguousFace, -2);
-            const bool py = y < params.numCubes.y - 1 && check (cube, x, y, z, ambiguousFace, 2);
-            const bool nz = z > 0 && check (cube, x, y, z, ambiguousFace, -3);
-            const bool pz = z < params.numCubes.z - 1 && check (cube, x, y, z, ambiguousFace, 3);
+      forEach (min, max, [this, negative](const glm::uvec3& l) {
+        this->visited[this->sampleIndex (l)] = this->isNegative (l) != negative ? 1 : 0;
+      });
+      forEach (min, max, [this, &min, &max, &n](const glm::uvec3& l) {
+        if (this->visited[this->sampleIndex (l)] == 0)
+        {
+          n++;
+          this->visited[this->sampleIndex (l)] = 1;
+          this->stack.push_back (l);
 
-            cube.nonManifold = nx || px || ny || py || nz || pz;
+          while (this->stack.empty () == false)
+          {
+            const glm::uvec3 c = this->stack.back ();
+            this->stack.pop_back ();
+
+            for (unsigned int dim = 0; dim < 3; dim++)
+            {
+              glm::uvec3 next = c;
+              for (int d : {-1, 1})
+              {
+                next[dim] = c[dim] + d;
+                if (next[dim] >= min[dim] && next[dim] <= max[dim] &&
+                    this->visited[this->sampleIndex (next)] == 0)
+                {
+                  this->visited[this->sampleIndex (next)] = 1;
+                  this->stack.push_back (next);
+                }
+              }
+            }
           }
-          else
+        }
+      });
+      return n;
+    }
+
+    bool isConsistent (const glm::uvec3& min, const glm::uvec3& max)
+    {
+      bool hasNegativeCorner = false;
+      bool hasPositiveCorner = false;
+
+      for (unsigned int i = 0; i < 8; i++)
+      {
+        if (this->isNegative (corner (min, max, i)))
+        {
+          hasNegativeCorner = true;
+        }
+        else
+        {
+          hasPositiveCorner = true;
+        }
+      }
+      return this->numComponents (min, max, true) == (hasNegativeCorner ? 1 : 0) &&
+             this->numComponents (min, max, false) == (hasPositiveCorner ? 1 : 0);
+    }
+
+    // the samples of an edge are consistent if their sign changes at most once
+    bool isConsistentEdge (const glm::uvec3& min, const glm::uvec3& max)
+    {
+      unsigned int numSignChanges = 0;
+      bool         negative = this->isNegative (min);
+
+      forEach (min, max, [this, &numSignChanges, &negative](const glm::uvec3& l) {
+        if (this->isNegative (l) != negative)
+        {
+          negative = !negative;
+          numSignChanges++;
+        }
+      });
+      return numSignChanges <= 1;
+    }
+
+    bool isTopologicallySafe (const glm::uvec3& min, const glm::uvec3& max)
+    {
+      for (unsigned int edge = 0; edge < 12; edge++)
+      {
+        if (this->isConsistentEdge (corner (min, max, vertexIndicesByEdge[edge][0]),
+                                    corner (min, max, vertexIndicesByEdge[edge][1])) == false)
+        {
+          return false;
+        }
+      }
+
+      for (unsigned int dim = 0; dim < 3; dim++)
+      {
+        for (unsigned int side : {min[dim], max[dim]})
+        {
+          glm::uvec3 faceMin = min;
+          glm::uvec3 faceMax = max;
+          faceMin[dim] = side;
+          faceMax[dim] = side;
+
+          if (this->isConsistent (faceMin, faceMax) == false)
           {
-            cube.nonManifold = false;
+            return false;
           }
         }
       }
+      return this->isConsistent (min, max);
+    }
+
+    template <typename F>
+    void forEachIntersection (const glm::uvec3& min, const glm::uvec3& max, F f)
+    {
+      for (unsigned int dim = 0; dim < 3; dim++)
+      {
+        glm::uvec3 edgeMax = max;
+        edgeMax[dim]--;
+
+        forEach (min, edgeMax, [this, dim, &f](const glm::uvec3& l) {
+          const Hermite& hermite = this->edge (dim, l);
+          if (hermite.isIntersection)
+          {
+            f (hermite);
+          }
+        });
+      }
+    }
+
+    // tries to merge the cell of 2^level cubes starting at `min`
+    void merge (const glm::uvec3& min, unsigned int level)
+    {
+      const glm::uvec3 max = min + glm::uvec3 (1u << level);
+      bool             childrenMerged = true;
+
+      forEach (min, max - glm::uvec3 (1), [this, level, &childrenMerged](const glm::uvec3& l) {
+        childrenMerged = childrenMerged && this->levels[this->cubeIndex (l)] == level - 1 &&
+                         isSimpleConfiguration (this->cube (l).configuration);
+      });
+
+      if (childrenMerged == false)
+      {
+        return;
+      }
+
+      Qef qef;
+      this->forEachIntersection (
+        min, max, [&qef](const Hermite& hermite) { qef.add (hermite.point, hermite.normal); });
+
+      // cells without intersections are merged without a vertex
+      glm::vec3 vertex = invalidVec3;
+      if (qef.numPlanes > 0)
+      {
+        unsigned int configuration = 0;
+        for (unsigned int i = 0; i < 8; i++)
+        {
+          if (this->isNegative (corner (min, max, i)))
+          {
+            configuration |= 1 << i;
+          }
+        }
+
+        if (isSimpleConfiguration (configuration) == false)
+        {
+          return;
+        }
+
+        const glm::vec3 cellMin = this->samplePos (min) - glm::vec3 (Util::epsilon ());
+        const glm::vec3 cellMax = this->samplePos (max) + glm::vec3 (Util::epsilon ());
+
+        vertex = qef.minimizer ();
+
+        if (glm::any (glm::lessThan (vertex, cellMin)) ||
+            glm::any (glm::greaterThan (vertex, cellMax)))
+        {
+          return;
+        }
+
+        bool isApproximated = true;
+        this->forEachIntersection (min, max, [this, &vertex, &isApproximated](const Hermite& h) {
+          isApproximated = isApproximated &&
+                           glm::abs (glm::dot (h.normal, vertex - h.point)) <= this->maxError;
+        });
+
+        if (isApproximated == false || this->isTopologicallySafe (min, max) == false)
+        {
+          return;
+        }
+      }
+
+      forEach (min, max - glm::uvec3 (1),
+               [this, level](const glm::uvec3& l) { this->levels[this->cubeIndex (l)] = level; });
+      this->vertices[this->cubeIndex (min)] = vertex;
+    }
+
+    void run ()
+    {
+      this->computeEdges ();
+
+      for (unsigned int level = 1; (1u << level) <= blockSize; level++)
+      {
+        const unsigned int size = 1u << level;
+
+        for (unsigned int z = 0; z + size <= this->numCubes.z; z += size)
+        {
+          for (unsigned int y = 0; y + size <= this->numCubes.y; y += size)
+          {
+            for (unsigned int x = 0; x + size <= this->numCubes.x; x += size)
+            {
+              this->merge (glm::uvec3 (x, y, z), level);
+            }
+          }
+        }
+      }
+
+      forEach (glm::uvec3 (0), this->numCubes - glm::uvec3 (1), [this](const glm::uvec3& l) {
+        const unsigned int level = this->levels[this->cubeIndex (l)];
+
+        if (level > 0)
+        {
+          const unsigned int mask = ~((1u << level) - 1u);
+          const glm::uvec3   anchor (l.x & mask, l.y & mask, l.z & mask);
+          const glm::vec3    vertex = this->vertices[this->cubeIndex (anchor)];
+          Cube&              cube = this->cube (l);
+
+          cube.leafLevel = level;
+
+          if (l == anchor && vertex != invalidVec3)
+          {
+            cube.vertex = vertex;
+            cube.vertexIndicesInMesh.assign (1, Util::invalidIndex ());
+          }
+          else
+          {
+            cube.vertexIndicesInMesh.clear ();
+          }
+        }
+      });
     }
+  };
+
+  void simplify (const DistanceTree& tree, Parameters& params)
+  {
+    const float maxError = 0.1f * params.resolution;
+
+    params.forEachBlockParallel (SketchConversionJob::Phase::Simplify,
+                                 [&tree, &params, maxError](unsigned int i) {
+                                   BlockSimplification (tree, params, maxError, i).run ();
+                                 });
   }
 
   Mesh makeMesh (Parameters& params)
@@ -830,8 +1805,9 @@ namespace
       }
     }
 
-    auto makeQuad = [&params, &mesh](unsigned int edge, bool swap, unsigned int i, unsigned int iu,
-                                     unsigned int iv, unsigned int iuv) {
+    auto makeQuad = [&params, &mesh](std::vector<unsigned int>& indices, unsigned int edge,
+                                     bool swap, unsigned int i, unsigned int iu, unsigned int iv,
+                                     unsigned int iuv) {
       unsigned int v1, v2, v3, v4;
 
       if (edge == 0)
@@ -865,111 +1841,203 @@ namespace
         std::swap (v2, v4);
       }
 
-      if (glm::distance2 (mesh.vertex (v1), mesh.vertex (v3)) <=
-          glm::distance2 (mesh.vertex (v2), mesh.vertex (v4)))
+      // cubes of a merged cell share their vertex, so quads may degenerate to triangles
+      if (v1 == v2 || v2 == v3 || v3 == v4 || v4 == v1)
       {
-        mesh.addIndex (v1);
-        mesh.addIndex (v2);
-        mesh.addIndex (v3);
-        mesh.addIndex (v1);
-        mesh.addIndex (v3);
-        mesh.addIndex (v4);
+        const unsigned int quad[] = {v1, v2, v3, v4};
+        unsigned int       triangle[4];
+        unsigned int       n = 0;
+
+        for (unsigned int j = 0; j < 4; j++)
+        {
+          if (quad[j] != quad[(j + 3) % 4])
+          {
+            triangle[n++] = quad[j];
+          }
+        }
+        if (n == 3)
+        {
+          indices.insert (indices.end (), {triangle[0], triangle[1], triangle[2]});
+        }
+      }
+      else if (glm::distance2 (mesh.vertex (v1), mesh.vertex (v3)) <=
+               glm::distance2 (mesh.vertex (v2), mesh.vertex (v4)))
+      {
+        indices.insert (indices.end (), {v1, v2, v3, v1, v3, v4});
       }
       else
       {
-        mesh.addIndex (v2);
-        mesh.addIndex (v3);
-        mesh.addIndex (v4);
-        mesh.addIndex (v2);
-        mesh.addIndex (v4);
-        mesh.addIndex (v1);
+        indices.insert (indices.end (), {v2, v3, v4, v2, v4, v1});
       }
     };
 
-    auto makeFaces = [&params, &makeQuad](unsigned int edge, unsigned int x, unsigned int y,
-                                          unsigned int z) {
+    auto makeFaces = [&params, &makeQuad](std::vector<unsigned int>& indices, unsigned int edge,
+                                          unsigned int x, unsigned int y, unsigned int z) {
       assert (edge == 0 || edge == 1 || edge == 2);
 
-      const float s1 = params.samples.at (params.sampleIndex (x, y, z));
-      const float s2 = params.samples.at (
-        params.sampleIndex (edge == 0 ? x + 1 : x, edge == 1 ? y + 1 : y, edge == 2 ? z + 1 : z));
+      const float s1 = params.sample (x, y, z, 0);
+      const float s2 = params.sample (x, y, z, 1 << edge);
 
       if (isIntersecting (s1, s2))
       {
-        const unsigned int i = params.cubeIndex (x, y, z);
+        const unsigned int i = params.leafIndex (x, y, z);
 
         unsigned int iu, iv, iuv;
         if (edge == 0)
         {
-          iu = params.cubeIndex (x, y - 1, z);
-          iv = params.cubeIndex (x, y, z - 1);
-          iuv = params.cubeIndex (x, y - 1, z - 1);
+          iu = params.leafIndex (x, y - 1, z);
+          iv = params.leafIndex (x, y, z - 1);
+          iuv = params.leafIndex (x, y - 1, z - 1);
         }
         else if (edge == 1)
         {
-          iu = params.cubeIndex (x, y, z - 1);
-          iv = params.cubeIndex (x - 1, y, z);
-          iuv = params.cubeIndex (x - 1, y, z - 1);
+          iu = params.leafIndex (x, y, z - 1);
+          iv = params.leafIndex (x - 1, y, z);
+          iuv = params.leafIndex (x - 1, y, z - 1);
         }
         else if (edge == 2)
         {
-          iu = params.cubeIndex (x - 1, y, z);
-          iv = params.cubeIndex (x, y - 1, z);
-          iuv = params.cubeIndex (x - 1, y - 1, z);
+          iu = params.leafIndex (x - 1, y, z);
+          iv = params.leafIndex (x, y - 1, z);
+          iuv = params.leafIndex (x - 1, y - 1, z);
         }
         else
         {
           DILAY_IMPOSSIBLE
         }
-        makeQuad (edge, s1 >= 0.0f, i, iu, iv, iuv);
+        makeQuad (indices, edge, s1 >= 0.0f, i, iu, iv, iuv);
       }
     };
 
-    for (unsigned int z = 0; z < params.numCubes.z; z++)
+    // faces are collected per block in parallel and added in block order
+    std::vector<std::vector<unsigned int>> indicesByBlock (params.activeBlocks.size ());
+
+    params.forEachBlockParallel (
+      SketchConversionJob::Phase::Mesh, [&params, &makeFaces, &indicesByBlock](unsigned int i) {
+        std::vector<unsigned int>& indices = indicesByBlock[i];
+
+        params.forEachCube (i,
+                            [&makeFaces, &indices](unsigned int x, unsigned int y, unsigned int z) {
+                              if (y > 0 && z > 0)
+                              {
+                                makeFaces (indices, 0, x, y, z);
+                              }
+                              if (x > 0 && z > 0)
+                              {
+                                makeFaces (indices, 1, x, y, z);
+                              }
+                              if (x > 0 && y > 0)
+                              {
+                                makeFaces (indices, 2, x, y, z);
+                              }
+                            });
+      });
+
+    if (params.isCancelled ())
     {
-      for (unsigned int y = 0; y < params.numCubes.y; y++)
+      return Mesh ();
+    }
+
+    for (const std::vector<unsigned int>& indices : indicesByBlock)
+    {
+      for (unsigned int i : indices)
       {
-        for (unsigned int x = 0; x < params.numCubes.x; x++)
-        {
-          if (y > 0 && z > 0)
-          {
-            makeFaces (0, x, y, z);
-          }
-          if (x > 0 && z > 0)
-          {
-            makeFaces (1, x, y, z);
-          }
-          if (x > 0 && y > 0)
-          {
-            makeFaces (2, x, y, z);
-          }
-        }
+        mesh.addIndex (i);
       }
     }
 
     assert (MeshUtil::checkConsistency (mesh));
     return mesh;
   }
+
+  Mesh runConversion (const DistanceTree& tree, Parameters& params)
+  {
+    if (params.numSamples.x > 0 && params.numSamples.y > 0 && params.numSamples.z > 0)
+    {
+      sample (tree, params);
+      makeGrid (params);
+      resolveNonManifolds (params);
+
+      if (params.adaptive)
+      {
+        simplify (tree, params);
+      }
+      return params.isCancelled () ? Mesh () : makeMesh (params);
+    }
+    else
+    {
+      return Mesh ();
+    }
+  }
 }
 
-Mesh SketchConversion::convert (const SketchMesh& mesh, float resolution)
+Mesh SketchConversion::convert (const SketchMesh& mesh, float resolution, bool adaptive)
 {
   assert (mesh.isEmpty () == false);
 
-  Parameters params;
+  Progress   progress;
+  Parameters params (progress);
   params.resolution = resolution;
+  params.adaptive = adaptive;
 
   setupSampling (mesh, params);
+  return runConversion (DistanceTree (mesh), params);
+}
 
-  if (params.numSamples.x > 0 && params.numSamples.y > 0 && params.numSamples.z > 0)
+struct SketchConversionJob::Impl
+{
+  Progress           progress;
+  Parameters         params;
+  const DistanceTree tree;
+  Mesh               mesh;
+  std::atomic<bool>  done;
+  std::thread        thread;
+
+  Impl (const SketchMesh& sketch, float resolution, bool adaptive)
+    : params (this->progress)
+    , tree (sketch)
+    , done (false)
   {
-    sample (mesh, params);
-    makeGrid (params);
-    resolveNonManifolds (params);
-    return makeMesh (params);
+    assert (sketch.isEmpty () == false);
+
+    this->params.resolution = resolution;
+    this->params.adaptive = adaptive;
+    setupSampling (sketch, this->params);
+
+    this->thread = std::thread ([this]() {
+      this->mesh = runConversion (this->tree, this->params);
+      this->done = true;
+    });
   }
-  else
+
+  ~Impl ()
   {
-    return Mesh ();
+    this->cancel ();
+    this->thread.join ();
   }
-}
+
+  Phase phase () const { return this->progress.phase; }
+
+  bool isDone () const { return this->done; }
+
+  bool isCancelled () const { return this->progress.cancelled; }
+
+  void cancel () { this->progress.cancelled = true; }
+
+  Mesh takeMesh ()
+  {
+    assert (this->isDone ());
+    assert (this->isCancelled () == false);
+
+    return std::move (this->mesh);
+  }
+};
+
+DELEGATE3_BIG2 (SketchConversionJob, const SketchMesh&, float, bool)
+DELEGATE_CONST (SketchConversionJob::Phase, SketchConversionJob, phase)
+DELEGATE_CONST (bool, SketchConversionJob, isDone)
+DELEGATE_CONST (bool, SketchConversionJob, isCancelled)
+DELEGATE (void, SketchConversionJob, cancel)
+DELEGATE (Mesh, SketchConversionJob, takeMesh)
+
+float SketchConversionJob::progress () const { return this->impl->progress.fraction (); }
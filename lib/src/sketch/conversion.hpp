@@ -5,12 +5,46 @@
 #ifndef DILAY_SKETCH_CONVERSION
 #define DILAY_SKETCH_CONVERSION
 
+#include "macro.hpp"
+
 class Mesh;
 class SketchMesh;
 
+/* Sketch meshes are converted by sampling their distance field on a uniform grid.  Adaptive
+ * conversions merge cubes of flat regions into larger cells (see `simplify` in conversion.cpp).
+ */
 namespace SketchConversion
 {
-  Mesh convert (const SketchMesh&, float);
+  Mesh convert (const SketchMesh&, float, bool = false);
+};
+
+/* Converts a sketch mesh on a background thread.  The primitives of the sketch mesh are copied
+ * on construction, i.e. the sketch mesh may be modified or deleted while the job is running.
+ * Deleting a job cancels it and waits for its thread to finish.
+ */
+class SketchConversionJob
+{
+public:
+  enum class Phase
+  {
+    Sample,
+    Grid,
+    NonManifolds,
+    Simplify,
+    Mesh
+  };
+
+  DECLARE_BIG2 (SketchConversionJob, const SketchMesh&, float, bool)
+
+  Phase phase () const;
+  float progress () const;
+  bool  isDone () const;
+  bool  isCancelled () const;
+  void  cancel ();
+  Mesh  takeMesh ();
+
+private:
+  IMPLEMENTATION
 };
 
 #endif
@@ -2,13 +2,17 @@
  * Copyright © 2015-2017 Alexander Bau
  * Use and redistribute under the terms of the GNU General Public License
  */
+#include <atomic>
+#include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtx/norm.hpp>
 #include <glm/gtx/rotate_vector.hpp>
+#include <vector>
 #include "../mesh.hpp"
 #include "color.hpp"
 #include "config.hpp"
 #include "dimension.hpp"
 #include "distance.hpp"
+#include "mesh-instances.hpp"
 #include "mesh-util.hpp"
 #include "primitive/aabox.hpp"
 #include "primitive/cone-sphere.hpp"
@@ -39,6 +43,12 @@ namespace
     }
   };
 
+  unsigned int newId ()
+  {
+    static std::atomic<unsigned int> nextId (0);
+    return nextId++;
+  }
+
   bool almostEqual (const glm::vec3& a, const glm::vec3& b)
   {
     return glm::distance2 (a, b) <= Util::epsilon () * Util::epsilon ();
@@ -78,15 +88,25 @@ namespace
 
 struct SketchMesh::Impl
 {
-  SketchMesh*  self;
-  SketchTree   tree;
-  SketchPaths  paths;
-  Mesh         sphereMesh;
-  Mesh         boneMesh;
-  RenderConfig renderConfig;
+  SketchMesh*        self;
+  const unsigned int id;
+  SketchTree         tree;
+  SketchPaths        paths;
+  Mesh               sphereMesh;
+  Mesh               boneMesh;
+  MeshInstances      sphereInstances;
+  MeshInstances      boneInstances;
+  RenderConfig       renderConfig;
+
+  // the bounding box is computed by `minMax` and outdated by each modification (cf. `MeshBvh`)
+  mutable bool      isMinMaxOutdated;
+  mutable glm::vec3 minimum;
+  mutable glm::vec3 maximum;
 
   Impl (SketchMesh* s)
     : self (s)
+    , id (newId ())
+    , isMinMaxOutdated (true)
   {
     this->sphereMesh = MeshUtil::icosphere (3);
     this->sphereMesh.bufferData ();
@@ -100,11 +120,15 @@ struct SketchMesh::Impl
 
   Impl (const Impl& other)
     : self (nullptr)
+    , id (newId ())
     , tree (other.tree)
     , paths (other.paths)
     , sphereMesh (other.sphereMesh)
     , boneMesh (other.boneMesh)
     , renderConfig (other.renderConfig)
+    , isMinMaxOutdated (other.isMinMaxOutdated)
+    , minimum (other.minimum)
+    , maximum (other.maximum)
   {
     this->sphereMesh.bufferData ();
     this->boneMesh.bufferData ();
@@ -112,9 +136,19 @@ struct SketchMesh::Impl
 
   bool isEmpty () const { return this->tree.hasRoot () == false && this->paths.empty (); }
 
-  void fromTree (const SketchTree& newTree) { this->tree = newTree; }
+  void fromTree (const SketchTree& newTree)
+  {
+    this->outdateMinMax ();
+    this->tree = newTree;
+  }
+
+  void reset ()
+  {
+    this->outdateMinMax ();
+    this->tree.reset ();
+  }
 
-  void reset () { this->tree.reset (); }
+  void outdateMinMax () { this->isMinMaxOutdated = true; }
 
   bool intersects (const PrimRay& ray, SketchNodeIntersection& intersection)
   {
@@ -293,18 +327,15 @@ struct SketchMesh::Impl
     return intersection.isIntersection ();
   }
 
-  void renderTree (Camera& camera)
+  void addTreeInstances ()
   {
     if (this->tree.hasRoot ())
     {
-      this->tree.root ().forEachConstNode ([this, &camera](const SketchNode& node) {
+      this->tree.root ().forEachConstNode ([this](const SketchNode& node) {
         const glm::vec3& pos = node.data ().center ();
         const float      radius = node.data ().radius ();
 
-        this->sphereMesh.position (pos);
-        this->sphereMesh.scaling (glm::vec3 (radius));
-        this->sphereMesh.color (this->renderConfig.nodeColor);
-        this->sphereMesh.render (camera);
+        this->addSphereInstance (pos, radius, this->renderConfig.nodeColor);
 
         if (node.parent ())
         {
@@ -316,38 +347,34 @@ struct SketchMesh::Impl
           if (this->renderConfig.renderWireframe)
           {
             const glm::vec3 down = glm::vec3 (0.0f, -1.0f, 0.0f);
+            glm::mat4x4     rotation (1.0f);
 
             if (Util::colinearUnit (direction, down))
             {
-              this->boneMesh.rotationMatrix (glm::mat4x4 (1.0f));
-
               if (glm::dot (direction, down) < 0.0f)
               {
-                this->boneMesh.rotateX (glm::pi<float> ());
+                rotation =
+                  glm::rotate (rotation, glm::pi<float> (), glm::vec3 (1.0f, 0.0f, 0.0f));
               }
             }
             else
             {
-              this->boneMesh.rotationMatrix (glm::orientation (direction, down));
+              rotation = glm::orientation (direction, down);
             }
 
-            this->boneMesh.color (this->renderConfig.nodeColor);
-            this->boneMesh.position (parPos);
-            this->boneMesh.scaling (glm::vec3 (parRadius, distance, parRadius));
-            this->boneMesh.render (camera);
+            this->boneInstances.addInstance (
+              glm::translate (glm::mat4x4 (1.0f), parPos) * rotation *
+                glm::scale (glm::mat4x4 (1.0f), glm::vec3 (parRadius, distance, parRadius)),
+              this->renderConfig.nodeColor);
           }
           else
           {
-            this->sphereMesh.color (this->renderConfig.bubbleColor);
-
             for (float d = radius * 0.5f; d < distance;)
             {
               const glm::vec3 bubblePos = pos + (d * direction);
               const float     bubbleRadius = glm::mix (radius, parRadius, d / distance);
 
-              this->sphereMesh.position (bubblePos);
-              this->sphereMesh.scaling (glm::vec3 (bubbleRadius));
-              this->sphereMesh.render (camera);
+              this->addSphereInstance (bubblePos, bubbleRadius, this->renderConfig.bubbleColor);
 
               d += bubbleRadius * 0.5f;
             }
@@ -357,24 +384,29 @@ struct SketchMesh::Impl
     }
   }
 
-  void renderPaths (Camera& camera)
+  void addSphereInstance (const glm::vec3& position, float radius, const Color& color)
   {
-    this->sphereMesh.color (this->renderConfig.sphereColor);
-
-    for (const SketchPath& p : this->paths)
-    {
-      p.render (camera, this->sphereMesh);
-    }
+    this->sphereInstances.addInstance (glm::translate (glm::mat4x4 (1.0f), position) *
+                                         glm::scale (glm::mat4x4 (1.0f), glm::vec3 (radius)),
+                                       color);
   }
 
   void render (Camera& camera)
   {
-    this->renderTree (camera);
+    this->sphereInstances.reset ();
+    this->boneInstances.reset ();
+
+    this->addTreeInstances ();
 
     if (this->renderConfig.renderWireframe == false)
     {
-      this->renderPaths (camera);
+      for (const SketchPath& p : this->paths)
+      {
+        p.addInstances (this->sphereInstances, this->renderConfig.sphereColor);
+      }
     }
+    this->sphereMesh.renderInstances (camera, this->sphereInstances);
+    this->boneMesh.renderInstances (camera, this->boneInstances);
   }
 
   void renderWireframe (bool v) { this->renderConfig.renderWireframe = v; }
@@ -455,6 +487,8 @@ struct SketchMesh::Impl
   SketchNode& addChild (SketchNode& parent, const glm::vec3& pos, float radius,
                         const Dimension* dim)
   {
+    this->outdateMinMax ();
+
     SketchNode& newNode = parent.emplaceChild (pos, radius);
 
     if (dim)
@@ -468,6 +502,7 @@ struct SketchMesh::Impl
                          const Dimension* dim)
   {
     assert (child.parent ());
+    this->outdateMinMax ();
 
     SketchNode& newNode = child.parent ()->emplaceChild (pos, radius);
     newNode.addChild (child);
@@ -493,6 +528,7 @@ struct SketchMesh::Impl
 
   SketchPath& addPath (const SketchPath& path)
   {
+    this->outdateMinMax ();
     this->paths.push_back (path);
     return this->paths.back ();
   }
@@ -500,6 +536,8 @@ struct SketchMesh::Impl
   void addSphere (bool newPath, const glm::vec3& intersection, const glm::vec3& position,
                   float radius, const Dimension* dim)
   {
+    this->outdateMinMax ();
+
     if (newPath)
     {
       this->paths.emplace_back ();
@@ -521,6 +559,8 @@ struct SketchMesh::Impl
 
   void move (SketchNode& node, const glm::vec3& delta, bool all, const Dimension* dim)
   {
+    this->outdateMinMax ();
+
     const auto moveNodes = [all](SketchNode& node, const glm::vec3& delta) {
       if (all)
       {
@@ -553,6 +593,8 @@ struct SketchMesh::Impl
 
   void scale (SketchNode& node, float factor, bool all, const Dimension* dim)
   {
+    this->outdateMinMax ();
+
     const auto scaleNodes = [factor, all](SketchNode& node) {
       if (all)
       {
@@ -584,6 +626,8 @@ struct SketchMesh::Impl
 
   void rotate (SketchNode& node, const glm::vec3& axis, float angle, const Dimension* dim)
   {
+    this->outdateMinMax ();
+
     const auto rotateNodes = [](SketchNode& node, const glm::vec3& axis, float angle) {
       const glm::mat4x4 matrix = Util::rotation (node.data ().center (), axis, angle);
 
@@ -613,6 +657,7 @@ struct SketchMesh::Impl
   void deleteNode (SketchNode& node, bool deleteChildren, const Dimension* dim)
   {
     assert (this->tree.hasRoot ());
+    this->outdateMinMax ();
 
     if (node.parent () == nullptr)
     {
@@ -652,6 +697,7 @@ struct SketchMesh::Impl
   void deletePath (SketchPath& path, const Dimension* dim)
   {
     assert (this->paths.empty () == false);
+    this->outdateMinMax ();
 
     if (dim && this->paths.size () >= 2)
     {
@@ -755,6 +801,7 @@ struct SketchMesh::Impl
 
   void mirror (Dimension dim)
   {
+    this->outdateMinMax ();
     this->mirrorTree (dim);
     this->mirrorPaths (dim);
   }
@@ -768,6 +815,8 @@ struct SketchMesh::Impl
   SketchNode& snap (SketchNode& node, Dimension dim)
   {
     assert (this->tree.hasRoot ());
+    this->outdateMinMax ();
+
     const PrimPlane mPlane = this->mirrorPlane (dim);
 
     SketchNode* nodeM = this->mirrored (node, mPlane, node);
@@ -800,26 +849,37 @@ struct SketchMesh::Impl
 
   void minMax (glm::vec3& min, glm::vec3& max) const
   {
-    min = glm::vec3 (Util::maxFloat ());
-    max = glm::vec3 (Util::minFloat ());
-
-    if (this->tree.hasRoot ())
-    {
-      this->tree.root ().forEachConstNode ([&min, &max](const SketchNode& node) {
-        min = glm::min (min, node.data ().center () - glm::vec3 (node.data ().radius ()));
-        max = glm::max (max, node.data ().center () + glm::vec3 (node.data ().radius ()));
-      });
-    }
-    for (const SketchPath& p : this->paths)
+    if (this->isMinMaxOutdated)
     {
-      min = glm::min (min, p.minimum ());
-      max = glm::max (max, p.maximum ());
+      glm::vec3& newMin = this->minimum;
+      glm::vec3& newMax = this->maximum;
+
+      newMin = glm::vec3 (Util::maxFloat ());
+      newMax = glm::vec3 (Util::minFloat ());
+
+      if (this->tree.hasRoot ())
+      {
+        this->tree.root ().forEachConstNode ([&newMin, &newMax](const SketchNode& node) {
+          newMin = glm::min (newMin, node.data ().center () - glm::vec3 (node.data ().radius ()));
+          newMax = glm::max (newMax, node.data ().center () + glm::vec3 (node.data ().radius ()));
+        });
+      }
+      for (const SketchPath& p : this->paths)
+      {
+        newMin = glm::min (newMin, p.minimum ());
+        newMax = glm::max (newMax, p.maximum ());
+      }
+      this->isMinMaxOutdated = false;
     }
+    min = this->minimum;
+    max = this->maximum;
   }
 
   void smoothPath (SketchPath& path, const PrimSphere& range, unsigned int halfWidth,
                    SketchPathSmoothEffect effect, const Dimension* dim)
   {
+    this->outdateMinMax ();
+
     if (IntersectionUtil::intersects (range, path.aabox ()))
     {
       PrimSphereIntersection intersection1, intersection2;
@@ -852,6 +912,8 @@ struct SketchMesh::Impl
 
   void optimizePaths ()
   {
+    this->outdateMinMax ();
+
     for (SketchPath& p1 : this->paths)
     {
       for (SketchPath& p2 : this->paths)
@@ -892,17 +954,30 @@ struct SketchMesh::Impl
       }
       if (this->tree.hasRoot ())
       {
-        this->tree.root ().forEachNode ([&p1](SketchNode& node) {
+        std::vector<float> xs, ys, zs, distances;
+
+        this->tree.root ().forEachNode ([&p1, &xs, &ys, &zs, &distances](SketchNode& node) {
           if (node.parent ())
           {
             const PrimConeSphere coneSphere (node.data (), node.parent ()->data ());
 
-            for (auto it1 = p1.spheres ().begin (); it1 != p1.spheres ().end ();)
+            xs.clear ();
+            ys.clear ();
+            zs.clear ();
+            for (const PrimSphere& s : p1.spheres ())
             {
-              const PrimSphere& s1 = *it1;
-              const float       d = Distance::distance (coneSphere, s1.center ());
+              xs.push_back (s.center ().x);
+              ys.push_back (s.center ().y);
+              zs.push_back (s.center ().z);
+            }
+            distances.resize (xs.size ());
+            Distance::distances (coneSphere, xs.size (), xs.data (), ys.data (), zs.data (),
+                                 distances.data ());
 
-              if (d < -s1.radius ())
+            unsigned int i = 0;
+            for (auto it1 = p1.spheres ().begin (); it1 != p1.spheres ().end (); i++)
+            {
+              if (distances[i] < -it1->radius ())
               {
                 it1 = p1.deleteSphere (it1);
               }
@@ -926,8 +1001,8 @@ struct SketchMesh::Impl
 };
 
 DELEGATE_BIG4_COPY_SELF (SketchMesh);
+GETTER_CONST (unsigned int, SketchMesh, id)
 GETTER_CONST (const SketchTree&, SketchMesh, tree)
-GETTER (SketchTree&, SketchMesh, tree)
 GETTER_CONST (const SketchPaths&, SketchMesh, paths)
 DELEGATE_CONST (bool, SketchMesh, isEmpty)
 DELEGATE1 (void, SketchMesh, fromTree, const SketchTree&)
@@ -960,3 +1035,9 @@ DELEGATE5 (void, SketchMesh, smoothPath, SketchPath&, const PrimSphere&, unsigne
            SketchPathSmoothEffect, const Dimension*)
 DELEGATE (void, SketchMesh, optimizePaths)
 DELEGATE1 (void, SketchMesh, runFromConfig, const Config&)
+
+SketchTree& SketchMesh::tree ()
+{
+  this->impl->outdateMinMax ();
+  return this->impl->tree;
+}
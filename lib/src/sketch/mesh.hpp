@@ -22,6 +22,9 @@ class SketchMesh : public Configurable
 public:
   DECLARE_BIG4_EXPLICIT_COPY (SketchMesh);
 
+  // unique among all sketch meshes, copies get a new id
+  unsigned int id () const;
+
   const SketchTree&  tree () const;
   SketchTree&        tree ();
   const SketchPaths& paths () const;
@@ -194,6 +194,8 @@ struct State::Impl
   {
     assert (this->hasTool () == false);
 
+    this->mainWindow.glWidget ().flushPointingEvents ();
+
     this->toolPtr.reset (&tool);
     this->mainWindow.toolPane ().button (this->toolPtr->key ()).setChecked (true);
     this->resetToolTip ();
@@ -215,6 +217,8 @@ struct State::Impl
 
   void resetTool ()
   {
+    this->mainWindow.glWidget ().flushPointingEvents ();
+
     if (this->hasTool ())
     {
       this->previousToolKey = this->toolPtr->key ();
@@ -245,6 +249,8 @@ struct State::Impl
 
   void undo ()
   {
+    this->mainWindow.glWidget ().flushPointingEvents ();
+
     if (this->hasTool ())
     {
       this->handleToolResponse (this->toolPtr->commit ());
@@ -256,6 +262,8 @@ struct State::Impl
 
   void redo ()
   {
+    this->mainWindow.glWidget ().flushPointingEvents ();
+
     if (this->hasTool ())
     {
       this->handleToolResponse (this->toolPtr->commit ());
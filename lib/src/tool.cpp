@@ -134,6 +134,11 @@ struct Tool::Impl
     this->state.history ().snapshotSketchMeshes (this->state.scene ());
   }
 
+  void snapshotDynamicMeshDeltas ()
+  {
+    this->state.history ().snapshotDynamicMeshDeltas (this->state.scene ());
+  }
+
   bool intersectsRecentDynamicMesh (const PrimRay& ray, Intersection& intersection) const
   {
     assert (this->state.history ().hasRecentDynamicMesh ());
@@ -297,6 +302,7 @@ DELEGATE_CONST (glm::ivec2, Tool, cursorPosition)
 DELEGATE (void, Tool, snapshotAll)
 DELEGATE (void, Tool, snapshotDynamicMeshes)
 DELEGATE (void, Tool, snapshotSketchMeshes)
+DELEGATE (void, Tool, snapshotDynamicMeshDeltas)
 DELEGATE2_CONST (bool, Tool, intersectsRecentDynamicMesh, const PrimRay&, Intersection&)
 DELEGATE2_CONST (bool, Tool, intersectsRecentDynamicMesh, const glm::ivec2&, Intersection&)
 DELEGATE_CONST (bool, Tool, hasMirror)
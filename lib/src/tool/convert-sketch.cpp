@@ -3,9 +3,16 @@
  * Use and redistribute under the terms of the GNU General Public License
  */
 #include <QCheckBox>
+#include <QProgressBar>
+#include <QPushButton>
+#include <QTimer>
+#include <memory>
 #include "cache.hpp"
+#include "color.hpp"
+#include "config.hpp"
 #include "dynamic/mesh.hpp"
 #include "mesh.hpp"
+#include "render-mode.hpp"
 #include "scene.hpp"
 #include "sketch/conversion.hpp"
 #include "sketch/mesh-intersection.hpp"
@@ -13,6 +20,7 @@
 #include "state.hpp"
 #include "tool/sculpt/util/action.hpp"
 #include "tools.hpp"
+#include "util.hpp"
 #include "view/double-slider.hpp"
 #include "view/pointing-event.hpp"
 #include "view/tool-tip.hpp"
@@ -38,12 +46,23 @@ namespace
 
 struct ToolConvertSketch::Impl
 {
-  ToolConvertSketch* self;
-  const float        minResolution;
-  const float        maxResolution;
-  float              resolution;
-  bool               moveToCenter;
-  bool               smoothMesh;
+  ToolConvertSketch*                   self;
+  const float                          minResolution;
+  const float                          maxResolution;
+  float                                resolution;
+  bool                                 moveToCenter;
+  bool                                 smoothMesh;
+  bool                                 adaptive;
+  bool                                 preview;
+  QProgressBar*                        progressBar;
+  QPushButton*                         cancelButton;
+  QTimer                               timer;
+  std::unique_ptr<SketchConversionJob> job;
+  unsigned int                         jobSketchId;
+  glm::vec3                            jobCenter;
+  std::unique_ptr<SketchConversionJob> previewJob;
+  unsigned int                         previewSketchId;
+  Mesh                                 previewMesh;
 
   Impl (ToolConvertSketch* s)
     : self (s)
@@ -52,7 +71,15 @@ struct ToolConvertSketch::Impl
     , resolution (s->cache ().get<float> ("resolution", 0.06))
     , moveToCenter (s->cache ().get<bool> ("move-to-center", true))
     , smoothMesh (s->cache ().get<bool> ("smooth-mesh", true))
+    , adaptive (s->cache ().get<bool> ("adaptive", false))
+    , preview (s->cache ().get<bool> ("preview", false))
+    , progressBar (nullptr)
+    , cancelButton (nullptr)
+    , jobSketchId (Util::invalidIndex ())
+    , previewSketchId (Util::invalidIndex ())
   {
+    this->timer.setInterval (50);
+    QObject::connect (&this->timer, &QTimer::timeout, [this]() { this->poll (); });
   }
 
   ToolResponse runInitialize ()
@@ -72,6 +99,7 @@ struct ToolConvertSketch::Impl
     ViewUtil::connect (resolutionEdit, [this](float r) {
       this->resolution = r;
       this->self->cache ().set ("resolution", r);
+      this->startPreview (this->findInScene (this->previewSketchId));
     });
     properties.addStacked (QObject::tr ("Resolution"), resolutionEdit);
 
@@ -89,6 +117,30 @@ struct ToolConvertSketch::Impl
       this->self->cache ().set ("smooth-mesh", s);
     });
     properties.add (smoothMeshEdit);
+
+    QCheckBox& adaptiveEdit = ViewUtil::checkBox (QObject::tr ("Adaptive"), this->adaptive);
+    ViewUtil::connect (adaptiveEdit, [this](bool a) {
+      this->adaptive = a;
+      this->self->cache ().set ("adaptive", a);
+      this->startPreview (this->findInScene (this->previewSketchId));
+    });
+    properties.add (adaptiveEdit);
+
+    QCheckBox& previewEdit = ViewUtil::checkBox (QObject::tr ("Preview"), this->preview);
+    ViewUtil::connect (previewEdit, [this](bool p) {
+      this->preview = p;
+      this->self->cache ().set ("preview", p);
+      this->startPreview (nullptr);
+    });
+    properties.add (previewEdit);
+
+    this->progressBar = new QProgressBar;
+    this->progressBar->setRange (0, 100);
+    this->cancelButton = &ViewUtil::pushButton (QObject::tr ("Cancel"));
+    ViewUtil::connect (*this->cancelButton, [this]() { this->cancelConversion (); });
+    properties.add (*this->progressBar, *this->cancelButton);
+
+    this->updateProgress ();
   }
 
   void setupToolTip ()
@@ -98,40 +150,238 @@ struct ToolConvertSketch::Impl
     this->self->showToolTip (toolTip);
   }
 
+  float conversionResolution () const
+  {
+    return this->maxResolution + this->minResolution - this->resolution;
+  }
+
+  float previewResolution () const
+  {
+    return glm::min (this->maxResolution, 2.0f * this->conversionResolution ());
+  }
+
+  /* Sketch meshes may be deleted while a job is running, e.g. by opening a file, and a new mesh
+   * may be allocated at the same address.  Thus, meshes are referred to by their ids.
+   */
+  SketchMesh* findInScene (unsigned int id) const
+  {
+    SketchMesh* found = nullptr;
+    this->self->state ().scene ().forEachMesh ([id, &found](SketchMesh& m) {
+      if (m.id () == id)
+      {
+        found = &m;
+      }
+    });
+    return found;
+  }
+
+  void updateProgress ()
+  {
+    if (this->job)
+    {
+      const SketchConversionJob::Phase phase = this->job->phase ();
+      QString                          label;
+
+      switch (phase)
+      {
+        case SketchConversionJob::Phase::Sample:
+          label = QObject::tr ("Sampling");
+          break;
+        case SketchConversionJob::Phase::Grid:
+          label = QObject::tr ("Building grid");
+          break;
+        case SketchConversionJob::Phase::NonManifolds:
+          label = QObject::tr ("Resolving non-manifolds");
+          break;
+        case SketchConversionJob::Phase::Simplify:
+          label = QObject::tr ("Simplifying");
+          break;
+        case SketchConversionJob::Phase::Mesh:
+          label = QObject::tr ("Meshing");
+          break;
+      }
+      const float fraction = (float(phase) + this->job->progress ()) / 5.0f;
+
+      this->progressBar->setFormat (label + " %p%");
+      this->progressBar->setValue (int(100.0f * fraction));
+      this->progressBar->setEnabled (true);
+      this->cancelButton->setEnabled (true);
+    }
+    else
+    {
+      this->progressBar->setFormat ("");
+      this->progressBar->setValue (0);
+      this->progressBar->setEnabled (false);
+      this->cancelButton->setEnabled (false);
+    }
+  }
+
+  void poll ()
+  {
+    if (this->previewJob && this->previewJob->isDone ())
+    {
+      this->finishPreview ();
+    }
+    if (this->job)
+    {
+      if (this->job->isDone ())
+      {
+        this->finishConversion ();
+      }
+      else
+      {
+        this->updateProgress ();
+      }
+    }
+    if (this->job == nullptr && this->previewJob == nullptr)
+    {
+      this->timer.stop ();
+    }
+  }
+
+  void startPreview (const SketchMesh* mesh)
+  {
+    this->previewJob.reset ();
+    this->previewSketchId = Util::invalidIndex ();
+
+    if (this->preview && mesh)
+    {
+      this->previewSketchId = mesh->id ();
+      this->previewJob =
+        std::make_unique<SketchConversionJob> (*mesh, this->previewResolution (), this->adaptive);
+      this->timer.start ();
+    }
+    else if (this->previewMesh.numVertices () > 0)
+    {
+      this->previewMesh.reset ();
+      this->self->updateGlWidget ();
+    }
+  }
+
+  void finishPreview ()
+  {
+    assert (this->previewJob && this->previewJob->isDone ());
+
+    if (this->previewJob->isCancelled () == false && this->findInScene (this->previewSketchId))
+    {
+      const Config& config = this->self->config ();
+
+      this->previewMesh = this->previewJob->takeMesh ();
+      this->previewMesh.renderMode ().smoothShading (true);
+      this->previewMesh.renderMode ().renderWireframe (true);
+      this->previewMesh.color (config.get<Color> ("editor/mesh/color/normal"));
+      this->previewMesh.wireframeColor (config.get<Color> ("editor/mesh/color/wireframe"));
+      this->previewMesh.bufferData ();
+      this->self->updateGlWidget ();
+    }
+    this->previewJob.reset ();
+  }
+
+  void cancelConversion ()
+  {
+    if (this->job)
+    {
+      this->job.reset ();
+      this->jobSketchId = Util::invalidIndex ();
+      this->updateProgress ();
+    }
+  }
+
+  void finishConversion ()
+  {
+    assert (this->job && this->job->isDone ());
+
+    std::unique_ptr<SketchConversionJob> finished = std::move (this->job);
+    SketchMesh* const                    sMesh = this->findInScene (this->jobSketchId);
+
+    this->jobSketchId = Util::invalidIndex ();
+    this->updateProgress ();
+
+    if (finished->isCancelled () || sMesh == nullptr)
+    {
+      return;
+    }
+
+    if (sMesh->id () == this->previewSketchId)
+    {
+      this->startPreview (nullptr);
+    }
+
+    this->self->snapshotAll ();
+
+    Mesh         mesh = finished->takeMesh ();
+    DynamicMesh& dMesh =
+      this->self->state ().scene ().newDynamicMesh (this->self->state ().config (), mesh);
+    if (this->moveToCenter)
+    {
+      dMesh.translate (-this->jobCenter);
+      dMesh.normalize ();
+      dMesh.bufferData ();
+    }
+    if (this->smoothMesh)
+    {
+      ToolSculptAction::smoothMesh (dMesh);
+    }
+    this->self->state ().scene ().deleteMesh (*sMesh);
+    this->self->state ().handleToolResponse (ToolResponse::Redraw);
+  }
+
+  void runRender () const
+  {
+    if (this->previewMesh.numIndices () > 0)
+    {
+      this->previewMesh.render (this->self->state ().camera ());
+    }
+  }
+
+  ToolResponse runMoveEvent (const ViewPointingEvent& e)
+  {
+    if (this->preview)
+    {
+      SketchMeshIntersection intersection;
+      if (this->self->intersectsScene (e, intersection) &&
+          intersection.mesh ().id () != this->previewSketchId)
+      {
+        this->startPreview (&intersection.mesh ());
+      }
+    }
+    return ToolResponse::None;
+  }
+
   ToolResponse runReleaseEvent (const ViewPointingEvent& e)
   {
-    if (e.leftButton ())
+    if (e.leftButton () && this->job == nullptr)
     {
       SketchMeshIntersection intersection;
       if (this->self->intersectsScene (e, intersection))
       {
         SketchMesh& sMesh = intersection.mesh ();
-        glm::vec3   center = computeCenter (sMesh);
-
-        this->self->snapshotAll ();
-        sMesh.optimizePaths ();
-
-        Mesh mesh = SketchConversion::convert (sMesh, this->maxResolution + this->minResolution -
-                                                        this->resolution);
-        DynamicMesh& dMesh =
-          this->self->state ().scene ().newDynamicMesh (this->self->state ().config (), mesh);
-        if (this->moveToCenter)
-        {
-          dMesh.translate (-center);
-          dMesh.normalize ();
-          dMesh.bufferData ();
-        }
-        if (this->smoothMesh)
-        {
-          ToolSculptAction::smoothMesh (dMesh);
-        }
-        this->self->state ().scene ().deleteMesh (sMesh);
-        return ToolResponse::Redraw;
+        SketchMesh  optimized (sMesh);
+
+        optimized.optimizePaths ();
+
+        this->jobSketchId = sMesh.id ();
+        this->jobCenter = computeCenter (sMesh);
+        this->job = std::make_unique<SketchConversionJob> (
+          optimized, this->conversionResolution (), this->adaptive);
+        this->updateProgress ();
+        this->timer.start ();
       }
     }
     return ToolResponse::None;
   }
+
+  ToolResponse runCommit ()
+  {
+    this->cancelConversion ();
+    this->startPreview (nullptr);
+    this->timer.stop ();
+    return ToolResponse::Redraw;
+  }
 };
 
 DELEGATE_TOOL (ToolConvertSketch, "convert-sketch")
+DELEGATE_TOOL_RUN_RENDER (ToolConvertSketch)
+DELEGATE_TOOL_RUN_MOVE_EVENT (ToolConvertSketch)
 DELEGATE_TOOL_RUN_RELEASE_EVENT (ToolConvertSketch)
+DELEGATE_TOOL_RUN_COMMIT (ToolConvertSketch)
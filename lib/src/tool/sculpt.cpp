@@ -194,7 +194,14 @@ struct ToolSculpt::Impl
     }
     else if (e.pressEvent () && e.leftButton ())
     {
-      this->self->snapshotDynamicMeshes ();
+      if (this->brush.parameters<SBParameters> ().useRecentMesh ())
+      {
+        this->self->snapshotDynamicMeshes ();
+      }
+      else
+      {
+        this->self->snapshotDynamicMeshDeltas ();
+      }
       this->sculptState = SculptState::Started;
     }
 
@@ -261,6 +268,10 @@ struct ToolSculpt::Impl
     {
       this->self->state ().history ().dropPastSnapshot ();
     }
+    else if (this->sculptState == SculptState::Sculpted)
+    {
+      this->self->state ().history ().stopRecording ();
+    }
     this->sculptState = SculptState::None;
     return ToolResponse::None;
   }
@@ -331,7 +342,7 @@ struct ToolSculpt::Impl
     }
   }
 
-  bool updateBrushByIntersection (bool useRecentMesh, const glm::vec3& cursorStep)
+  bool updateBrushByIntersection (const glm::vec3& cursorStep)
   {
     const glm::vec3 from = this->self->state ().camera ().position ();
     const PrimRay   ray = PrimRay (from, cursorStep - from);
@@ -342,10 +353,10 @@ struct ToolSculpt::Impl
     {
       if (this->brush.hasPointOfAction () && (&this->brush.mesh () != &intersection.mesh ()))
       {
-        this->brush.mesh ().bufferData ();
+        this->brush.mesh ().deferBufferData ();
       }
 
-      if (useRecentMesh)
+      if (this->brush.parameters<SBParameters> ().useRecentMesh ())
       {
         Intersection rIntersection;
         if (this->self->intersectsRecentDynamicMesh (ray, rIntersection))
@@ -355,7 +366,7 @@ struct ToolSculpt::Impl
         }
         else
         {
-          this->brush.mesh ().bufferData ();
+          this->brush.mesh ().deferBufferData ();
           this->brush.resetPointOfAction ();
           return false;
         }
@@ -369,14 +380,13 @@ struct ToolSculpt::Impl
     }
     else
     {
-      this->brush.mesh ().bufferData ();
+      this->brush.mesh ().deferBufferData ();
       this->brush.resetPointOfAction ();
       return false;
     }
   }
 
-  bool drawlikeStroke (const ViewPointingEvent& e, bool useRecentMesh,
-                       const std::function<void()>* toggle)
+  bool drawlikeStroke (const ViewPointingEvent& e, const std::function<void()>* toggle)
   {
     DynamicMeshIntersection cursorIntersection;
 
@@ -397,10 +407,10 @@ struct ToolSculpt::Impl
       {
         this->step.stepWidth (this->brush.stepWidth ());
         this->step.step (this->brush.position (), cursorIntersection.position (),
-                         [this, useRecentMesh](const glm::vec3& brushStep) {
+                         [this](const glm::vec3& brushStep) {
                            if (this->brush.hasPointOfAction ())
                            {
-                             if (this->updateBrushByIntersection (useRecentMesh, brushStep))
+                             if (this->updateBrushByIntersection (brushStep))
                              {
                                this->sculpt ();
                              }
@@ -414,7 +424,7 @@ struct ToolSculpt::Impl
       }
       else
       {
-        if (this->updateBrushByIntersection (useRecentMesh, cursorIntersection.position ()))
+        if (this->updateBrushByIntersection (cursorIntersection.position ()))
         {
           this->sculpt ();
         }
@@ -423,7 +433,7 @@ struct ToolSculpt::Impl
       if (this->brush.hasPointOfAction ())
       {
         assert (this->brush.mesh ().isEmpty () == false);
-        this->brush.mesh ().bufferData ();
+        this->brush.mesh ().deferBufferData ();
       }
 
       if (doToggle)
@@ -485,7 +495,7 @@ struct ToolSculpt::Impl
           if (this->brush.hasPointOfAction ())
           {
             assert (this->brush.mesh ().isEmpty () == false);
-            this->brush.mesh ().bufferData ();
+            this->brush.mesh ().deferBufferData ();
           }
           return true;
         }
@@ -538,8 +548,7 @@ DELEGATE2_CONST (void, ToolSculpt, addDefaultToolTip, ViewToolTip&, bool)
 DELEGATE3_CONST (void, ToolSculpt, addSecSliderWheelToolTip, ViewToolTip&, const QString&,
                  const QString&)
 DELEGATE (void, ToolSculpt, sculpt)
-DELEGATE3 (bool, ToolSculpt, drawlikeStroke, const ViewPointingEvent&, bool,
-           const std::function<void()>*)
+DELEGATE2 (bool, ToolSculpt, drawlikeStroke, const ViewPointingEvent&, const std::function<void()>*)
 DELEGATE2 (bool, ToolSculpt, grablikeStroke, const ViewPointingEvent&, ToolUtilMovement&)
 DELEGATE1 (void, ToolSculpt, registerSecondarySlider, ViewDoubleSlider&)
 DELEGATE (ToolResponse, ToolSculpt, runInitialize)
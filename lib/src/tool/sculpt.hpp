@@ -25,7 +25,7 @@ protected:
   void         addDefaultToolTip (ViewToolTip&, bool) const;
   void         addSecSliderWheelToolTip (ViewToolTip&, const QString&, const QString&) const;
   void         sculpt ();
-  bool drawlikeStroke (const ViewPointingEvent&, bool, const std::function<void()>* = nullptr);
+  bool drawlikeStroke (const ViewPointingEvent&, const std::function<void()>* = nullptr);
   bool grablikeStroke (const ViewPointingEvent&, ToolUtilMovement&);
   void registerSecondarySlider (ViewDoubleSlider&);
 
@@ -87,7 +87,7 @@ struct ToolSculptFlatten::Impl
     }
     else
     {
-      return this->self->drawlikeStroke (e, false);
+      return this->self->drawlikeStroke (e);
     }
   }
 };
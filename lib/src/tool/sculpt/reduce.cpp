@@ -49,7 +49,7 @@ struct ToolSculptReduce::Impl
 
   bool runSculptPointingEvent (const ViewPointingEvent& e)
   {
-    return this->self->drawlikeStroke (e, false);
+    return this->self->drawlikeStroke (e);
   }
 };
 
@@ -60,7 +60,7 @@ struct ToolSculptSmooth::Impl
 
   bool runSculptPointingEvent (const ViewPointingEvent& e)
   {
-    return this->self->drawlikeStroke (e, false);
+    return this->self->drawlikeStroke (e);
   }
 };
 
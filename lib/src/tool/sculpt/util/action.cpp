@@ -8,6 +8,7 @@
 #include "dynamic/faces.hpp"
 #include "dynamic/mesh.hpp"
 #include "intersection.hpp"
+#include "parallel.hpp"
 #include "primitive/sphere.hpp"
 #include "primitive/triangle.hpp"
 #include "tool/sculpt/util/action.hpp"
@@ -17,7 +18,8 @@
 
 namespace
 {
-  constexpr float minEdgeLength = 0.001f;
+  constexpr float        minEdgeLength = 0.001f;
+  constexpr unsigned int parallelGrainSize = 512;
 
   struct NewFaces
   {
@@ -182,11 +184,29 @@ namespace
   {
     assert (faces.hasUncomitted () == false);
 
-    const auto split = [&mesh, &newE, maxLength](unsigned int i1, unsigned int i2) {
+    struct EdgeSplit
+    {
+      bool      isSplit;
+      glm::vec3 position;
+      glm::vec3 normal;
+    };
+
+    const auto makeSplit = [&mesh, maxLength](unsigned int i1, unsigned int i2) -> EdgeSplit {
       if (glm::distance2 (mesh.vertex (i1), mesh.vertex (i2)) > maxLength * maxLength)
       {
         const glm::vec3 normal = glm::normalize (mesh.vertexNormal (i1) + mesh.vertexNormal (i2));
-        const unsigned int i3 = mesh.addVertex (getSplitPosition (mesh, i1, i2), normal);
+        return EdgeSplit{true, getSplitPosition (mesh, i1, i2), normal};
+      }
+      else
+      {
+        return EdgeSplit{false, glm::vec3 (0.0f), glm::vec3 (0.0f)};
+      }
+    };
+
+    const auto split = [&mesh, &newE](unsigned int i1, unsigned int i2, const EdgeSplit& s) {
+      if (s.isSplit && newE.contains (i1, i2) == false)
+      {
+        const unsigned int i3 = mesh.addVertex (s.position, s.normal);
         newE.insert (i1, i2, i3);
         return true;
       }
@@ -196,134 +216,183 @@ namespace
       }
     };
 
-    faces.filter ([&mesh, &newE, &split](unsigned int f) {
+    const DynamicFaces::Container domain = faces.indices ();
+    std::vector<EdgeSplit>        splits (3 * domain.size ());
+
+    // Split positions only depend on the unmodified mesh and are computed in parallel
+    Parallel::forRange (domain.size (), parallelGrainSize,
+                        [&mesh, &domain, &splits, &makeSplit](unsigned int begin,
+                                                              unsigned int end) {
+                          for (unsigned int i = begin; i < end; i++)
+                          {
+                            unsigned int i1, i2, i3;
+                            mesh.vertexIndices (domain[i], i1, i2, i3);
+
+                            splits[(3 * i) + 0] = makeSplit (i1, i2);
+                            splits[(3 * i) + 1] = makeSplit (i1, i3);
+                            splits[(3 * i) + 2] = makeSplit (i2, i3);
+                          }
+                        });
+
+    // New vertices are added in domain order, which keeps results reproducible
+    faces.reset ();
+    for (unsigned int i = 0; i < domain.size (); i++)
+    {
       bool wasSplit = false;
 
       unsigned int i1, i2, i3;
-      mesh.vertexIndices (f, i1, i2, i3);
+      mesh.vertexIndices (domain[i], i1, i2, i3);
 
-      if (newE.contains (i1, i2) == false)
-      {
-        wasSplit = split (i1, i2) || wasSplit;
-      }
+      wasSplit = split (i1, i2, splits[(3 * i) + 0]) || wasSplit;
+      wasSplit = split (i1, i3, splits[(3 * i) + 1]) || wasSplit;
+      wasSplit = split (i2, i3, splits[(3 * i) + 2]) || wasSplit;
 
-      if (newE.contains (i1, i3) == false)
+      if (wasSplit)
       {
-        wasSplit = split (i1, i3) || wasSplit;
+        faces.insert (domain[i]);
       }
-
-      if (newE.contains (i2, i3) == false)
-      {
-        wasSplit = split (i2, i3) || wasSplit;
-      }
-      return wasSplit;
-    });
+    }
+    faces.commit ();
   }
 
   void triangulate (DynamicMesh& mesh, const ToolSculptEdgeMap& newE, DynamicFaces& faces)
   {
     assert (faces.hasUncomitted () == false);
 
-    NewFaces newF;
-
-    mesh.forEachFaceExt (faces, [&mesh, &newE, &newF](unsigned int f) {
-      unsigned int i1, i2, i3;
-      mesh.vertexIndices (f, i1, i2, i3);
-
-      const unsigned int e12 = newE.find (i1, i2);
-      const unsigned int e13 = newE.find (i1, i3);
-      const unsigned int e23 = newE.find (i2, i3);
-      const unsigned int invalid = Util::invalidIndex ();
-
-      const unsigned int v1 = mesh.valence (i1);
-      const unsigned int v2 = mesh.valence (i2);
-      const unsigned int v3 = mesh.valence (i3);
+    struct FaceSplit
+    {
+      unsigned int numFaces;
+      unsigned int vertexIndices[12];
 
-      if (e12 == invalid && e13 == invalid && e23 == invalid)
-      {
-      }
-      // One new vertex
-      else if (e12 != invalid && e13 == invalid && e23 == invalid)
+      void addFace (unsigned int i1, unsigned int i2, unsigned int i3)
       {
-        newF.deleteFace (f);
-        newF.addFace (i1, e12, i3);
-        newF.addFace (i3, e12, i2);
+        assert (this->numFaces < 4);
+        this->vertexIndices[(3 * this->numFaces) + 0] = i1;
+        this->vertexIndices[(3 * this->numFaces) + 1] = i2;
+        this->vertexIndices[(3 * this->numFaces) + 2] = i3;
+        this->numFaces++;
       }
-      else if (e12 == invalid && e13 != invalid && e23 == invalid)
-      {
-        newF.deleteFace (f);
-        newF.addFace (i3, e13, i2);
-        newF.addFace (i2, e13, i1);
-      }
-      else if (e12 == invalid && e13 == invalid && e23 != invalid)
-      {
-        newF.deleteFace (f);
-        newF.addFace (i2, e23, i1);
-        newF.addFace (i1, e23, i3);
-      }
-      // Two new vertices
-      else if (e12 != invalid && e13 != invalid && e23 == invalid)
-      {
-        newF.deleteFace (f);
-        newF.addFace (e12, e13, i1);
+    };
 
-        if (v2 < v3)
-        {
-          newF.addFace (i2, i3, e13);
-          newF.addFace (i2, e13, e12);
-        }
-        else
-        {
-          newF.addFace (i3, e12, i2);
-          newF.addFace (i3, e13, e12);
-        }
-      }
-      else if (e12 != invalid && e13 == invalid && e23 != invalid)
-      {
-        newF.deleteFace (f);
-        newF.addFace (e23, e12, i2);
+    std::vector<unsigned int> domain;
+    mesh.forEachFaceExt (faces, [&domain](unsigned int f) { domain.push_back (f); });
 
-        if (v1 < v3)
-        {
-          newF.addFace (i1, e23, i3);
-          newF.addFace (i1, e12, e23);
-        }
-        else
+    std::vector<FaceSplit> splits (domain.size ());
+
+    Parallel::forRange (
+      domain.size (), parallelGrainSize,
+      [&mesh, &newE, &domain, &splits](unsigned int begin, unsigned int end) {
+        for (unsigned int i = begin; i < end; i++)
         {
-          newF.addFace (i3, i1, e12);
-          newF.addFace (i3, e12, e23);
+          FaceSplit& split = splits[i];
+          split.numFaces = 0;
+
+          unsigned int i1, i2, i3;
+          mesh.vertexIndices (domain[i], i1, i2, i3);
+
+          const unsigned int e12 = newE.find (i1, i2);
+          const unsigned int e13 = newE.find (i1, i3);
+          const unsigned int e23 = newE.find (i2, i3);
+          const unsigned int invalid = Util::invalidIndex ();
+
+          const unsigned int v1 = mesh.valence (i1);
+          const unsigned int v2 = mesh.valence (i2);
+          const unsigned int v3 = mesh.valence (i3);
+
+          if (e12 == invalid && e13 == invalid && e23 == invalid)
+          {
+          }
+          // One new vertex
+          else if (e12 != invalid && e13 == invalid && e23 == invalid)
+          {
+            split.addFace (i1, e12, i3);
+            split.addFace (i3, e12, i2);
+          }
+          else if (e12 == invalid && e13 != invalid && e23 == invalid)
+          {
+            split.addFace (i3, e13, i2);
+            split.addFace (i2, e13, i1);
+          }
+          else if (e12 == invalid && e13 == invalid && e23 != invalid)
+          {
+            split.addFace (i2, e23, i1);
+            split.addFace (i1, e23, i3);
+          }
+          // Two new vertices
+          else if (e12 != invalid && e13 != invalid && e23 == invalid)
+          {
+            split.addFace (e12, e13, i1);
+
+            if (v2 < v3)
+            {
+              split.addFace (i2, i3, e13);
+              split.addFace (i2, e13, e12);
+            }
+            else
+            {
+              split.addFace (i3, e12, i2);
+              split.addFace (i3, e13, e12);
+            }
+          }
+          else if (e12 != invalid && e13 == invalid && e23 != invalid)
+          {
+            split.addFace (e23, e12, i2);
+
+            if (v1 < v3)
+            {
+              split.addFace (i1, e23, i3);
+              split.addFace (i1, e12, e23);
+            }
+            else
+            {
+              split.addFace (i3, i1, e12);
+              split.addFace (i3, e12, e23);
+            }
+          }
+          else if (e12 == invalid && e13 != invalid && e23 != invalid)
+          {
+            split.addFace (e13, e23, i3);
+
+            if (v1 < v2)
+            {
+              split.addFace (i1, i2, e23);
+              split.addFace (i1, e23, e13);
+            }
+            else
+            {
+              split.addFace (i2, e13, i1);
+              split.addFace (i2, e23, e13);
+            }
+          }
+          // Three new vertices
+          else if (e12 != invalid && e13 != invalid && e23 != invalid)
+          {
+            split.addFace (e12, e23, e13);
+            split.addFace (i1, e12, e13);
+            split.addFace (i2, e23, e12);
+            split.addFace (i3, e13, e23);
+          }
+          else
+          {
+            DILAY_IMPOSSIBLE
+          }
         }
-      }
-      else if (e12 == invalid && e13 != invalid && e23 != invalid)
+      });
+
+    NewFaces newF;
+    for (unsigned int i = 0; i < domain.size (); i++)
+    {
+      if (splits[i].numFaces > 0)
       {
-        newF.deleteFace (f);
-        newF.addFace (e13, e23, i3);
+        newF.deleteFace (domain[i]);
 
-        if (v1 < v2)
+        for (unsigned int j = 0; j < splits[i].numFaces; j++)
         {
-          newF.addFace (i1, i2, e23);
-          newF.addFace (i1, e23, e13);
+          newF.addFace (splits[i].vertexIndices[(3 * j) + 0], splits[i].vertexIndices[(3 * j) + 1],
+                        splits[i].vertexIndices[(3 * j) + 2]);
         }
-        else
-        {
-          newF.addFace (i2, e13, i1);
-          newF.addFace (i2, e23, e13);
-        }
-      }
-      // Three new vertices
-      else if (e12 != invalid && e13 != invalid && e23 != invalid)
-      {
-        newF.deleteFace (f);
-        newF.addFace (e12, e23, e13);
-        newF.addFace (i1, e12, e13);
-        newF.addFace (i2, e23, e12);
-        newF.addFace (i3, e13, e23);
-      }
-      else
-      {
-        DILAY_IMPOSSIBLE
       }
-    });
+    }
     const bool increasing = newF.applyToMesh (mesh, faces);
     assert (increasing);
     unused (increasing);
@@ -382,9 +451,7 @@ namespace
 
   void smooth (DynamicMesh& mesh, DynamicFaces& faces)
   {
-    std::unordered_map<unsigned int, glm::vec3> newPosition;
-
-    mesh.forEachVertex (faces, [&mesh, &newPosition](unsigned int i) {
+    const auto smoothPosition = [&mesh](unsigned int i) -> glm::vec3 {
       const glm::vec3  avgPos = mesh.averagePosition (i);
       const glm::vec3& normal = mesh.vertexNormal (i);
       const glm::vec3  delta = avgPos - mesh.vertex (i);
@@ -428,17 +495,31 @@ namespace
       }
       if (minDistance != Util::maxFloat ())
       {
-        newPosition.emplace (i, projectedPos);
+        return projectedPos;
       }
       else
       {
-        newPosition.emplace (i, tangentialPos);
+        return tangentialPos;
       }
-    });
+    };
+
+    std::vector<unsigned int> indices;
+    mesh.forEachVertex (faces, [&indices](unsigned int i) { indices.push_back (i); });
 
-    for (const auto& it : newPosition)
+    std::vector<glm::vec3> newPositions (indices.size ());
+
+    Parallel::forRange (indices.size (), parallelGrainSize,
+                        [&indices, &newPositions, &smoothPosition](unsigned int begin,
+                                                                   unsigned int end) {
+                          for (unsigned int i = begin; i < end; i++)
+                          {
+                            newPositions[i] = smoothPosition (indices[i]);
+                          }
+                        });
+
+    for (unsigned int i = 0; i < indices.size (); i++)
     {
-      mesh.vertex (it.first, it.second);
+      mesh.vertex (indices[i], newPositions[i]);
     }
   }
 
@@ -447,9 +528,11 @@ namespace
     assert (mesh.isFreeVertex (i) == false);
     assert (mesh.valence (i) == 3);
 
-    const unsigned int adj1 = mesh.adjacentFaces (i)[0];
-    const unsigned int adj2 = mesh.adjacentFaces (i)[1];
-    const unsigned int adj3 = mesh.adjacentFaces (i)[2];
+    DynamicMesh::AdjacentFaces::Iterator adjacent = mesh.adjacentFaces (i).begin ();
+
+    const unsigned int adj1 = *adjacent;
+    const unsigned int adj2 = *(++adjacent);
+    const unsigned int adj3 = *(++adjacent);
 
     unsigned int adj11, adj12, adj13;
     mesh.vertexIndices (adj1, adj11, adj12, adj13);
@@ -516,7 +599,7 @@ namespace
     }
   };
 
-  bool collapseEdge (DynamicMesh& mesh, unsigned int i1, unsigned int i2, DynamicFaces faces)
+  bool collapseEdge (DynamicMesh& mesh, unsigned int i1, unsigned int i2, DynamicFaces& faces)
   {
     const unsigned int v1 = mesh.valence (i1);
     const unsigned int v2 = mesh.valence (i2);
@@ -747,12 +830,8 @@ namespace
 
   void finalize (DynamicMesh& mesh, const DynamicFaces& faces)
   {
-    mesh.forEachVertex (faces, [&mesh](unsigned int i) { mesh.setVertexNormal (i); });
-
-    for (unsigned int i : faces)
-    {
-      mesh.realignFace (i);
-    }
+    mesh.setVertexNormals (faces);
+    mesh.realignFaces (faces);
   }
 }
 
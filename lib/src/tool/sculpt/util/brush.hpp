@@ -30,6 +30,8 @@ public:
 
   virtual bool reduce () const { return false; }
 
+  virtual bool useRecentMesh () const { return false; }
+
   virtual void mirror (const PrimPlane&) {}
 
   virtual void sculpt (const SculptBrush&, const DynamicFaces&) const = 0;
@@ -81,10 +83,13 @@ class SBDrawParameters : public SBIntensityParameter, public SBInvertParameter
 public:
   SBDrawParameters ()
     : _flat (true)
+    , _constantHeight (false)
   {
   }
 
-  void sculpt (const SculptBrush&, const DynamicFaces&) const;
+  void sculpt (const SculptBrush&, const DynamicFaces&) const override;
+
+  bool useRecentMesh () const override { return this->_constantHeight; }
 
   MEMBER_GETTER_SETTER (bool, flat);
   MEMBER_GETTER_SETTER (bool, constantHeight);
@@ -141,7 +146,9 @@ private:
 class SBCreaseParameters : public SBIntensityParameter, public SBInvertParameter
 {
 public:
-  void sculpt (const SculptBrush&, const DynamicFaces&) const;
+  void sculpt (const SculptBrush&, const DynamicFaces&) const override;
+
+  bool useRecentMesh () const override { return true; }
 };
 
 class SBPinchParameters : public SBInvertParameter
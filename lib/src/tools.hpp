@@ -35,7 +35,9 @@ DECLARE_TOOL (ToolDeleteSketch, DECLARE_TOOL_RUN_RELEASE_EVENT)
 
 DECLARE_TOOL (ToolRebalanceSketch, DECLARE_TOOL_RUN_RELEASE_EVENT DECLARE_TOOL_RUN_COMMIT)
 
-DECLARE_TOOL (ToolConvertSketch, DECLARE_TOOL_RUN_RELEASE_EVENT)
+DECLARE_TOOL (ToolConvertSketch,
+              DECLARE_TOOL_RUN_RENDER DECLARE_TOOL_RUN_MOVE_EVENT DECLARE_TOOL_RUN_RELEASE_EVENT
+                DECLARE_TOOL_RUN_COMMIT)
 
 DECLARE_TOOL (ToolSketchSpheres,
               DECLARE_TOOL_RUN_RENDER DECLARE_TOOL_RUN_MOVE_EVENT DECLARE_TOOL_RUN_PRESS_EVENT
@@ -214,6 +214,8 @@ namespace
     ViewTwoColumnGrid* grid = new ViewTwoColumnGrid;
 
     addIntEdit (data, *grid, "editor/undo-depth", QObject::tr ("Undo depth"), 1, Util::maxInt ());
+    addIntEdit (data, *grid, "editor/autosave-interval",
+                QObject::tr ("Autosave interval (seconds, 0 disables autosave)"), 0, 24 * 60 * 60);
     addIntEdit (data, *grid, "window/initial-width", QObject::tr ("Initial window width"), 1,
                 Util::maxInt ());
     addIntEdit (data, *grid, "window/initial-height", QObject::tr ("Initial window height"), 1,
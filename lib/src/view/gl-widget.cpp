@@ -3,9 +3,17 @@
  * Use and redistribute under the terms of the GNU General Public License
  */
 #include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QGuiApplication>
 #include <QMouseEvent>
 #include <QPainter>
+#include <QStandardPaths>
+#include <QTimer>
+#include <algorithm>
 #include <glm/glm.hpp>
+#include <vector>
+#include "autosave.hpp"
 #include "camera.hpp"
 #include "config.hpp"
 #include "mesh-util.hpp"
@@ -16,6 +24,7 @@
 #include "state.hpp"
 #include "tool.hpp"
 #include "tool/move-camera.hpp"
+#include "util.hpp"
 #include "view/axis.hpp"
 #include "view/floor-plane.hpp"
 #include "view/gl-widget.hpp"
@@ -26,21 +35,74 @@
 #include "view/tool-pane.hpp"
 #include "view/util.hpp"
 
+namespace
+{
+  std::string autosaveFileName ()
+  {
+    const QDir dataDir (QStandardPaths::writableLocation (QStandardPaths::AppDataLocation));
+
+    if (dataDir.exists () == false)
+    {
+      dataDir.mkpath (".");
+    }
+    return dataDir.filePath ("autosave.dlyz").toStdString ();
+  }
+
+  // a frame that has not been swapped after this time (e.g. the widget is hidden) is ignored
+  constexpr qint64 maxFrameWait = 100;
+
+  // input-to-frame latencies of the current stroke, logged once it has been finished
+  struct LatencyCounters
+  {
+    unsigned int numSamples;
+    unsigned int numFrames;
+    qint64       totalLatency;
+    qint64       maxLatency;
+
+    LatencyCounters () { this->reset (); }
+    void reset ()
+    {
+      this->numSamples = 0;
+      this->numFrames = 0;
+      this->totalLatency = 0;
+      this->maxLatency = 0;
+    }
+
+    void addFrame (qint64 latency)
+    {
+      this->numFrames++;
+      this->totalLatency += latency;
+      this->maxLatency = std::max (this->maxLatency, latency);
+    }
+  };
+}
+
 struct ViewGlWidget::Impl
 {
   typedef std::unique_ptr<State>          StatePtr;
   typedef std::unique_ptr<ViewAxis>       AxisPtr;
   typedef std::unique_ptr<ViewFloorPlane> FloorPlanePtr;
 
-  ViewGlWidget*   self;
-  ViewMainWindow& mainWindow;
-  Config&         config;
-  Cache&          cache;
-  ToolMoveCamera  toolMoveCamera;
-  StatePtr        _state;
-  AxisPtr         axis;
-  FloorPlanePtr   _floorPlane;
-  bool            tabletPressed;
+  ViewGlWidget*                  self;
+  ViewMainWindow&                mainWindow;
+  Config&                        config;
+  Cache&                         cache;
+  ToolMoveCamera                 toolMoveCamera;
+  StatePtr                       _state;
+  AxisPtr                        axis;
+  FloorPlanePtr                  _floorPlane;
+  bool                           tabletPressed;
+  Autosave                       autosave;
+  QTimer                         autosaveTimer;
+  bool                           autosavePending;
+  QElapsedTimer                  clock;
+  std::vector<ViewPointingEvent> pendingEvents;
+  qint64                         pendingSince;
+  bool                           isFlushRequested;
+  bool                           isFrameInFlight;
+  qint64                         frameInputTime;
+  qint64                         frameRequestTime;
+  LatencyCounters                latency;
 
   Impl (ViewGlWidget* s, ViewMainWindow& mW, Config& cfg, Cache& cch)
     : self (s)
@@ -52,12 +114,27 @@ struct ViewGlWidget::Impl
     , axis (nullptr)
     , _floorPlane (nullptr)
     , tabletPressed (false)
+    , autosave (autosaveFileName ())
+    , autosavePending (false)
+    , pendingSince (0)
+    , isFlushRequested (false)
+    , isFrameInFlight (false)
+    , frameInputTime (0)
+    , frameRequestTime (0)
   {
     this->self->setAutoFillBackground (false);
+    this->clock.start ();
+
+    QObject::connect (&this->autosaveTimer, &QTimer::timeout, [this]() { this->runAutosave (); });
+    QObject::connect (this->self, &QOpenGLWidget::frameSwapped,
+                      [this]() { this->frameSwapped (); });
   }
 
   ~Impl ()
   {
+    this->autosaveTimer.stop ();
+    this->autosave.remove ();
+
     this->self->makeCurrent ();
 
     this->_state.reset (nullptr);
@@ -95,6 +172,39 @@ struct ViewGlWidget::Impl
     this->floorPlane ().update (this->state ().camera ());
 
     this->toolMoveCamera.fromConfig (this->config);
+    this->updateAutosaveInterval ();
+  }
+
+  void updateAutosaveInterval ()
+  {
+    const int interval = this->config.get<int> ("editor/autosave-interval");
+
+    if (interval > 0 && this->autosave.isEnabled ())
+    {
+      if (this->autosaveTimer.interval () != 1000 * interval ||
+          this->autosaveTimer.isActive () == false)
+      {
+        this->autosaveTimer.start (1000 * interval);
+      }
+    }
+    else
+    {
+      this->autosaveTimer.stop ();
+    }
+  }
+
+  // captures the scene unless a stroke is in progress, which is saved once it has been finished
+  void runAutosave ()
+  {
+    if (this->tabletPressed || QGuiApplication::mouseButtons () != Qt::NoButton)
+    {
+      this->autosavePending = true;
+    }
+    else
+    {
+      this->autosavePending = false;
+      this->autosave.save (this->state ().scene ());
+    }
   }
 
   void initializeGL ()
@@ -109,24 +219,55 @@ struct ViewGlWidget::Impl
     this->self->setTabletTracking (true);
     this->initializeScene ();
     this->mainWindow.toolPane ().forceWidth ();
+    this->updateAutosaveInterval ();
   }
 
+  /* Recovery is offered even if a file is given on the command line, because the next autosave
+   * would overwrite the autosaved scene otherwise.
+   */
   void initializeScene ()
   {
-    const QStringList arguments = QCoreApplication::arguments ();
-    if (arguments.size () > 1)
+    if (this->recoverAutosave () == false)
     {
-      const std::string fileName = arguments.at (1).toStdString ();
-      if (this->state ().scene ().fromDlyFile (this->state ().config (), fileName) == false)
+      const QStringList arguments = QCoreApplication::arguments ();
+      if (arguments.size () > 1)
       {
-        ViewUtil::error (this->mainWindow, QObject::tr ("Could not open file."));
+        const std::string fileName = arguments.at (1).toStdString ();
+        if (this->state ().scene ().fromDlyFile (this->state ().config (), fileName) == false)
+        {
+          ViewUtil::error (this->mainWindow, QObject::tr ("Could not open file."));
+        }
+      }
+      else
+      {
+        this->state ().scene ().newDynamicMesh (this->config, MeshUtil::icosphere (4));
       }
     }
-    else
+    this->mainWindow.infoPane ().scene ().updateInfo ();
+  }
+
+  bool recoverAutosave ()
+  {
+    if (this->autosave.hasFile () == false)
     {
-      this->state ().scene ().newDynamicMesh (this->config, MeshUtil::icosphere (4));
+      return false;
     }
-    this->mainWindow.infoPane ().scene ().updateInfo ();
+    else if (ViewUtil::question (this->mainWindow,
+                                 QObject::tr ("Dilay has not been closed properly. "
+                                              "Do you want to recover the autosaved scene?")))
+    {
+      if (this->autosave.recover (this->config, this->state ().scene ()))
+      {
+        return true;
+      }
+      else
+      {
+        ViewUtil::error (this->mainWindow, QObject::tr ("Could not recover autosaved scene."));
+        this->state ().scene ().reset ();
+      }
+    }
+    this->autosave.remove ();
+    return false;
   }
 
   void paintGL ()
@@ -177,11 +318,100 @@ struct ViewGlWidget::Impl
     }
   }
 
+  /* Move events are coalesced: all samples that arrive until the next frame are handled at once,
+   * so that edited meshes are buffered and rendered only once per frame.  Other events flush
+   * pending samples first to keep their order, as do changes of the state that are not caused by
+   * pointing events (e.g. undo, switching tools, menu actions).
+   */
+  void queuePointingEvent (const ViewPointingEvent& e)
+  {
+    if (e.valid () && e.moveEvent ())
+    {
+      if (this->pendingEvents.empty ())
+      {
+        this->pendingSince = this->clock.elapsed ();
+      }
+      this->pendingEvents.push_back (e);
+      this->requestFlush ();
+    }
+    else
+    {
+      this->flushPointingEvents ();
+      this->pointingEvent (e);
+
+      if (e.releaseEvent ())
+      {
+        this->logLatency ();
+      }
+    }
+  }
+
+  void requestFlush ()
+  {
+    if (this->isFrameInFlight && this->clock.elapsed () - this->frameRequestTime > maxFrameWait)
+    {
+      this->isFrameInFlight = false;
+    }
+
+    if (this->isFlushRequested == false && this->isFrameInFlight == false)
+    {
+      this->isFlushRequested = true;
+      QTimer::singleShot (0, this->self, [this]() { this->flushPointingEvents (); });
+    }
+  }
+
+  void flushPointingEvents ()
+  {
+    this->isFlushRequested = false;
+
+    if (this->pendingEvents.empty () == false)
+    {
+      std::vector<ViewPointingEvent> events;
+      events.swap (this->pendingEvents);
+
+      for (const ViewPointingEvent& e : events)
+      {
+        this->pointingEvent (e);
+      }
+      this->latency.numSamples += events.size ();
+      this->frameInputTime = this->pendingSince;
+      this->frameRequestTime = this->clock.elapsed ();
+      this->isFrameInFlight = true;
+      this->self->update ();
+    }
+  }
+
+  // paces the handling of move events to the frame rate, i.e. to the display's refresh rate
+  void frameSwapped ()
+  {
+    if (this->isFrameInFlight)
+    {
+      this->isFrameInFlight = false;
+      this->latency.addFrame (this->clock.elapsed () - this->frameInputTime);
+    }
+    if (this->pendingEvents.empty () == false)
+    {
+      this->requestFlush ();
+    }
+  }
+
+  void logLatency ()
+  {
+    if (this->latency.numFrames > 0)
+    {
+      DILAY_INFO ("Stroke: %u samples in %u frames, latency: %.1f ms average, %lld ms maximum",
+                  this->latency.numSamples, this->latency.numFrames,
+                  float(this->latency.totalLatency) / float(this->latency.numFrames),
+                  static_cast<long long> (this->latency.maxLatency));
+    }
+    this->latency.reset ();
+  }
+
   void mouseMoveEvent (QMouseEvent* e)
   {
     if (this->tabletPressed == false)
     {
-      this->pointingEvent (ViewPointingEvent (*e));
+      this->queuePointingEvent (ViewPointingEvent (*e));
     }
   }
 
@@ -189,7 +419,7 @@ struct ViewGlWidget::Impl
   {
     if (this->tabletPressed == false)
     {
-      this->pointingEvent (ViewPointingEvent (*e));
+      this->queuePointingEvent (ViewPointingEvent (*e));
     }
   }
 
@@ -197,12 +427,18 @@ struct ViewGlWidget::Impl
   {
     if (this->tabletPressed == false)
     {
-      this->pointingEvent (ViewPointingEvent (*e));
+      this->queuePointingEvent (ViewPointingEvent (*e));
+    }
+    if (this->autosavePending)
+    {
+      this->runAutosave ();
     }
   }
 
   void wheelEvent (QWheelEvent* e)
   {
+    this->flushPointingEvents ();
+
     if (e->modifiers () == Qt::NoModifier)
     {
       this->toolMoveCamera.wheelEvent (this->state (), *e);
@@ -226,7 +462,12 @@ struct ViewGlWidget::Impl
     {
       this->tabletPressed = false;
     }
-    this->pointingEvent (pointingEvent);
+    this->queuePointingEvent (pointingEvent);
+
+    if (this->autosavePending && this->tabletPressed == false)
+    {
+      this->runAutosave ();
+    }
   }
 
   void updateCursorInTool ()
@@ -245,6 +486,7 @@ DELEGATE (State&, ViewGlWidget, state)
 DELEGATE (ViewFloorPlane&, ViewGlWidget, floorPlane)
 DELEGATE (glm::ivec2, ViewGlWidget, cursorPosition)
 DELEGATE (void, ViewGlWidget, fromConfig)
+DELEGATE (void, ViewGlWidget, flushPointingEvents)
 DELEGATE (void, ViewGlWidget, initializeGL)
 DELEGATE2 (void, ViewGlWidget, resizeGL, int, int)
 DELEGATE (void, ViewGlWidget, paintGL)
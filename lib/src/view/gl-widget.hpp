@@ -27,6 +27,7 @@ public:
   ViewFloorPlane& floorPlane ();
   glm::ivec2      cursorPosition ();
   void            fromConfig ();
+  void            flushPointingEvents ();
 
 protected:
   void initializeGL ();
@@ -22,25 +22,33 @@
 
 namespace
 {
-  QAction& addAction (QMenu& menu, const QString& label, const QKeySequence& keySequence,
-                      const std::function<void()>& f)
+  // pending pointing events are handled before an action, i.e. in the state they were queued in
+  QAction& addAction (ViewGlWidget& glWidget, QMenu& menu, const QString& label,
+                      const QKeySequence& keySequence, const std::function<void()>& f)
   {
     QAction* a = new QAction (label, &menu);
     a->setShortcut (keySequence);
     menu.addAction (a);
-    QObject::connect (a, &QAction::triggered, f);
+    QObject::connect (a, &QAction::triggered, [&glWidget, f]() {
+      glWidget.flushPointingEvents ();
+      f ();
+    });
     return *a;
   }
 
-  QAction& addCheckableAction (QMenu& menu, const QString& label, const QKeySequence& keySequence,
-                               bool state, const std::function<void(bool)>& f)
+  QAction& addCheckableAction (ViewGlWidget& glWidget, QMenu& menu, const QString& label,
+                               const QKeySequence& keySequence, bool state,
+                               const std::function<void(bool)>& f)
   {
     QAction* a = new QAction (label, &menu);
     a->setShortcut (keySequence);
     a->setCheckable (true);
     a->setChecked (state);
     menu.addAction (a);
-    QObject::connect (a, &QAction::toggled, f);
+    QObject::connect (a, &QAction::toggled, [&glWidget, f](bool checked) {
+      glWidget.flushPointingEvents ();
+      f (checked);
+    });
     return *a;
   }
 
@@ -55,24 +63,28 @@ namespace
 
   QString filterDlyFiles () { return QObject::tr ("Dilay files (*.dly)"); }
 
+  QString filterDlyTextFiles () { return QObject::tr ("Dilay text files (*.dly)"); }
+
   QString filterObjFiles () { return QObject::tr ("Wavefront files (*.obj)"); }
 
   QString fileDialogFilters ()
   {
-    return filterAllFiles () + ";;" + filterDlyFiles () + ";;" + filterObjFiles ();
+    return filterAllFiles () + ";;" + filterDlyFiles () + ";;" + filterDlyTextFiles () + ";;" +
+           filterObjFiles ();
   }
 
   QString selectedFilter (const Scene& scene)
   {
     if (scene.hasFileName ())
     {
-      if (Util::hasSuffix (scene.fileName (), ".dly"))
-      {
-        return filterDlyFiles ();
-      }
-      else if (Util::hasSuffix (scene.fileName (), ".obj"))
+      switch (scene.fileFormat ())
       {
-        return filterObjFiles ();
+        case ImportExport::Format::Dly:
+          return filterDlyTextFiles ();
+        case ImportExport::Format::BinaryDly:
+          return filterDlyFiles ();
+        case ImportExport::Format::Obj:
+          return filterObjFiles ();
       }
     }
     return filterAllFiles ();
@@ -87,40 +99,43 @@ void ViewMenuBar::setup (ViewMainWindow& mainWindow, ViewGlWidget& glWidget)
   QMenu&    viewMenu = *menuBar.addMenu (QObject::tr ("&View"));
   QMenu&    helpMenu = *menuBar.addMenu (QObject::tr ("&Help"));
 
-  addAction (fileMenu, QObject::tr ("&Open..."), QKeySequence::Open, [&mainWindow, &glWidget]() {
-    Scene&            scene = glWidget.state ().scene ();
-    QString           filter = filterAllFiles ();
-    const std::string fileName =
-      QFileDialog::getOpenFileName (&mainWindow, QObject::tr ("Open"), getFileDialogPath (scene),
-                                    fileDialogFilters (), &filter, QFileDialog::DontUseNativeDialog)
-        .toStdString ();
-    if (fileName.empty () == false)
-    {
+  addAction (
+    glWidget, fileMenu, QObject::tr ("&Open..."), QKeySequence::Open, [&mainWindow, &glWidget]() {
+      Scene&            scene = glWidget.state ().scene ();
+      QString           filter = filterAllFiles ();
+      const std::string fileName =
+        QFileDialog::getOpenFileName (&mainWindow, QObject::tr ("Open"),
+                                      getFileDialogPath (scene), fileDialogFilters (), &filter,
+                                      QFileDialog::DontUseNativeDialog)
+          .toStdString ();
+      if (fileName.empty () == false)
+      {
 #ifndef NDEBUG
-      scene.reset ();
-      glWidget.state ().history ().reset ();
+        scene.reset ();
+        glWidget.state ().history ().reset ();
 #else
-      if (scene.isEmpty () == false) {
-        if (ViewUtil::question (mainWindow, QObject::tr ("Replace existent scene?"))) {
-          scene.reset ();
-          glWidget.state ().history ().reset ();
-        }
-        else {
-          glWidget.state ().history ().snapshotAll (scene);
+        if (scene.isEmpty () == false) {
+          if (ViewUtil::question (mainWindow, QObject::tr ("Replace existent scene?"))) {
+            scene.reset ();
+            glWidget.state ().history ().reset ();
+          }
+          else {
+            glWidget.state ().history ().snapshotAll (scene);
+          }
         }
-      }
 #endif
-      if (scene.fromDlyFile (glWidget.state ().config (), fileName) == false)
-      {
-        ViewUtil::error (mainWindow, QObject::tr ("Could not open file."));
+        if (scene.fromDlyFile (glWidget.state ().config (), fileName) == false)
+        {
+          ViewUtil::error (mainWindow, QObject::tr ("Could not open file."));
+        }
+        mainWindow.infoPane ().scene ().updateInfo ();
+        mainWindow.update ();
       }
-      mainWindow.infoPane ().scene ().updateInfo ();
-      mainWindow.update ();
-    }
-  });
+    });
 
   QAction& saveAsAction = addAction (
-    fileMenu, QObject::tr ("Save &as..."), QKeySequence::SaveAs, [&mainWindow, &glWidget]() {
+    glWidget, fileMenu, QObject::tr ("Save &as..."), QKeySequence::SaveAs,
+    [&mainWindow, &glWidget]() {
       Scene&            scene = glWidget.state ().scene ();
       QString           filter = selectedFilter (scene);
       const std::string fileName =
@@ -130,13 +145,22 @@ void ViewMenuBar::setup (ViewMainWindow& mainWindow, ViewGlWidget& glWidget)
           .toStdString ();
       if (fileName.empty () == false)
       {
-        const bool saveAsObj = Util::hasSuffix (fileName, ".obj") || filter == filterObjFiles ();
+        ImportExport::Format format = ImportExport::Format::BinaryDly;
 
-        if (scene.toDlyFile (fileName, saveAsObj) == false)
+        if (Util::hasSuffix (fileName, ".obj") || filter == filterObjFiles ())
+        {
+          format = ImportExport::Format::Obj;
+        }
+        else if (filter == filterDlyTextFiles ())
+        {
+          format = ImportExport::Format::Dly;
+        }
+
+        if (scene.toDlyFile (fileName, format) == false)
         {
           ViewUtil::error (mainWindow, QObject::tr ("Could not save to file."));
         }
-        else if (saveAsObj && scene.numSketchMeshes () > 0)
+        else if (format == ImportExport::Format::Obj && scene.numSketchMeshes () > 0)
         {
           ViewUtil::info (mainWindow,
                           QObject::tr ("Sketches are omitted when saving Wavefront files."));
@@ -144,14 +168,12 @@ void ViewMenuBar::setup (ViewMainWindow& mainWindow, ViewGlWidget& glWidget)
       }
     });
 
-  addAction (fileMenu, QObject::tr ("&Save"), QKeySequence::Save,
+  addAction (glWidget, fileMenu, QObject::tr ("&Save"), QKeySequence::Save,
              [&mainWindow, &glWidget, &saveAsAction]() {
                Scene& scene = glWidget.state ().scene ();
                if (scene.hasFileName ())
                {
-                 const bool saveAsObj = Util::hasSuffix (scene.fileName (), ".obj");
-
-                 if (scene.toDlyFile (saveAsObj) == false)
+                 if (scene.toDlyFile () == false)
                  {
                    ViewUtil::error (mainWindow, QObject::tr ("Could not save to file."));
                  }
@@ -164,16 +186,16 @@ void ViewMenuBar::setup (ViewMainWindow& mainWindow, ViewGlWidget& glWidget)
 
   fileMenu.addSeparator ();
 
-  addAction (fileMenu, QObject::tr ("&Quit"), QKeySequence::Quit,
+  addAction (glWidget, fileMenu, QObject::tr ("&Quit"), QKeySequence::Quit,
              [&mainWindow]() { mainWindow.close (); });
-  addAction (editMenu, QObject::tr ("&Undo"), QKeySequence::Undo,
+  addAction (glWidget, editMenu, QObject::tr ("&Undo"), QKeySequence::Undo,
              [&glWidget]() { glWidget.state ().undo (); });
-  addAction (editMenu, QObject::tr ("&Redo"), QKeySequence::Redo,
+  addAction (glWidget, editMenu, QObject::tr ("&Redo"), QKeySequence::Redo,
              [&glWidget]() { glWidget.state ().redo (); });
-  addAction (editMenu, QObject::tr ("&Configuration..."), QKeySequence (),
+  addAction (glWidget, editMenu, QObject::tr ("&Configuration..."), QKeySequence (),
              [&mainWindow, &glWidget]() { ViewConfiguration::show (mainWindow, glWidget); });
 
-  addAction (viewMenu, QObject::tr ("Toggle &info pane"), Qt::Key_I, [&mainWindow]() {
+  addAction (glWidget, viewMenu, QObject::tr ("Toggle &info pane"), Qt::Key_I, [&mainWindow]() {
     if (mainWindow.infoPane ().isVisible ())
     {
       mainWindow.infoPane ().close ();
@@ -186,44 +208,45 @@ void ViewMenuBar::setup (ViewMainWindow& mainWindow, ViewGlWidget& glWidget)
 
   viewMenu.addSeparator ();
 
-  addAction (viewMenu, QObject::tr ("&Snap camera"), Qt::SHIFT + Qt::Key_C,
+  addAction (glWidget, viewMenu, QObject::tr ("&Snap camera"), Qt::SHIFT + Qt::Key_C,
              [&glWidget]() { glWidget.toolMoveCamera ().snap (glWidget.state (), false); });
-  addAction (viewMenu, QObject::tr ("Reset &gaze point"), Qt::ALT + Qt::Key_C,
+  addAction (glWidget, viewMenu, QObject::tr ("Reset &gaze point"), Qt::ALT + Qt::Key_C,
              [&glWidget]() { glWidget.toolMoveCamera ().resetGazePoint (glWidget.state ()); });
 
   viewMenu.addSeparator ();
 
-  addAction (viewMenu, QObject::tr ("Toggle &wireframe"), Qt::Key_W, [&mainWindow, &glWidget]() {
-    glWidget.state ().scene ().toggleWireframe ();
-    mainWindow.update ();
-  });
+  addAction (glWidget, viewMenu, QObject::tr ("Toggle &wireframe"), Qt::Key_W,
+             [&mainWindow, &glWidget]() {
+               glWidget.state ().scene ().toggleWireframe ();
+               mainWindow.update ();
+             });
 
-  addAction (viewMenu, QObject::tr ("Toggle &shading"), Qt::SHIFT + Qt::Key_W,
+  addAction (glWidget, viewMenu, QObject::tr ("Toggle &shading"), Qt::SHIFT + Qt::Key_W,
              [&mainWindow, &glWidget]() {
                glWidget.state ().scene ().toggleShading ();
                mainWindow.update ();
              });
 
-  addCheckableAction (viewMenu, QObject::tr ("Show &floor plane"), QKeySequence (), false,
-                      [&mainWindow, &glWidget](bool a) {
+  addCheckableAction (glWidget, viewMenu, QObject::tr ("Show &floor plane"), QKeySequence (),
+                      false, [&mainWindow, &glWidget](bool a) {
                         glWidget.floorPlane ().isActive (a);
                         mainWindow.update ();
                       });
 
-  addAction (helpMenu, QObject::tr ("&Manual..."), QKeySequence (), [&mainWindow]() {
+  addAction (glWidget, helpMenu, QObject::tr ("&Manual..."), QKeySequence (), [&mainWindow]() {
     if (QDesktopServices::openUrl (QUrl ("http://abau.org/dilay/manual.html")) == false)
     {
       ViewUtil::error (mainWindow, QObject::tr ("Could not open manual."));
     }
   });
 
-  addAction (helpMenu, QObject::tr ("&View log..."), QKeySequence (),
+  addAction (glWidget, helpMenu, QObject::tr ("&View log..."), QKeySequence (),
              [&mainWindow]() { ViewLog::show (mainWindow); });
 
-  addAction (helpMenu, QObject::tr ("&Thanks..."), QKeySequence (),
+  addAction (glWidget, helpMenu, QObject::tr ("&Thanks..."), QKeySequence (),
              []() { QDesktopServices::openUrl (QUrl ("http://abau.org/dilay/thanks.html")); });
 
-  addAction (helpMenu, QObject::tr ("&About Dilay..."), QKeySequence (), [&mainWindow]() {
+  addAction (glWidget, helpMenu, QObject::tr ("&About Dilay..."), QKeySequence (), [&mainWindow]() {
     ViewUtil::about (
       mainWindow,
       QString ("Dilay " DILAY_VERSION " - ") + QObject::tr ("a 3D sculpting application") +
@@ -5,11 +5,14 @@
 #include <QCoreApplication>
 #include <iostream>
 #include "test-bitset.hpp"
+#include "test-bvh.hpp"
 #include "test-distance.hpp"
+#include "test-import-export.hpp"
 #include "test-intersection.hpp"
 #include "test-maybe.hpp"
 #include "test-misc.hpp"
 #include "test-octree.hpp"
+#include "test-parallel.hpp"
 #include "test-prune.hpp"
 #include "test-tree.hpp"
 
@@ -23,11 +26,14 @@ int main ()
   TestMaybe::test3 ();
   TestOctree::test ();
   TestBitset::test ();
+  TestBvh::test ();
   TestTree::test1 ();
   TestTree::test2 ();
   TestMisc::test ();
   TestDistance::test ();
   TestPrune::test ();
+  TestParallel::test ();
+  TestImportExport::test ();
 
   std::cout << "all tests run successfully\n";
   return 0;
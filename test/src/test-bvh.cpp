@@ -0,0 +1,114 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2017 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#include <glm/glm.hpp>
+#include <random>
+#include <vector>
+#include "bvh.hpp"
+#include "intersection.hpp"
+#include "primitive/ray.hpp"
+#include "primitive/sphere.hpp"
+#include "test-bvh.hpp"
+
+namespace
+{
+  void checkClosestIntersections (Bvh& bvh, const std::vector<PrimSphere>& spheres,
+                                  std::default_random_engine& gen)
+  {
+    std::uniform_real_distribution<float> posD (-20.0f, 20.0f);
+
+    for (unsigned int i = 0; i < 100; i++)
+    {
+      const glm::vec3 origin (posD (gen), posD (gen), posD (gen));
+      const PrimRay   ray (origin, glm::normalize (glm::vec3 (posD (gen), posD (gen), posD (gen)) -
+                                                   origin));
+
+      bool  expected = false;
+      float expectedT = 0.0f;
+
+      for (const PrimSphere& s : spheres)
+      {
+        float t;
+        if (IntersectionUtil::intersects (ray, s, &t) && (expected == false || t < expectedT))
+        {
+          expected = true;
+          expectedT = t;
+        }
+      }
+
+      bool  found = false;
+      float foundT = 0.0f;
+
+      bvh.closestIntersection (ray, [&ray, &spheres, &found, &foundT](unsigned int e, float& t) {
+        if (IntersectionUtil::intersects (ray, spheres[e], &t))
+        {
+          if (found == false || t < foundT)
+          {
+            found = true;
+            foundT = t;
+          }
+          return true;
+        }
+        return false;
+      });
+
+      assert (found == expected);
+      assert (found == false || foundT == expectedT);
+    }
+  }
+}
+
+void TestBvh::test ()
+{
+  const unsigned int numSpheres = 500;
+
+  std::default_random_engine            gen;
+  std::uniform_real_distribution<float> posD (-10.0f, 10.0f);
+  std::uniform_real_distribution<float> radiusD (0.01f, 1.0f);
+
+  std::vector<PrimSphere> spheres;
+  Bvh                     bvh;
+
+  const auto addSphere = [&spheres, &bvh](const glm::vec3& center, float radius) {
+    spheres.emplace_back (center, radius);
+    bvh.addElement (center - glm::vec3 (radius), center + glm::vec3 (radius));
+  };
+
+  for (unsigned int i = 0; i < numSpheres; i++)
+  {
+    addSphere (glm::vec3 (posD (gen), posD (gen), posD (gen)), radiusD (gen));
+  }
+  // empty boxes are never intersected
+  bvh.addElement (glm::vec3 (1.0f), glm::vec3 (-1.0f));
+  spheres.emplace_back (glm::vec3 (1000.0f), 0.0f);
+
+  bvh.build ();
+  assert (bvh.numElements () == numSpheres + 1);
+  checkClosestIntersections (bvh, spheres, gen);
+
+  // refitting
+  for (unsigned int i = 0; i < numSpheres; i += 2)
+  {
+    const glm::vec3 center = spheres[i].center () + glm::vec3 (radiusD (gen));
+    spheres[i].center (center);
+    bvh.updateElement (i, center - glm::vec3 (spheres[i].radius ()),
+                       center + glm::vec3 (spheres[i].radius ()));
+  }
+  checkClosestIntersections (bvh, spheres, gen);
+
+  // rebuilding
+  for (unsigned int i = 0; i < numSpheres; i += 3)
+  {
+    const glm::vec3 center = 2.0f * glm::vec3 (posD (gen), posD (gen), posD (gen));
+    spheres[i].center (center);
+    bvh.updateElement (i, center - glm::vec3 (spheres[i].radius ()),
+                       center + glm::vec3 (spheres[i].radius ()));
+  }
+  checkClosestIntersections (bvh, spheres, gen);
+
+  bvh.reset ();
+  assert (bvh.numElements () == 0);
+  assert (bvh.closestIntersection (PrimRay (glm::vec3 (0.0f), glm::vec3 (0.0f, 0.0f, 1.0f)),
+                                   [](unsigned int, float&) { return true; }) == false);
+}
@@ -4,11 +4,57 @@
  */
 #include <glm/glm.hpp>
 #include <glm/gtc/epsilon.hpp>
+#include <vector>
 #include "distance.hpp"
+#include "primitive/cone-sphere.hpp"
 #include "primitive/cylinder.hpp"
+#include "primitive/sphere.hpp"
 #include "test-distance.hpp"
 #include "util.hpp"
 
+namespace
+{
+  template <typename T> void testKernels (const T& primitive)
+  {
+    std::vector<float> xs, ys, zs;
+
+    for (float x = -2.0f; x <= 2.0f; x += 0.25f)
+    {
+      for (float y = -2.0f; y <= 2.0f; y += 0.25f)
+      {
+        for (float z = -2.0f; z <= 2.0f; z += 0.25f)
+        {
+          xs.push_back (x);
+          ys.push_back (y);
+          zs.push_back (z);
+        }
+      }
+    }
+    // an odd number of points also covers the scalar remainder of SIMD kernels
+    assert (xs.size () % 2 == 1);
+
+    std::vector<float> results (xs.size ());
+
+    for (Distance::Kernel kernel :
+         {Distance::Kernel::Scalar, Distance::Kernel::SSE, Distance::Kernel::AVX2})
+    {
+      if (Distance::isSupported (kernel))
+      {
+        Distance::distances (primitive, xs.size (), xs.data (), ys.data (), zs.data (),
+                             results.data (), kernel);
+
+        for (unsigned int i = 0; i < xs.size (); i++)
+        {
+          const float d = Distance::distance (primitive, glm::vec3 (xs[i], ys[i], zs[i]));
+
+          assert (glm::epsilonEqual (results[i], d, Util::epsilon ()));
+          unused (d);
+        }
+      }
+    }
+  }
+}
+
 void TestDistance::test ()
 {
   using Distance::distance;
@@ -32,4 +78,15 @@ void TestDistance::test ()
   assert (glm::epsilonEqual (distance (cyl, glm::vec3 (2.0f, 2.0f, 0.0f)),
                              glm::sqrt ((1.5f * 1.5f) + (1.0f * 1.0f)), eps));
   unused (eps);
+
+  const PrimSphere sph1 (glm::vec3 (0.1f, -0.2f, 0.3f), 0.7f);
+  const PrimSphere sph2 (glm::vec3 (1.0f, 0.5f, -0.4f), 0.7f);
+  const PrimSphere sph3 (glm::vec3 (1.0f, 0.5f, -0.4f), 0.3f);
+  const PrimSphere sph4 (glm::vec3 (0.3f, -0.1f, 0.3f), 0.2f);
+
+  testKernels (sph1);
+  testKernels (PrimConeSphere (sph1, sph2));
+  testKernels (PrimConeSphere (sph1, sph3));
+  testKernels (PrimConeSphere (sph3, sph1));
+  testKernels (PrimConeSphere (sph1, sph4));
 }
@@ -0,0 +1,69 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2017 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include "import-export.hpp"
+#include "test-import-export.hpp"
+#include "util.hpp"
+
+namespace
+{
+  bool roundTrips (float value, int precision)
+  {
+    char buffer[128];
+    std::snprintf (buffer, sizeof (buffer), "%.*g", precision, double(value));
+
+    float parsed;
+    return ImportExport::parseFloat (buffer, parsed) &&
+           std::memcmp (&parsed, &value, sizeof (float)) == 0;
+  }
+
+  float parse (const std::string& string)
+  {
+    float      value;
+    const bool success = ImportExport::parseFloat (string, value);
+
+    assert (success);
+    unused (success);
+    return value;
+  }
+}
+
+void TestImportExport::test ()
+{
+  std::uint32_t bits = 12345;
+
+  for (unsigned int i = 0; i < 100000; i++)
+  {
+    bits = (1664525 * bits) + 1013904223;
+
+    float value;
+    std::memcpy (&value, &bits, sizeof (float));
+
+    if (value == value && value - value == 0.0f)
+    {
+      assert (roundTrips (value, 9));
+      assert (roundTrips (value, 17));
+      assert (roundTrips (value, 60));
+    }
+  }
+
+  assert (parse ("3.14159265358979323846264338327950288") ==
+          3.14159265358979323846264338327950288f);
+  assert (parse ("0.1000000000000000055511151231257827021181583404541015625") == 0.1f);
+  assert (parse ("1.000000059604644775390625") == 1.0f);
+  assert (parse ("1.00000005960464477539062500001") == 1.00000011920928955078125f);
+  assert (parse ("123456789012345678901234567890") == 123456789012345678901234567890.0f);
+  assert (parse ("-1.5e-3") == -1.5e-3f);
+  assert (parse ("2E+2") == 200.0f);
+  assert (parse ("1e-50") == 0.0f);
+
+  float value;
+  assert (ImportExport::parseFloat ("1.5x", value) == false);
+  assert (ImportExport::parseFloat ("e5", value) == false);
+}
@@ -0,0 +1,13 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2017 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#ifndef DILAY_TEST_IMPORT_EXPORT
+#define DILAY_TEST_IMPORT_EXPORT
+
+namespace TestImportExport
+{
+  void test ();
+}
+
+#endif
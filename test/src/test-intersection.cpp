@@ -3,10 +3,12 @@
  * Use and redistribute under the terms of the GNU General Public License
  */
 #include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
 #include "intersection.hpp"
 #include "primitive/aabox.hpp"
 #include "primitive/cone.hpp"
 #include "primitive/cylinder.hpp"
+#include "primitive/frustum.hpp"
 #include "primitive/plane.hpp"
 #include "primitive/ray.hpp"
 #include "primitive/sphere.hpp"
@@ -92,5 +94,32 @@ void TestIntersection::test ()
   assert (intersects (cne, glm::vec3 (1.0f, 0.0f, 0.0f)));
   assert (intersects (cne, glm::vec3 (0.5f, 1.0f, 0.0f)));
   assert (intersects (cne, glm::vec3 (0.8f, 0.1f, 0.0f)));
+
+  PrimFrustum frs (glm::mat4x4 (1.0f));
+
+  assert (intersects (frs, PrimAABox (glm::vec3 (0.0f), 0.5f)));
+  assert (intersects (frs, PrimAABox (glm::vec3 (0.0f), 4.0f)));
+  assert (intersects (frs, PrimAABox (glm::vec3 (1.5f, 0.0f, 0.0f), 2.0f)));
+  assert (intersects (frs, PrimAABox (glm::vec3 (2.5f, 0.0f, 0.0f), 2.0f)) == false);
+  assert (intersects (frs, PrimAABox (glm::vec3 (0.0f, 0.0f, -2.5f), 2.0f)) == false);
+
+  // the eye is at (0, 0, 5), the frustum's half width is 5 at the origin
+  const glm::mat4x4 projection = glm::perspective (glm::radians (90.0f), 1.0f, 0.1f, 100.0f);
+  const glm::mat4x4 view =
+    glm::lookAt (glm::vec3 (0.0f, 0.0f, 5.0f), glm::vec3 (0.0f), glm::vec3 (0.0f, 1.0f, 0.0f));
+  PrimFrustum prs (projection * view);
+
+  assert (intersects (prs, PrimAABox (glm::vec3 (0.0f), 1.0f)));
+  assert (intersects (prs, PrimAABox (glm::vec3 (3.0f, -3.0f, -50.0f), 1.0f)));
+  assert (intersects (prs, PrimAABox (glm::vec3 (0.0f, 0.0f, 10.0f), 1.0f)) == false);
+  assert (intersects (prs, PrimAABox (glm::vec3 (0.0f, 0.0f, -200.0f), 1.0f)) == false);
+  assert (intersects (prs, PrimAABox (glm::vec3 (-10.0f, 0.0f, 0.0f), 2.0f)) == false);
+  assert (intersects (prs, PrimAABox (glm::vec3 (10.0f, 0.0f, 0.0f), 2.0f)) == false);
+  assert (intersects (prs, PrimAABox (glm::vec3 (0.0f, 10.0f, 0.0f), 2.0f)) == false);
+  assert (intersects (prs, PrimAABox (glm::vec3 (0.0f, -10.0f, 0.0f), 2.0f)) == false);
+  assert (intersects (prs, PrimAABox (glm::vec3 (-5.0f, 0.0f, 0.0f), 2.0f)));
+  assert (intersects (prs, PrimAABox (glm::vec3 (0.0f, 5.0f, 0.0f), 2.0f)));
+  assert (intersects (prs, PrimAABox (glm::vec3 (0.0f, 0.0f, 5.0f), 1.0f)));
+  assert (intersects (prs, PrimAABox (glm::vec3 (0.0f, 0.0f, -95.0f), 2.0f)));
   unused (t);
 }
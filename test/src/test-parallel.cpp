@@ -0,0 +1,94 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2017 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <mutex>
+#include <set>
+#include <thread>
+#include "parallel.hpp"
+#include "test-parallel.hpp"
+
+namespace
+{
+  constexpr unsigned int numElements = 200;
+
+  struct Progress
+  {
+    std::atomic<unsigned int> numProcessed;
+    std::atomic<bool>         started;
+    std::atomic<bool>         sawOther;
+    std::mutex                mutex;
+    std::set<std::thread::id> threads;
+
+    Progress ()
+      : numProcessed (0)
+      , started (false)
+      , sawOther (false)
+    {
+    }
+  };
+
+  /* Waits until both calls of `forRange` have started one of their ranges, i.e. until they are in
+   * progress at the same time.  Returns false if the other call does not start in time.
+   */
+  bool waitForOther (std::atomic<unsigned int>& numStarted)
+  {
+    const auto timeout = std::chrono::steady_clock::now () + std::chrono::seconds (10);
+
+    numStarted++;
+    while (numStarted < 2)
+    {
+      if (std::chrono::steady_clock::now () > timeout)
+      {
+        return false;
+      }
+      std::this_thread::yield ();
+    }
+    return true;
+  }
+
+  void run (Progress& self, std::atomic<unsigned int>& numStarted)
+  {
+    Parallel::forRange (numElements, 1, [&self, &numStarted](unsigned int begin, unsigned int end) {
+      if (self.started.exchange (true) == false)
+      {
+        self.sawOther = waitForOther (numStarted);
+      }
+      for (unsigned int i = begin; i < end; i++)
+      {
+        std::this_thread::sleep_for (std::chrono::milliseconds (1));
+        {
+          std::lock_guard<std::mutex> lock (self.mutex);
+          self.threads.insert (std::this_thread::get_id ());
+        }
+        self.numProcessed++;
+      }
+    });
+  }
+}
+
+void TestParallel::test ()
+{
+  Progress                  a, b;
+  std::atomic<unsigned int> numStarted (0);
+
+  std::thread threadA ([&a, &numStarted]() { run (a, numStarted); });
+  std::thread threadB ([&b, &numStarted]() { run (b, numStarted); });
+
+  threadA.join ();
+  threadB.join ();
+
+  assert (a.numProcessed == numElements);
+  assert (b.numProcessed == numElements);
+  assert (a.sawOther && b.sawOther);
+
+  // both calls are served by the workers, none of them runs serially
+  if (Parallel::numThreads () > 2)
+  {
+    assert (a.threads.size () > 1);
+    assert (b.threads.size () > 1);
+  }
+}